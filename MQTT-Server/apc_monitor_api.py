@@ -110,9 +110,10 @@ class ApcMonitorApi:
 
             delete_count = self.db.delete_documents({'date': {'$gte': earliest_date}}, self.db.pred_data_coll_name)
             print('deleted {} old forecasts'.format(delete_count))
+            # one request for every forecast step
+            self.db.insert_documents(pred_data, self.db.pred_data_coll_name)
             for preds in pred_data:
-                self.db.insert_document(preds, self.db.pred_data_coll_name)
-                del preds['_id']
+                preds.pop('_id', None)
 
             self.prediction_in_progress = False
         return pred_data
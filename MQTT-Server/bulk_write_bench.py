@@ -0,0 +1,82 @@
+import argparse
+import os
+from contextlib import redirect_stdout
+from datetime import datetime
+from time import perf_counter
+from unittest import mock
+
+# Documents per second written by DataAccess.insert_document() (one insert_one each) and by its BulkWriter, for round
+# documents of fleets of different sizes. Runs on mongomock, or on a mongod with --mongo; only the mongod numbers
+# include the round trip that batching saves.
+#
+#   python bulk_write_bench.py --mongo localhost:27017 --docs 2000 --fleets 10,100,500
+
+
+def open_data_access(mongo: str):
+    """ DataAccess on mongomock, or on the mongod at host:port """
+    if mongo:
+        from data_access import DataAccess
+        host, port = mongo.split(':')
+        return DataAccess(host, int(port), 'apc-iot-bench')
+    import mongomock
+    with mock.patch('data_access.MongoClient', mongomock.MongoClient):
+        from data_access import DataAccess
+        return DataAccess('localhost', 27017, 'apc-iot-bench')
+
+
+def round_document(fleet: int, seq: int) -> dict:
+    """ Document of a round as the collectors store it, with one collector per mote """
+    return {
+        "collectors_info": [{"myName": '{:03d}'.format(mote), "Seq #": seq, "Uptime (sec)": seq * 3600,
+                             "RSSI (dBm)": -70, "ETX": 1.25, "calibration": [500, 500, 500]}
+                            for mote in range(fleet)],
+        "collectors_data": [{"Temperature (C)": 25.3, "Humidity (%RH)": 61.2, "PM25 (ug/m3)": 31, "CO (PPM)": 1.2,
+                             "NO2 (PPM)": 0.08, "O3 (PPB)": 21.5, "Wind Speed (m/s)": 2.5, "Wind Direction": "NE"}
+                            for _ in range(fleet)],
+        "api_weather": ["Clouds"],
+        "api_wind": {"speed": 2.1, "deg": 40},
+        "missing_collectors": [],
+        "date": datetime.now()
+    }
+
+
+def bench(data_logic, fleet: int, docs: int, batch: int) -> float:
+    """ Documents per second, one insert_one each if batch is 0 """
+    collection = 'bench_{}_{}'.format(fleet, batch)
+    documents = [round_document(fleet, seq) for seq in range(docs)]
+    data_logic.cur_db[collection].drop()
+    start = perf_counter()
+    if batch == 0:
+        for document in documents:
+            data_logic.insert_document(document, collection)
+    else:
+        with data_logic.bulk_writer(batch, 60) as writer:
+            for document in documents:
+                writer.insert(document, collection)
+    elapsed = perf_counter() - start
+    data_logic.cur_db[collection].drop()
+    return docs / elapsed
+
+
+def main():
+    parser = argparse.ArgumentParser(description='insert_one against BulkWriter throughput')
+    parser.add_argument('--docs', type=int, default=1000, help='documents written per case')
+    parser.add_argument('--fleets', default='10,100,500', help='motes per round document')
+    parser.add_argument('--batches', default='10,100', help='BulkWriter max_docs')
+    parser.add_argument('--mongo', default='', help='host:port of a mongod, mongomock if not given')
+    args = parser.parse_args()
+    fleets = [int(x) for x in args.fleets.split(',')]
+    batches = [int(x) for x in args.batches.split(',')]
+
+    data_logic = open_data_access(args.mongo)
+    print('motes  ' + ''.join('{:>16}'.format(name) for name in
+                              ['insert_one'] + ['bulk {}'.format(batch) for batch in batches]) + '   (docs/s)')
+    for fleet in fleets:
+        # insert_document() prints every document
+        with open(os.devnull, 'w') as devnull, redirect_stdout(devnull):
+            rates = [bench(data_logic, fleet, args.docs, batch) for batch in [0] + batches]
+        print('{:>5}  '.format(fleet) + ''.join('{:>16.0f}'.format(rate) for rate in rates))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,106 @@
+import unittest
+from collections import defaultdict
+from time import sleep
+from pymongo.errors import AutoReconnect, BulkWriteError
+from data_access import BulkWriter
+
+
+class FakeCollection:
+    """ Records the insert_many calls, rejects documents with a repeated _id as MongoDB does """
+
+    def __init__(self):
+        self.calls = []
+        self.ids = set()
+        self.unreachable = False
+
+    def insert_many(self, documents, ordered=True):
+        if self.unreachable:
+            raise AutoReconnect('connection refused')
+        self.calls.append((len(documents), ordered))
+        errors = []
+        inserted = 0
+        for index, document in enumerate(documents):
+            if document.get('_id') in self.ids:
+                errors.append({'index': index, 'code': 11000, 'errmsg': 'E11000 duplicate key', 'op': document})
+                continue
+            self.ids.add(document.setdefault('_id', len(self.ids) + 1))
+            inserted += 1
+        if errors:
+            raise BulkWriteError({'writeErrors': errors, 'nInserted': inserted})
+        return type('InsertManyResult', (), {'inserted_ids': list(range(inserted))})()
+
+
+class FakeDataAccess:
+    def __init__(self):
+        self.is_connection_active = True
+        self.cur_db = defaultdict(FakeCollection)
+
+
+class BulkWriterTestCase(unittest.TestCase):
+    def setUp(self):
+        self.db = FakeDataAccess()
+        self.errors = []
+        self.writer = None
+
+    def tearDown(self):
+        if self.writer is not None:
+            self.writer.close()
+
+    def open_writer(self, max_docs: int, max_delay: float) -> BulkWriter:
+        self.writer = BulkWriter(self.db, max_docs, max_delay, lambda coll, errors: self.errors.append((coll, errors)))
+        return self.writer
+
+    def test_should_write_full_buffer_in_one_unordered_request(self):
+        writer = self.open_writer(10, 60)
+        for i in range(25):
+            writer.insert({'i': i}, 'apc_data')
+        self.assertEqual(self.db.cur_db['apc_data'].calls, [(10, False), (10, False)])
+        self.assertEqual(writer.inserted, 20)
+
+    def test_should_write_after_max_delay(self):
+        writer = self.open_writer(100, 0.1)
+        writer.insert({'i': 1}, 'apc_data')
+        writer.insert({'i': 2}, 'apc_data')
+        sleep(0.3)
+        self.assertEqual(self.db.cur_db['apc_data'].calls, [(2, False)])
+
+    def test_should_buffer_each_collection_apart(self):
+        writer = self.open_writer(2, 60)
+        writer.insert({'i': 1}, 'apc_data')
+        writer.insert({'i': 2}, 'apc_predictions')
+        self.assertEqual(writer.inserted, 0)
+        writer.insert({'i': 3}, 'apc_data')
+        self.assertEqual(self.db.cur_db['apc_data'].calls, [(2, False)])
+        self.assertEqual(self.db.cur_db['apc_predictions'].calls, [])
+
+    def test_should_write_rest_on_close(self):
+        writer = self.open_writer(100, 60)
+        for i in range(7):
+            writer.insert({'i': i}, 'apc_data')
+        writer.close()
+        self.writer = None
+        self.assertEqual(self.db.cur_db['apc_data'].calls, [(7, False)])
+        self.assertEqual(writer.inserted, 7)
+
+    def test_should_report_rejected_documents_and_keep_the_others(self):
+        writer = self.open_writer(3, 60)
+        writer.insert({'_id': 1}, 'apc_data')
+        writer.insert({'_id': 1}, 'apc_data')
+        writer.insert({'_id': 2}, 'apc_data')
+        self.assertEqual(writer.inserted, 2)
+        self.assertEqual(writer.failed, 1)
+        coll, errors = self.errors[0]
+        self.assertEqual(coll, 'apc_data')
+        self.assertEqual([(e['index'], e['code']) for e in errors], [(1, 11000)])
+
+    def test_should_report_whole_batch_when_server_unreachable(self):
+        writer = self.open_writer(2, 60)
+        self.db.cur_db['apc_data'].unreachable = True
+        writer.insert({'i': 1}, 'apc_data')
+        writer.insert({'i': 2}, 'apc_data')
+        self.assertEqual(writer.failed, 2)
+        self.assertEqual([e['op'] for e in self.errors[0][1]], [{'i': 1}, {'i': 2}])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -1,7 +1,10 @@
+import threading
 from datetime import datetime
+from time import time
 from pymongo import MongoClient, DESCENDING as pymongo_DESCENDING
-from sensor_aggregator import SensorAggregator
-from typing import Union
+from pymongo.errors import BulkWriteError, PyMongoError
+from sensor_pipeline import format_row, normalized_sensor_pipeline, sensor_data_filter
+from typing import Callable, Dict, List, Optional, Union
 
 class DataAccess:
     def __init__(self, address, port: int, db_name: str = ''):
@@ -45,6 +48,28 @@ class DataAccess:
         result = collection.insert_one(document)
         print("Inserted in collection \'{}\' document with id: {}".format(coll_name, result.inserted_id))
 
+    def insert_documents(self, documents: List[dict], coll_name: str) -> int:
+        """ Inserts the documents in one request, a failed document does not stop the others. Returns the number
+        inserted.
+        """
+        if not self.is_connection_active or self.cur_db is None:
+            print("Failed to insert documents: No active database connection.")
+            return 0
+        if not coll_name or not documents:
+            return 0
+        try:
+            result = self.cur_db[coll_name].insert_many(documents, ordered=False)
+        except BulkWriteError as err:
+            print("Failed to insert {} of {} documents in collection \'{}\'."
+                  .format(len(err.details.get('writeErrors', [])), len(documents), coll_name))
+            return err.details.get('nInserted', 0)
+        print("Inserted in collection \'{}\' {} documents.".format(coll_name, len(result.inserted_ids)))
+        return len(result.inserted_ids)
+
+    def bulk_writer(self, max_docs: int = 100, max_delay: float = 1.0,
+                    on_error: Optional[Callable[[str, List[dict]], None]] = None) -> 'BulkWriter':
+        return BulkWriter(self, max_docs, max_delay, on_error)
+
     def get_documents(self, criteria: dict, coll_name: str):
         documents = []
         for document in self.cur_db[coll_name].find(criteria):
@@ -76,230 +101,135 @@ class DataAccess:
         return delete_count.deleted_count
 
 
+class BulkWriter:
+    """ Buffers documents per collection and writes each buffer with one insert_many(ordered=False), once it holds
+    max_docs documents or its oldest document has waited max_delay seconds. close() writes what is left.
+
+    on_error(coll_name, errors) gets the documents that could not be written, one dict per document with its 'op'
+    (the document), 'errmsg' and, for write errors, 'code' and 'index'. Those documents are not retried.
+    """
+
+    def __init__(self, data_access: DataAccess, max_docs: int = 100, max_delay: float = 1.0,
+                 on_error: Optional[Callable[[str, List[dict]], None]] = None):
+        if max_docs < 1 or max_delay <= 0:
+            raise ValueError("A bulk writer needs max_docs of at least 1 and a positive max_delay.")
+        self.data_access = data_access
+        self.max_docs = max_docs
+        self.max_delay = max_delay
+        self.on_error = on_error if on_error is not None else self._print_errors
+        self.inserted = 0
+        self.failed = 0
+        self.flushes = 0
+        self._buffers: Dict[str, List[dict]] = {}
+        self._oldest: Dict[str, float] = {}
+        self._lock = threading.Lock()
+        self._stop = threading.Event()
+        self._thread = threading.Thread(target=self._run, name='bulk-writer', daemon=True)
+        self._thread.start()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+    def insert(self, document: dict, coll_name: str):
+        with self._lock:
+            buffer = self._buffers.setdefault(coll_name, [])
+            if not buffer:
+                self._oldest[coll_name] = time()
+            buffer.append(document)
+            full = len(buffer) >= self.max_docs
+        if full:
+            self.flush(coll_name)
+
+    def flush(self, coll_name: Optional[str] = None) -> int:
+        """ Writes the buffer of coll_name now, or every buffer. Returns the number of documents inserted. """
+        with self._lock:
+            names = [coll_name] if coll_name is not None else list(self._buffers)
+            batches = [(name, self._buffers.pop(name, [])) for name in names]
+        return sum(self._write(name, batch) for name, batch in batches if batch)
+
+    def close(self):
+        self._stop.set()
+        self._thread.join()
+        self.flush()
+
+    def _write(self, coll_name: str, batch: List[dict]) -> int:
+        self.flushes += 1
+        if not self.data_access.is_connection_active or self.data_access.cur_db is None:
+            inserted, errors = 0, [{'op': document, 'errmsg': 'no active database connection'} for document in batch]
+        else:
+            try:
+                inserted = len(self.data_access.cur_db[coll_name].insert_many(batch, ordered=False).inserted_ids)
+                errors = []
+            except BulkWriteError as err:
+                inserted = err.details.get('nInserted', 0)
+                errors = list(err.details.get('writeErrors', []))
+            except PyMongoError as err:
+                # the server could not be reached, nothing of the batch was written
+                inserted, errors = 0, [{'op': document, 'errmsg': str(err)} for document in batch]
+        self.inserted += inserted
+        if errors:
+            self.failed += len(errors)
+            self.on_error(coll_name, errors)
+        return inserted
+
+    def _run(self):
+        while not self._stop.wait(self.max_delay / 2):
+            now = time()
+            with self._lock:
+                due = [name for name, buffer in self._buffers.items()
+                       if buffer and now - self._oldest[name] >= self.max_delay]
+            for name in due:
+                self.flush(name)
+
+    @staticmethod
+    def _print_errors(coll_name: str, errors: List[dict]):
+        print("Failed to insert {} documents in collection \'{}\': {}".format(len(errors), coll_name,
+                                                                              errors[0].get('errmsg')))
+
+
 class ApcDataAccess(DataAccess):
     def __init__(self, address, port: int, db_name: str, mote_data_coll_name: str, pred_data_coll_name: str):
         super().__init__(address, port, db_name)
         self.mote_data_coll_name = mote_data_coll_name
         self.pred_data_coll_name = pred_data_coll_name
 
-    def get_all_sensor_data_normalized(self, columns_sensor: list, columns_external: list, invalid_values: list,
-                                       before_date: datetime, after_date: Union[datetime, None], tolerance: float):
-        filter_column = {'$or': []}
-        filter_column['$or'] \
-            .append({'collectors_data': {'$elemMatch': {'$or': [{key: {}} for key in columns_sensor]}}})
-
-        # make sure at least one valid field exists in document
-        #   sensor data
-        for or_clause in filter_column['$or'][0]['collectors_data']['$elemMatch']['$or']:
-            for key in or_clause.keys():
-                or_clause[key] = {'$exists': True}
-
-        #   external data
-        for column in columns_external:
-            filter_column['$or'].append({column: {'$exists': True}})
-            if column == 'date':
-                # check if dates are provided and specify query restriction, otherwise ignore
-                #       get all data later than the after_date specified
-                if after_date is not None and before_date is None:
-                    filter_column['date'] = {'$gte': after_date}
-                #       get data between the two dates specified
-                elif after_date is not None and before_date is not None:
-                    filter_column['date'] = {'$gte': after_date, '$lte': before_date}
-                #       get all data prior to the before_date specified
-                elif after_date is None and before_date is not None:
-                    filter_column['date'] = {'$lte': before_date}
-
+    def stream_sensor_data_normalized(self, columns_sensor: list, columns_external: list, invalid_values: list,
+                                      before_date: Union[datetime, None], after_date: Union[datetime, None],
+                                      tolerance: float, limit: Optional[int] = None, batch_size: int = 1000):
+        """ Normalized rows of the rounds, averaged by MongoDB and read through a cursor batch_size rows at a time.
+        The latest limit rounds first if limit is given, otherwise in the order they are stored.
+        """
+        filter_column = sensor_data_filter(columns_sensor, columns_external, before_date, after_date)
         print('filter set: ' + str(filter_column))
+        pipeline = normalized_sensor_pipeline(filter_column, columns_sensor, columns_external, invalid_values,
+                                              tolerance, limit)
+        cursor = self.cur_db[self.mote_data_coll_name].aggregate(pipeline, allowDiskUse=True, batchSize=batch_size)
+        with cursor:
+            for row in cursor:
+                yield format_row(row)
 
-        documents = self.get_documents(filter_column, self.mote_data_coll_name)
+    def get_all_sensor_data_normalized(self, columns_sensor: list, columns_external: list, invalid_values: list,
+                                       before_date: datetime, after_date: Union[datetime, None], tolerance: float):
+        documents = list(self.stream_sensor_data_normalized(columns_sensor, columns_external, invalid_values,
+                                                            before_date, after_date, tolerance))
         print('found {} data from collection \'{}\''.format(len(documents), self.mote_data_coll_name))
-
-        # remove unneeded key pairs
-        for document in documents:
-            for key in list(document.keys()):
-                if key == 'collectors_data':
-                    for collector in document['collectors_data']:
-                        for inner_key, inner_value in list(collector.items()):
-                            if inner_key not in columns_sensor \
-                                    or inner_value in invalid_values:
-                                del collector[inner_key]
-
-                elif key not in columns_external:
-                    del document[key]
-
-        # normalize sensor data values
-        for i in range(len(documents)):
-            aggregator = SensorAggregator(documents[i]['collectors_data'], tolerance)
-            aggregator.aggregate()
-            avg_sensor_data = aggregator.average_sensor_data
-
-            # add in the external fields
-            for key in documents[i]:
-                if key in columns_external:
-                    avg_sensor_data[key] = documents[i][key]
-            documents[i] = avg_sensor_data
-
-            # pad empty fields
-            column_list = [*columns_sensor, *columns_external]
-            for column in column_list:
-                if column not in documents[i].keys():
-                    documents[i][column] = ''
-
-            # stringify array fields
-            for key, val in documents[i].items():
-                if isinstance(val, list):
-                    new_val = str(val).replace(',', '&')
-                    # remove non-alphanumeric characters
-                    new_val = ''.join(char for char in new_val if char.isalnum() or char == '&')
-                    documents[i][key] = new_val
-
         return documents
 
     def get_limit_sensor_data_normalized(self, columns_sensor: list, columns_external: list, invalid_values: list,
                                          before_date: datetime, after_date: Union[datetime, None], tolerance: float, limit: int):
-        filter_column = {'$or': []}
-        filter_column['$or'] \
-            .append({'collectors_data': {'$elemMatch': {'$or': [{key: {}} for key in columns_sensor]}}})
-
-        # make sure at least one valid field exists in document
-        #   sensor data
-        for or_clause in filter_column['$or'][0]['collectors_data']['$elemMatch']['$or']:
-            for key in or_clause.keys():
-                or_clause[key] = {'$exists': True}
-
-        #   external data
-        for column in columns_external:
-            filter_column['$or'].append({column: {'$exists': True}})
-            if column == 'date':
-                # check if dates are provided and specify query restriction, otherwise ignore
-                #       get all data later than the after_date specified
-                if after_date is not None and before_date is None:
-                    filter_column['date'] = {'$gte': after_date}
-                #       get data between the two dates specified
-                elif after_date is not None and before_date is not None:
-                    filter_column['date'] = {'$gte': after_date, '$lte': before_date}
-                #       get all data prior to the before_date specified
-                elif after_date is None and before_date is not None:
-                    filter_column['date'] = {'$lte': before_date}
-
-        print('filter set: ' + str(filter_column))
-
-        documents = self.get_first_documents(filter_column, self.mote_data_coll_name, limit)
+        documents = list(self.stream_sensor_data_normalized(columns_sensor, columns_external, invalid_values,
+                                                            before_date, after_date, tolerance, limit))
         print('found {} data from collection \'{}\''.format(len(documents), self.mote_data_coll_name))
-
-        # remove unneeded key pairs
-        for document in documents:
-            for key in list(document.keys()):
-                if key == 'collectors_data':
-                    for collector in document['collectors_data']:
-                        for inner_key, inner_value in list(collector.items()):
-                            if inner_key not in columns_sensor \
-                                    or inner_value in invalid_values:
-                                del collector[inner_key]
-
-                elif key not in columns_external:
-                    del document[key]
-
-        # normalize sensor data values
-        for i in range(len(documents)):
-            aggregator = SensorAggregator(documents[i]['collectors_data'], tolerance)
-            aggregator.aggregate()
-            avg_sensor_data = aggregator.average_sensor_data
-
-            # add in the external fields
-            for key in documents[i]:
-                if key in columns_external:
-                    avg_sensor_data[key] = documents[i][key]
-            documents[i] = avg_sensor_data
-
-            # pad empty fields
-            column_list = [*columns_sensor, *columns_external]
-            for column in column_list:
-                if column not in documents[i].keys():
-                    documents[i][column] = ''
-
-            # stringify array fields
-            for key, val in documents[i].items():
-                if isinstance(val, list):
-                    new_val = str(val).replace(',', '&')
-                    # remove non-alphanumeric characters
-                    new_val = ''.join(char for char in new_val if char.isalnum() or char == '&')
-                    documents[i][key] = new_val
-
         return documents
 
     def get_latest_sensor_data_normalized(self, columns_sensor: list, columns_external: list, invalid_values: list,
                                           before_date: datetime, after_date: Union[datetime, None], tolerance: float):
-        filter_column = {'$or': []}
-        filter_column['$or'] \
-            .append({'collectors_data': {'$elemMatch': {'$or': [{key: {}} for key in columns_sensor]}}})
-
-        # make sure at least one valid field exists in document
-        #   sensor data
-        for or_clause in filter_column['$or'][0]['collectors_data']['$elemMatch']['$or']:
-            for key in or_clause.keys():
-                or_clause[key] = {'$exists': True}
-
-        #   external data
-        for column in columns_external:
-            filter_column['$or'].append({column: {'$exists': True}})
-            if column == 'date':
-                # check if dates are provided and specify query restriction, otherwise ignore
-                #       get all data later than the after_date specified
-                if after_date is not None and before_date is None:
-                    filter_column['date'] = {'$gte': after_date}
-                #       get data between the two dates specified
-                elif after_date is not None and before_date is not None:
-                    filter_column['date'] = {'$gte': after_date, '$lte': before_date}
-                #       get all data prior to the before_date specified
-                elif after_date is None and before_date is not None:
-                    filter_column['date'] = {'$lte': before_date}
-
-        print('filter set: ' + str(filter_column))
-
-        document = self.get_first_document(filter_column, self.mote_data_coll_name)
-
-        if document is None or document == {}:
-            return None
-
-        # remove unneeded key pairs
-        for key in list(document.keys()):
-            if key == 'collectors_data':
-                for collector in document['collectors_data']:
-                    for inner_key, inner_value in list(collector.items()):
-                        if inner_key not in columns_sensor \
-                                or inner_value in invalid_values:
-                            del collector[inner_key]
-
-            elif key not in columns_external:
-                del document[key]
-
-        # normalize sensor data values
-        aggregator = SensorAggregator(document['collectors_data'], tolerance)
-        aggregator.aggregate()
-        avg_sensor_data = aggregator.average_sensor_data
-
-        # add in the external fields
-        for key in document:
-            if key in columns_external:
-                avg_sensor_data[key] = document[key]
-        document = avg_sensor_data
-
-        # pad empty fields
-        column_list = [*columns_sensor, *columns_external]
-        for column in column_list:
-            if column not in document.keys():
-                document[column] = ''
-
-        # stringify array fields
-        for key, val in document.items():
-            if isinstance(val, list):
-                new_val = str(val).replace(',', '&')
-                # remove non-alphanumeric characters
-                new_val = ''.join(char for char in new_val if char.isalnum() or char == '&')
-                document[key] = new_val
-
-        return document
+        documents = list(self.stream_sensor_data_normalized(columns_sensor, columns_external, invalid_values,
+                                                            before_date, after_date, tolerance, 1))
+        return documents[0] if documents else None
 
     def get_mote_info(self, columns_include: list):
         filter_column = {'$or': []}
@@ -1,20 +1,24 @@
 import paho.mqtt.client as mqtt
 from configparser import ConfigParser
 from data_access import DataAccess
-from sensor_msg_parser import SensorMessageParser
-from datetime import datetime
+from round_assembler import RoundAssembler
+from subscriber_pipeline import Pipeline, Many, build_document
+from weather_cache import WeatherCache
 import weather_access
-import json
+import time_sync
+import threading
 from time import time
 
+# seconds between checks for rounds whose grace period is over
+ROUND_POLL_INTERVAL = 5
+
 def main():
     """ MQTT Parameters """
     global SUBSCRIBER_ID, SERVER_ADDRESS, MQTT_PORT, KEEP_ALIVE_TIME, TOP_LEVEL_TOPIC, SUBTOPICS, QOS_LEVEL, \
-        TIMEOUT_DURATION
+        TIMEOUT_DURATION, ROUND_INTERVAL, QUEUE_SIZE
     global DB_NAME, DB_ADDRESS, DB_PORT, DB_MOTEDATA_COLL, DB_PREDICTIONS_COLL
-    global API_KEY, LOCATION_ID
-    global client, dataLogic
-    global state, MAX_STATES, messages, topics_received, timeout_timer
+    global API_KEY, LOCATION_ID, WEATHER_TIMEOUT, WEATHER_TTL
+    global client, dataLogic, writer, rounds, pipeline, weather
 
     config = ConfigParser()
     config.read('config.ini')
@@ -28,6 +32,8 @@ def main():
     SUBTOPICS = [x.strip(' ') for x in SUBTOPICS]  # trim whitespace
     QOS_LEVEL = int(config['mqtt']['qos_level'])
     TIMEOUT_DURATION = int(config['mqtt']['timeout_duration'])
+    ROUND_INTERVAL = int(config['mqtt'].get('round_interval', '3600'))
+    QUEUE_SIZE = int(config['mqtt'].get('queue_size', '16'))
     # mongodb configuration
     DB_NAME = config['mongodb']['db_name']
     DB_ADDRESS = config['mongodb']['db_address']
@@ -38,6 +44,8 @@ def main():
     # weather api configuration
     API_KEY = config['openweathermap']['api_key']
     LOCATION_ID = config['openweathermap']['location_id']
+    WEATHER_TIMEOUT = float(config['openweathermap'].get('timeout', str(weather_access.DEFAULT_TIMEOUT)))
+    WEATHER_TTL = float(config['openweathermap'].get('cache_ttl', '600'))
 
     client = mqtt.Client(SUBSCRIBER_ID, protocol=mqtt.MQTTv31)
     client.on_log = on_log
@@ -46,17 +54,37 @@ def main():
 
     client.connect(SERVER_ADDRESS, MQTT_PORT, KEEP_ALIVE_TIME)
     dataLogic = DataAccess(DB_ADDRESS, int(DB_PORT), DB_NAME)
-
-    state = 0
-    MAX_STATES = len(SUBTOPICS)
-    messages = []
-    topics_received = []
+    # documents are written in batches, after bulk_max_delay seconds at the latest
+    writer = dataLogic.bulk_writer(int(config['mongodb'].get('bulk_max_docs', '100')),
+                                   float(config['mongodb'].get('bulk_max_delay', '1.0')))
+
+    # every round reads the same weather, refreshed in the background
+    weather = WeatherCache(lambda: weather_access.get_weather_with_id(API_KEY, LOCATION_ID, WEATHER_TIMEOUT),
+                           WEATHER_TTL)
+    weather.start()
+
+    # a round is stored once every mote published in it, or TIMEOUT_DURATION after its first publish
+    rounds = RoundAssembler(SUBTOPICS, ROUND_INTERVAL, TIMEOUT_DURATION)
+    # publishes are received here, rounds are parsed, given the weather and stored in threads of their own
+    pipeline = Pipeline([('parse', parse_round), ('enrich', add_weather), ('store', store_document)], QUEUE_SIZE)
+    pipeline.start()
+    stopped = threading.Event()
+    threading.Thread(target=poll_rounds, args=(stopped,), name='round-poll', daemon=True).start()
 
     # Blocking call that processes network traffic, dispatches callbacks and
     # handles reconnecting.
     # Other loop*() functions are available that give a threaded interface and a
     # manual interface.
-    client.loop_forever()
+    try:
+        client.loop_forever()
+    finally:
+        # store the rounds already received
+        stopped.set()
+        pipeline.submit(('flush', time()), None)
+        pipeline.stop()
+        writer.close()
+        weather.stop()
+        print(pipeline.report())
 
 
 # The callback for when the client receives a CONNACK response from the server.
@@ -67,96 +95,80 @@ def on_connect(client, userdata, flags, rc):
     # reconnect then subscriptions will be renewed.
     for subtopic in SUBTOPICS:
         client.subscribe("{}/{}/evt/status/fmt/json".format(TOP_LEVEL_TOPIC, subtopic), QOS_LEVEL)
-        # reset mote timers to synchronize mqtt publication
-        client.publish("{}/{}/cmd/timer-reset/fmt/json".format(TOP_LEVEL_TOPIC, subtopic), "1")
+        # motes synchronize their clocks with us and align their publications themselves
+        client.subscribe("{}/{}/evt/{}/fmt/json".format(TOP_LEVEL_TOPIC, subtopic, time_sync.TIME_REQUEST_EVENT),
+                         QOS_LEVEL)
+
+
+# Answer a mote time request as soon as possible, the mote measures the round trip
+def on_time_request(client, message, recv_time_ms):
+    reply = time_sync.build_time_sync_reply(message.payload, recv_time_ms)
+    if reply is None:
+        print('Warning! Malformed time request on ' + message.topic)
+        return
+    subtopic = message.topic.split('/')[1]
+    client.publish(time_sync.time_sync_topic(TOP_LEVEL_TOPIC, subtopic), reply)
 
 
 # The callback for when a PUBLISH message is received from the server.
+# Runs in paho's network thread: anything slow belongs to the pipeline stages.
 def on_message(client, userdata, message):
+    recv_time_ms = time_sync.epoch_millis()
+    if time_sync.is_time_request(message.topic):
+        on_time_request(client, message, recv_time_ms)
+        return
     print("Received PUBLISH")
-    global state, messages, topics_received, timeout_timer
-    if state == 0:
-        timeout_timer = time()
+    if not pipeline.submit(('publish', time(), message.topic, message.payload)):
+        print('Warning! Pipeline is full, dropping message on ' + message.topic)
+
+
+# lets the parse stage flush the rounds whose grace period is over while no publish arrives
+def poll_rounds(stopped):
+    while not stopped.wait(ROUND_POLL_INTERVAL):
+        pipeline.submit(('poll', time()))
+
+
+# parse stage: adds a publish to its round, returns the documents of the rounds it completes or that are due
+def parse_round(item):
+    kind, recv_time = item[0], item[1]
+    if kind == 'publish':
+        topic, payload = item[2], item[3]
+        # topic format: <top level>/<mote id>/evt/status/fmt/json
+        assembled = rounds.add(topic.split('/')[1], payload, recv_time)
+    elif kind == 'poll':
+        assembled = rounds.poll(recv_time)
     else:
-        cur_time = time() - timeout_timer
-        if cur_time >= TIMEOUT_DURATION:
-            print('Warning! Timeout duration reached in between messages, sending reset timer request to motes.')
-            print('Timeout reached after {} s'.format(cur_time))
-            for subtopic in SUBTOPICS:
-                # reset mote timers to synchronize mqtt publication
-                client.publish("{}/{}/cmd/timer-reset/fmt/json".format(TOP_LEVEL_TOPIC, subtopic), "1")
-            state = 0
-            messages = []
-            topics_received = []
-        else:
-            timeout_timer = time()
-    if state < MAX_STATES - 1:
-        print("Current State: " + str(state))
-        print("TOPIC: " + message.topic)
-        if message.topic not in topics_received:
-            topics_received.append(message.topic)
-            print("Message(Raw): " + str(message.payload))
-            messages.append(message.payload)
-            print("Appended message to message list.")
-        else:
-            print('Warning! Duplicate topic received, ignoring.')
-        state += 1
-
-    elif state == MAX_STATES - 1:
-        print("Current State: " + str(state))
-        print("TOPIC: " + message.topic)
-        if message.topic not in topics_received:
-            print("Message(Raw): " + str(message.payload))
-            messages.append(message.payload)
-            print("Appended message to message list.")
-        else:
-            print('Warning! Duplicate topic received, ignoring.')
-
-        if dataLogic.is_connection_active:
-            document = {}
-            try:
-                parser = SensorMessageParser(messages)
-                parser.parse_data()
-
-                document["collectors_info"] = []
-                document["collectors_data"] = []
-                for msg in parser.sensor_msgs:
-                    document["collectors_info"].append(msg.collector_info)
-                    document["collectors_data"].append(msg.collector_data)
-            except json.JSONDecodeError:
-                print("ERROR - malformed payload data.")
-                return
-
-            # add weather field
-            weather = weather_access.get_weather_with_id(API_KEY, LOCATION_ID)
-            if weather is not None:
-                weather_params = {}
-
-                for key, val in weather.items():
-                    if key == 'weather':
-                        weather_conditions = []
-                        for weather_info in weather['weather']:
-                            weather_conditions.append(weather_info['main'])
-                        weather_params['api_weather'] = weather_conditions
-                    elif key == 'wind':
-                        weather_params['api_wind'] = val
-
-                # merge the api weather data with the current data we have
-                document.update(weather_params)
-            else:
-                print("Unable to access weather API")
-
-            # add the date field
-            document['date'] = datetime.now()
-
-            print("Message(Formatted): " + str(document))
-            dataLogic.insert_document(document, DB_MOTEDATA_COLL)
-        else:
-            print("Database is not active")
-
-        state = 0
-        messages = []
-        topics_received = []
+        assembled = rounds.flush_all()
+    documents = Many()
+    for assembled_round in assembled:
+        document = build_document(assembled_round.messages, assembled_round.key, ROUND_INTERVAL,
+                                  assembled_round.missing)
+        if document is not None:
+            documents.append(document)
+    return documents
+
+
+# enrich stage: adds the cached weather fields, marked stale when the API has not answered for a while
+def add_weather(document):
+    weather_params = weather.fields()
+    if not weather_params:
+        print("Unable to access weather API")
+    elif weather_params['api_weather_stale']:
+        print("Warning! Weather API is unavailable, using weather from " + str(weather_params['api_weather_date']))
+    # merge the api weather data with the current data we have
+    document.update(weather_params)
+    return document
+
+
+# store stage
+def store_document(document):
+    if not dataLogic.is_connection_active:
+        print("Database is not active")
+        return None
+    print("Message(Formatted): " + str(document))
+    writer.insert(document, DB_MOTEDATA_COLL)
+    print(pipeline.report())
+    return document
 
 
 # debug logger
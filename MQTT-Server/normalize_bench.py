@@ -0,0 +1,110 @@
+import argparse
+import os
+import random
+from contextlib import redirect_stdout
+from datetime import datetime, timedelta
+from time import perf_counter
+from typing import Tuple
+from data_access import ApcDataAccess
+from sensor_aggregator import SensorAggregator
+from sensor_pipeline import format_row, sensor_data_filter
+
+# Rows per second of the CSV export, normalized in Python after reading every round document (the former
+# ApcDataAccess path, kept below) and by the aggregation pipeline of ApcDataAccess.stream_sensor_data_normalized(). Fills
+# a collection of synthetic rounds on the mongod first, then checks that both give the same rows.
+#
+#   python normalize_bench.py --mongo localhost:27017 --docs 1000000 --motes 10
+
+COLUMNS_SENSOR = ['Temperature (C)', 'Humidity (%RH)', 'PM25 (ug/m3)', 'CO (PPM)', 'NO2 (PPM)', 'O3 (PPB)',
+                  'Wind Speed (m/s)', 'Wind Direction']
+COLUMNS_EXTERNAL = ['api_weather', 'date']
+INVALID_VALUES = ['', 0, -1]
+TOLERANCE = 10
+
+
+def round_document(rng: random.Random, motes: int, date: datetime) -> dict:
+    """ Round as the subscriber stores it, with some motes missing a reading """
+    data = []
+    for _ in range(motes):
+        reading = {"Temperature (C)": round(rng.uniform(20, 35), 2), "Humidity (%RH)": round(rng.uniform(40, 90), 2),
+                   "PM25 (ug/m3)": rng.randint(5, 80), "CO (PPM)": round(rng.uniform(0, 5), 2),
+                   "NO2 (PPM)": round(rng.uniform(0, 1), 3), "O3 (PPB)": round(rng.uniform(0, 60), 1),
+                   "Wind Speed (m/s)": round(rng.uniform(0, 8), 1), "Wind Direction": rng.choice(['N', 'NE', 'E']),
+                   "Uptime (sec)": rng.randint(0, 10 ** 6)}
+        if rng.random() < 0.1:
+            reading[rng.choice(COLUMNS_SENSOR)] = -1
+        data.append(reading)
+    return {"collectors_info": [{"myName": '{:03d}'.format(mote)} for mote in range(motes)],
+            "collectors_data": data, "api_weather": ["Clouds"], "date": date}
+
+
+def fill(data_logic: ApcDataAccess, docs: int, motes: int):
+    collection = data_logic.cur_db[data_logic.mote_data_coll_name]
+    collection.drop()
+    rng = random.Random(1)
+    start = datetime(2020, 1, 1)
+    for first in range(0, docs, 10000):
+        collection.insert_many([round_document(rng, motes, start + timedelta(hours=i))
+                                for i in range(first, min(first + 10000, docs))], ordered=False)
+
+
+def python_normalized(data_logic: ApcDataAccess) -> list:
+    """ Rows as ApcDataAccess.get_all_sensor_data_normalized() built them before the aggregation pipeline """
+    documents = data_logic.get_documents(sensor_data_filter(COLUMNS_SENSOR, COLUMNS_EXTERNAL, None, None),
+                                         data_logic.mote_data_coll_name)
+    for i, document in enumerate(documents):
+        for collector in document['collectors_data']:
+            for key, value in list(collector.items()):
+                if key not in COLUMNS_SENSOR or value in INVALID_VALUES:
+                    del collector[key]
+        aggregator = SensorAggregator(document['collectors_data'], TOLERANCE)
+        aggregator.aggregate()
+        row = aggregator.average_sensor_data
+        for column in COLUMNS_EXTERNAL:
+            row[column] = document.get(column, '')
+        for column in COLUMNS_SENSOR:
+            row.setdefault(column, '')
+        documents[i] = format_row(row)
+    return documents
+
+
+def rows_per_second(normalize) -> Tuple[float, list]:
+    # the filter and the SensorAggregator warnings are printed
+    with open(os.devnull, 'w') as devnull, redirect_stdout(devnull):
+        start = perf_counter()
+        rows = 0
+        sample = []
+        for row in normalize():
+            rows += 1
+            if len(sample) < 1000:
+                sample.append(row)
+        elapsed = perf_counter() - start
+    return rows / elapsed, sample
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Python against aggregation pipeline sensor normalization')
+    parser.add_argument('--mongo', required=True, help='host:port of a mongod')
+    parser.add_argument('--docs', type=int, default=1000000, help='round documents generated')
+    parser.add_argument('--motes', type=int, default=10, help='collectors per round')
+    parser.add_argument('--keep', action='store_true', help='reuse the documents of the last run')
+    args = parser.parse_args()
+
+    host, port = args.mongo.split(':')
+    data_logic = ApcDataAccess(host, int(port), 'apc-iot-bench', 'apc_data_bench', 'apc_predictions_bench')
+    if not args.keep:
+        fill(data_logic, args.docs, args.motes)
+
+    python_rate, python_rows = rows_per_second(
+        lambda: python_normalized(data_logic))
+    pipeline_rate, pipeline_rows = rows_per_second(
+        lambda: data_logic.stream_sensor_data_normalized(COLUMNS_SENSOR, COLUMNS_EXTERNAL, INVALID_VALUES, None,
+                                                         None, TOLERANCE))
+    print('python    {:>12.0f} rows/s'.format(python_rate))
+    print('pipeline  {:>12.0f} rows/s  ({:.1f}x)'.format(pipeline_rate, pipeline_rate / python_rate))
+    if python_rows != pipeline_rows:
+        print('ERROR - the first {} rows differ'.format(len(python_rows)))
+
+
+if __name__ == '__main__':
+    main()
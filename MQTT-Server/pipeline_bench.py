@@ -0,0 +1,186 @@
+import argparse
+import json
+import os
+import threading
+from contextlib import redirect_stdout
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from time import perf_counter, sleep, time
+from typing import Optional
+from unittest import mock
+from round_assembler import RoundAssembler
+from subscriber_pipeline import Pipeline, Many, build_document, percentile
+from weather_cache import WeatherCache
+import weather_access
+
+# Benchmark of the mqtt-subscriber.py stages, without a broker. Rounds of mote publishes are fed to the receiver the
+# way paho calls on_message(), once through the staged pipeline and once with every stage run inside the callback
+# as before. The weather API is a local stand-in server with a configurable delay and stall rate, read through the
+# weather cache or, with --no-weather-cache, once per round. The database is mongomock, or a local mongod with --mongo.
+#
+#   python pipeline_bench.py --rounds 50 --weather-delay 300 --round-gap 100
+#   python pipeline_bench.py --mongo localhost:27017 --weather-stall 10 --no-weather-cache
+
+SUBTOPICS = ['113', '056', '057']
+ROUND_INTERVAL = 3600
+WEATHER_REPLY = json.dumps({"weather": [{"main": "Clouds"}], "wind": {"speed": 2.1, "deg": 40}}).encode()
+
+
+class WeatherStandIn(BaseHTTPRequestHandler):
+    """ Answers every request like the OpenWeatherMap weather endpoint, after server.delay seconds; server.stall
+    percent of the requests take server.stall_delay instead """
+
+    def do_GET(self):
+        self.server.requests += 1
+        stalled = self.server.stall and self.server.requests % (100 // self.server.stall) == 0
+        sleep(self.server.stall_delay if stalled else self.server.delay)
+        try:
+            self.send_response(200)
+            self.send_header('Content-Type', 'application/json')
+            self.send_header('Content-Length', str(len(WEATHER_REPLY)))
+            self.end_headers()
+            self.wfile.write(WEATHER_REPLY)
+        except ConnectionError:
+            # the client timed out on a stalled request
+            pass
+
+    def log_message(self, fmt, *args):
+        pass
+
+
+def start_weather_server(delay: float, stall: int, stall_delay: float) -> ThreadingHTTPServer:
+    server = ThreadingHTTPServer(('127.0.0.1', 0), WeatherStandIn)
+    server.delay = delay
+    server.stall = stall
+    server.stall_delay = stall_delay
+    server.requests = 0
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    weather_access.API_URL = 'http://127.0.0.1:{}/data/2.5/weather'.format(server.server_address[1])
+    return server
+
+
+def open_data_access(mongo: str):
+    """ DataAccess on mongomock, or on the mongod at host:port """
+    if mongo:
+        from data_access import DataAccess
+        host, port = mongo.split(':')
+        return DataAccess(host, int(port), 'apc-iot-bench')
+    import mongomock
+    with mock.patch('data_access.MongoClient', mongomock.MongoClient):
+        from data_access import DataAccess
+        return DataAccess('localhost', 27017, 'apc-iot-bench')
+
+
+def mote_payload(subtopic: str, seq: int, timestamp: int) -> bytes:
+    return json.dumps({
+        "collector_info": {"myName": subtopic, "Seq #": seq, "Uptime (sec)": seq * ROUND_INTERVAL,
+                           "Timestamp": timestamp, "RSSI (dBm)": -70, "ETX": 1.25},
+        "collector_sensor_data": {"Temperature (C)": 25.3, "Humidity (%RH)": 61.2, "PM25 (ug/m3)": 31,
+                                  "CO (Rs/Ro)": 1.2, "NO2 (Rs/Ro)": 0.8, "O3 (Rs/Ro)": 1.1,
+                                  "Wind Speed (m/s)": 2.5, "Wind Direction": "NE",
+                                  "calibration": [500, 500, 500]}
+    }).encode()
+
+
+def stages(data_logic, collection: str, weather: Optional[WeatherCache], weather_timeout: float):
+    """ parse, enrich and store stages as mqtt-subscriber.py builds them, without weather cache if weather is None """
+    rounds = RoundAssembler(SUBTOPICS, ROUND_INTERVAL, 1200)
+
+    def parse_round(item):
+        topic, payload, recv_time = item
+        return Many(build_document(assembled.messages, assembled.key, ROUND_INTERVAL, assembled.missing)
+                    for assembled in rounds.add(topic.split('/')[1], payload, recv_time))
+
+    def add_weather(document):
+        if weather is not None:
+            document.update(weather.fields())
+        else:
+            reply = weather_access.get_weather_with_id('0', '1729525', weather_timeout)
+            document.update(weather_access.weather_fields(reply))
+        return document
+
+    def store_document(document):
+        data_logic.insert_document(document, collection)
+        return document
+
+    return [('parse', parse_round), ('enrich', add_weather), ('store', store_document)]
+
+
+def run_inline(stage_list, item):
+    """ Runs the stages in the caller, as on_message() did before the pipeline """
+    items = [item]
+    for _, handler in stage_list:
+        outputs = []
+        for stage_item in items:
+            result = handler(stage_item)
+            if result is not None:
+                outputs.extend(result if isinstance(result, Many) else [result])
+        items = outputs
+
+
+def run(mode: str, args, data_logic, weather: Optional[WeatherCache]) -> dict:
+    """ Feeds the rounds, returns the time the receiver was held per publish (seconds) and the total time """
+    stage_list = stages(data_logic, 'bench_' + mode, weather, args.weather_timeout)
+    pipeline = None
+    if mode == 'pipeline':
+        pipeline = Pipeline(stage_list, args.queue_size)
+        pipeline.start()
+    held = []
+    start = perf_counter()
+    for seq in range(args.rounds):
+        timestamp = 1600000000 + seq * ROUND_INTERVAL
+        for subtopic in SUBTOPICS:
+            item = ('apc-iot/{}/evt/status/fmt/json'.format(subtopic), mote_payload(subtopic, seq, timestamp), time())
+            received = perf_counter()
+            if pipeline is not None:
+                pipeline.submit(item, args.submit_timeout)
+            else:
+                run_inline(stage_list, item)
+            held.append(perf_counter() - received)
+        sleep(args.round_gap)
+    if pipeline is not None:
+        pipeline.stop()
+    return {'held': held, 'total': perf_counter() - start, 'pipeline': pipeline}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark of the mqtt-subscriber.py pipeline stages')
+    parser.add_argument('--rounds', type=int, default=50, help='rounds of {} publishes'.format(len(SUBTOPICS)))
+    parser.add_argument('--round-gap', type=float, default=100, help='ms between rounds')
+    parser.add_argument('--weather-delay', type=float, default=300, help='ms the weather stand-in takes to answer')
+    parser.add_argument('--weather-stall', type=int, default=0, help='percent of weather requests that stall')
+    parser.add_argument('--weather-timeout', type=float, default=2, help='weather API timeout (s)')
+    parser.add_argument('--weather-ttl', type=float, default=60, help='weather cache TTL (s)')
+    parser.add_argument('--no-weather-cache', action='store_true', help='call the weather API for every round')
+    parser.add_argument('--queue-size', type=int, default=16)
+    parser.add_argument('--submit-timeout', type=float, default=0.5, help='receiver wait for a full queue (s)')
+    parser.add_argument('--mongo', default='', help='host:port of a mongod, mongomock if not given')
+    args = parser.parse_args()
+    args.round_gap /= 1000
+
+    # stalls outlast the timeout, so the enrich stage gives up on them
+    server = start_weather_server(args.weather_delay / 1000, args.weather_stall, args.weather_timeout + 1)
+    data_logic = open_data_access(args.mongo)
+    weather = None
+    if not args.no_weather_cache:
+        weather = WeatherCache(lambda: weather_access.get_weather_with_id('0', '1729525', args.weather_timeout),
+                               args.weather_ttl)
+        weather.start()
+        weather.wait_ready(args.weather_timeout)
+    # the stages print every publish and document
+    with open(os.devnull, 'w') as devnull, redirect_stdout(devnull):
+        results = {mode: run(mode, args, data_logic, weather) for mode in ('inline', 'pipeline')}
+    if weather is not None:
+        weather.stop()
+    server.shutdown()
+
+    print('mode      publishes receiver held p50/p99/max (ms)      total (s)')
+    for mode, result in results.items():
+        held = result['held']
+        print('{:<9} {:>9} {:>10.2f} {:>8.2f} {:>9.2f} {:>14.2f}'.format(
+            mode, len(held), percentile(held, 50) * 1000, percentile(held, 99) * 1000, max(held) * 1000,
+            result['total']))
+    print(results['pipeline']['pipeline'].report())
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,314 @@
+import os
+import select
+import struct
+import sys
+import termios
+import tty
+from configparser import ConfigParser
+from datetime import datetime
+from time import time
+from typing import Callable, List, Optional
+from sensor_translator import SensorType, SensorTranslator, switch_sensor_type_to_unit, \
+    switch_sensor_type_to_unit_string
+
+# Collector of the binary '!R' records the Rime sink writes to its UART (apc-node-rime/apc-sink-node/sink-records.h).
+# Records of the same collection round are stored as one document, shaped like the documents of mqtt-subscriber.py.
+
+# SLIP special characters (RFC 1055)
+SLIP_END = 0xC0
+SLIP_ESC = 0xDB
+SLIP_ESC_END = 0xDC
+SLIP_ESC_ESC = 0xDD
+
+RECORD_MAGIC = b'!R'
+RECORD_VERSION = 1
+RECORD_HEADER = struct.Struct('<2sB2BhBBB')
+RECORD_VALUE = struct.Struct('<Bi')
+# longest record: header, every sensor type and the CRC
+RECORD_MAX_SIZE = RECORD_HEADER.size + 8 * RECORD_VALUE.size + 2
+
+# sensor types of apc-node-rime/apc-request.h
+TEMPERATURE_T = 5
+HUMIDITY_T = 6
+PM25_T = 7
+CO_T = 8
+CO2_T = 9
+O3_T = 10
+WIND_SPEED_T = 11
+WIND_DRCTN_T = 12
+
+# wind direction bits of apc-request.h, in the order the letters are written
+WIND_DRCTN_BITS = ((0x01, 'N'), (0x04, 'S'), (0x02, 'E'), (0x08, 'W'))
+
+# gas sensors of the Rime sensor node, their readings are Rs/Ro x 1000
+GAS_SENSORS = {
+    CO_T: ("CO", SensorType.MQ7_TYPE),
+    CO2_T: ("CO2", SensorType.MQ135_TYPE),
+    O3_T: ("O3", SensorType.MQ131_TYPE)
+}
+
+# value of a reading the node failed to take, as the IPv6 motes publish it
+INVALID_VALUE = -1
+
+
+def crc16(data: bytes, acc: int = 0) -> int:
+    """ crc16_data() of Contiki's lib/crc16.c """
+    for b in data:
+        acc ^= b
+        acc = ((acc >> 8) | (acc << 8)) & 0xFFFF
+        acc ^= (acc & 0xFF00) << 4 & 0xFFFF
+        acc ^= (acc >> 8) >> 4
+        acc ^= (acc & 0xFF00) >> 5
+    return acc
+
+
+def encode_record(addr: tuple, rssi: int, lqi: int, round_id: int, values: dict) -> bytes:
+    """ SLIP-framed record as the sink writes it, values maps sensor types to raw values """
+    record = RECORD_HEADER.pack(RECORD_MAGIC, RECORD_VERSION, addr[0], addr[1], rssi, lqi, round_id, len(values))
+    for sensor_type in sorted(values):
+        record += RECORD_VALUE.pack(sensor_type, values[sensor_type])
+    record += struct.pack('<H', crc16(record))
+    escaped = record.replace(bytes([SLIP_ESC]), bytes([SLIP_ESC, SLIP_ESC_ESC])) \
+        .replace(bytes([SLIP_END]), bytes([SLIP_ESC, SLIP_ESC_END]))
+    return bytes([SLIP_END]) + escaped + bytes([SLIP_END])
+
+
+def decode_record(frame: bytes) -> Optional[dict]:
+    """ Record of an unescaped frame, None if it is not a valid '!R' record """
+    if len(frame) < RECORD_HEADER.size + 2 or not frame.startswith(RECORD_MAGIC):
+        return None
+    if crc16(frame[:-2]) != struct.unpack_from('<H', frame, len(frame) - 2)[0]:
+        return None
+    magic, version, addr0, addr1, rssi, lqi, round_id, count = RECORD_HEADER.unpack_from(frame)
+    if version != RECORD_VERSION or len(frame) != RECORD_HEADER.size + count * RECORD_VALUE.size + 2:
+        return None
+    values = {}
+    for i in range(count):
+        sensor_type, value = RECORD_VALUE.unpack_from(frame, RECORD_HEADER.size + i * RECORD_VALUE.size)
+        values[sensor_type] = value
+    return {"addr": (addr0, addr1), "rssi": rssi, "lqi": lqi, "round": round_id, "values": values}
+
+
+class RecordDecoder:
+    """ Splits the byte stream of the sink into records, skipping its debug text and damaged frames """
+
+    def __init__(self):
+        self._frame = bytearray()
+        self._escaped = False
+        self._overflow = False
+        self.records = 0
+        self.bad_frames = 0
+
+    def feed(self, data: bytes) -> List[dict]:
+        records = []
+        for b in data:
+            if b == SLIP_END:
+                records += self._end_frame()
+            elif self._overflow:
+                continue
+            elif len(self._frame) > max(RECORD_MAX_SIZE, 1024):
+                # a long line of text, wait for the next frame
+                self._frame.clear()
+                self._overflow = True
+            elif self._escaped:
+                self._frame.append(SLIP_END if b == SLIP_ESC_END else SLIP_ESC if b == SLIP_ESC_ESC else b)
+                self._escaped = False
+            elif b == SLIP_ESC:
+                self._escaped = True
+            else:
+                self._frame.append(b)
+        return records
+
+    def _end_frame(self) -> List[dict]:
+        frame = bytes(self._frame)
+        self._frame.clear()
+        self._escaped = False
+        self._overflow = False
+        if not frame.startswith(RECORD_MAGIC):
+            # text between two records
+            return []
+        record = decode_record(frame)
+        if record is None:
+            self.bad_frames += 1
+            return []
+        self.records += 1
+        return [record]
+
+
+def collector_name(addr: tuple) -> str:
+    return "rime-{}.{}".format(addr[0], addr[1])
+
+
+def translate_gas(sensor_type: SensorType, raw_value: int):
+    translator = SensorTranslator(sensor_type, switch_sensor_type_to_unit(sensor_type))
+    try:
+        translator.set_raw_value(raw_value / 1000)
+    except ValueError:
+        return INVALID_VALUE
+    return round(translator.translate(), 3)
+
+
+def record_to_collector(record: dict) -> (dict, dict):
+    """ collector_info and collector_data of a record, keyed like the IPv6 motes' """
+    values = record["values"]
+    collector_info = {
+        "myName": collector_name(record["addr"]),
+        "Round": record["round"],
+        "RSSI (dBm)": record["rssi"],
+        "LQI": record["lqi"],
+        "calibration": []
+    }
+
+    def scaled(sensor_type, scale):
+        return values[sensor_type] / scale if sensor_type in values else INVALID_VALUE
+
+    collector_data = {
+        "Temperature (°C)": scaled(TEMPERATURE_T, 10),
+        "Humidity (%RH)": scaled(HUMIDITY_T, 10),
+        "PM25 (ug/m3)": values.get(PM25_T, INVALID_VALUE)
+    }
+    for sensor_type, (name, gas_sensor) in GAS_SENSORS.items():
+        key = "{} ({})".format(name, switch_sensor_type_to_unit_string(gas_sensor))
+        collector_data[key] = translate_gas(gas_sensor, values[sensor_type]) if sensor_type in values \
+            else INVALID_VALUE
+    collector_data["Wind Speed (m/s)"] = scaled(WIND_SPEED_T, 100)
+    if WIND_DRCTN_T in values:
+        collector_data["Wind Direction"] = "".join(letter for bit, letter in WIND_DRCTN_BITS
+                                                   if values[WIND_DRCTN_T] & bit)
+    else:
+        collector_data["Wind Direction"] = INVALID_VALUE
+    return collector_info, collector_data
+
+
+class RimeCollector:
+    """ Groups the records of a sink round into one document and stores it
+
+    A round is stored when a record of another round arrives, or when no record has arrived for round_timeout
+    seconds. store gets every document, get_weather returns the weather fields to add to it (WeatherCache.fields()),
+    empty if there are none.
+    """
+
+    def __init__(self, store: Callable[[dict], None], get_weather: Callable[[], dict] = dict,
+                 round_timeout: float = 10.0, clock: Callable[[], float] = time):
+        self.decoder = RecordDecoder()
+        self._store = store
+        self._get_weather = get_weather
+        self._round_timeout = round_timeout
+        self._clock = clock
+        self._round = None
+        self._collectors = {}
+        self._last_record = 0.0
+        self.documents = 0
+
+    def feed(self, data: bytes):
+        for record in self.decoder.feed(data):
+            self.add_record(record)
+
+    def add_record(self, record: dict):
+        if self._round is not None and record["round"] != self._round:
+            self.flush()
+        self._round = record["round"]
+        # a node answers once per round, a repeated record replaces the first one
+        self._collectors[record["addr"]] = record_to_collector(record)
+        self._last_record = self._clock()
+
+    def poll(self):
+        """ Stores the current round if it has been quiet for round_timeout """
+        if self._collectors and self._clock() - self._last_record >= self._round_timeout:
+            self.flush()
+
+    def flush(self):
+        if not self._collectors:
+            return
+        document = {
+            "collectors_info": [info for info, _ in self._collectors.values()],
+            "collectors_data": [data for _, data in self._collectors.values()],
+            "sink_round": self._round
+        }
+        weather = self._get_weather()
+        if not weather:
+            print("Unable to access weather API")
+        elif weather.get('api_weather_stale'):
+            print("Warning! Weather API is unavailable, using weather from " + str(weather['api_weather_date']))
+        document.update(weather)
+        document['date'] = datetime.now()
+        self._collectors = {}
+        self._round = None
+        self._store(document)
+        self.documents += 1
+
+
+def open_serial(port: str, baud_rate: int) -> int:
+    """ Raw, non-blocking file descriptor of the serial port (or pty) """
+    fd = os.open(port, os.O_RDONLY | os.O_NOCTTY | os.O_NONBLOCK)
+    tty.setraw(fd)
+    speed = getattr(termios, 'B{}'.format(baud_rate), None)
+    if speed is None:
+        os.close(fd)
+        raise ValueError("Unsupported baud rate {}".format(baud_rate))
+    attrs = termios.tcgetattr(fd)
+    attrs[4] = attrs[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+def run(fd: int, collector: RimeCollector, poll_interval: float = 1.0, stop: Callable[[], bool] = lambda: False):
+    """ Feeds the collector from fd until it closes or stop() returns True """
+    while not stop():
+        readable, _, _ = select.select([fd], [], [], poll_interval)
+        if readable:
+            try:
+                data = os.read(fd, 512)
+            except OSError:
+                # the other end of a pty has closed
+                data = b''
+            if not data:
+                break
+            collector.feed(data)
+        collector.poll()
+    collector.flush()
+
+
+def main():
+    from data_access import DataAccess
+    from weather_cache import WeatherCache
+    import weather_access
+
+    config = ConfigParser()
+    config.read('config.ini')
+    serial_port = sys.argv[1] if len(sys.argv) > 1 else config['rime']['serial_port']
+    baud_rate = int(config['rime'].get('baud_rate', '115200'))
+    round_timeout = float(config['rime'].get('round_timeout', '10'))
+    db_motedata_coll = config['mongodb']['db_motedata_collection']
+    api_key = config['openweathermap']['api_key']
+    location_id = config['openweathermap']['location_id']
+
+    data_logic = DataAccess(config['mongodb']['db_address'], int(config['mongodb']['db_port']),
+                            config['mongodb']['db_name'])
+    writer = data_logic.bulk_writer(int(config['mongodb'].get('bulk_max_docs', '100')),
+                                    float(config['mongodb'].get('bulk_max_delay', '1.0')))
+
+    def store(document):
+        print("Message(Formatted): " + str(document))
+        writer.insert(document, db_motedata_coll)
+
+    # the weather is refreshed in the background, a round is stored without waiting for the API
+    weather = WeatherCache(lambda: weather_access.get_weather_with_id(api_key, location_id),
+                           float(config['openweathermap'].get('cache_ttl', '600')))
+    weather.start()
+    collector = RimeCollector(store, weather.fields, round_timeout)
+    fd = open_serial(serial_port, baud_rate)
+    try:
+        run(fd, collector)
+    except KeyboardInterrupt:
+        collector.flush()
+    finally:
+        os.close(fd)
+        writer.close()
+        weather.stop()
+    print("{} records, {} damaged frames, {} documents".format(collector.decoder.records,
+                                                                collector.decoder.bad_frames, collector.documents))
+
+
+if __name__ == "__main__":
+    main()
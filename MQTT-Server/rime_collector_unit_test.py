@@ -0,0 +1,108 @@
+import os
+import pty
+import threading
+import unittest
+from datetime import datetime
+import rime_collector
+from rime_collector import RimeCollector, RecordDecoder, encode_record, TEMPERATURE_T, HUMIDITY_T, PM25_T, CO_T, \
+    CO2_T, O3_T, WIND_SPEED_T, WIND_DRCTN_T
+
+ALL_VALUES = {
+    TEMPERATURE_T: -45,
+    HUMIDITY_T: 601,
+    PM25_T: 12,
+    CO_T: 1500,
+    CO2_T: 0xC0,  # SLIP END in the record
+    O3_T: 2250,
+    WIND_SPEED_T: 150,
+    WIND_DRCTN_T: 0x01 | 0x02
+}
+
+
+class RimeCollectorTestCase(unittest.TestCase):
+    def test_should_match_contiki_crc16(self):
+        self.assertEqual(rime_collector.crc16(b'123456789'), 0x2189)
+
+    def test_should_decode_record_with_escaped_bytes(self):
+        frame = encode_record((2, 0), -70, 105, 7, ALL_VALUES)
+        self.assertIn(bytes([0xDB, 0xDC]), frame)
+        records = RecordDecoder().feed(frame)
+        self.assertEqual(records, [{"addr": (2, 0), "rssi": -70, "lqi": 105, "round": 7, "values": ALL_VALUES}])
+
+    def test_should_skip_text_and_damaged_frames(self):
+        good = encode_record((3, 0), -80, 90, 1, {PM25_T: 20})
+        damaged = bytearray(encode_record((4, 0), -80, 90, 1, {PM25_T: 20}))
+        damaged[-3] ^= 0xFF
+        decoder = RecordDecoder()
+        records = decoder.feed(b'ROUND 1: 2/2 nodes replied\n' + bytes(damaged) + b'text\n' + good[:5])
+        records += decoder.feed(good[5:] + b'more text')
+        self.assertEqual([r["addr"] for r in records], [(3, 0)])
+        self.assertEqual(decoder.bad_frames, 1)
+
+    def test_should_store_collectors_like_mqtt_subscriber(self):
+        record = RecordDecoder().feed(encode_record((2, 0), -70, 105, 7, {PM25_T: 12, WIND_DRCTN_T: 0x04 | 0x08}))[0]
+        info, data = rime_collector.record_to_collector(record)
+        self.assertEqual(info["myName"], "rime-2.0")
+        self.assertEqual(info["RSSI (dBm)"], -70)
+        self.assertEqual(data["PM25 (ug/m3)"], 12)
+        self.assertEqual(data["Wind Direction"], "SW")
+        self.assertEqual(data["Temperature (°C)"], -1)
+        self.assertEqual(data["CO (PPM)"], -1)
+
+    def test_should_store_one_document_per_round(self):
+        documents = []
+        weather = {"api_weather": ["Clouds"], "api_wind": {"speed": 2.1}, "api_weather_date": datetime(2021, 1, 10),
+                   "api_weather_stale": True}
+        collector = RimeCollector(documents.append, lambda: weather)
+        collector.feed(encode_record((2, 0), -70, 105, 1, ALL_VALUES))
+        collector.feed(encode_record((3, 0), -75, 100, 1, {PM25_T: 20}))
+        # a re-polled node replying twice only counts once
+        collector.feed(encode_record((3, 0), -74, 101, 1, {PM25_T: 21}))
+        self.assertEqual(documents, [])
+        collector.feed(encode_record((2, 0), -70, 105, 2, ALL_VALUES))
+        self.assertEqual(len(documents), 1)
+        document = documents[0]
+        self.assertEqual(document["sink_round"], 1)
+        self.assertEqual([info["myName"] for info in document["collectors_info"]], ["rime-2.0", "rime-3.0"])
+        self.assertEqual(document["collectors_data"][1]["PM25 (ug/m3)"], 21)
+        self.assertEqual(document["api_weather"], ["Clouds"])
+        self.assertEqual(document["api_wind"], {"speed": 2.1})
+        self.assertTrue(document["api_weather_stale"])
+        self.assertIn("date", document)
+
+    def test_should_store_quiet_round_after_timeout(self):
+        now = [0.0]
+        documents = []
+        collector = RimeCollector(documents.append, round_timeout=10, clock=lambda: now[0])
+        collector.feed(encode_record((2, 0), -70, 105, 1, ALL_VALUES))
+        now[0] = 9.0
+        collector.poll()
+        self.assertEqual(documents, [])
+        now[0] = 10.0
+        collector.poll()
+        self.assertEqual(len(documents), 1)
+
+    def test_should_collect_from_serial_port(self):
+        master, slave = pty.openpty()
+        port = os.ttyname(slave)
+        documents = []
+        collector = RimeCollector(documents.append)
+        fd = rime_collector.open_serial(port, 115200)
+        reader = threading.Thread(target=rime_collector.run,
+                                  args=(fd, collector, 0.05, lambda: collector.decoder.records >= 6))
+        reader.start()
+        # the sink's debug text and records share the line
+        for round_id in (1, 2, 3):
+            os.write(master, b'BC - DATA_REQUEST sent for round %d (0 nodes re-polled).\n' % round_id)
+            for addr in ((2, 0), (3, 0)):
+                os.write(master, encode_record(addr, -70, 105, round_id, ALL_VALUES))
+        reader.join(5)
+        self.assertFalse(reader.is_alive())
+        os.close(fd)
+        os.close(slave)
+        os.close(master)
+        self.assertEqual(collector.decoder.records, 6)
+        # the last round is stored when the collector stops
+        self.assertEqual([document["sink_round"] for document in documents], [1, 2, 3])
+        self.assertEqual(len(documents[0]["collectors_info"]), 2)
+        self.assertEqual(documents[0]["collectors_data"][0]["Wind Direction"], "NE")
@@ -0,0 +1,144 @@
+import json
+from collections import OrderedDict, namedtuple
+from typing import Dict, List, Optional
+
+# Groups mote publishes into collection rounds for mqtt-subscriber.py. A publish goes to the round of its collection
+# time, whatever the order the publishes arrive in:
+#   - the "Timestamp" of synchronized motes (time_sync.py),
+#   - otherwise the mote's boot time, estimated from its "Uptime (sec)", plus that uptime,
+#   - otherwise the time the publish was received.
+# Each mote has a watermark (last "Seq #" and uptime) that drops repeated publishes. A round is complete once every
+# mote has published in it, or it is flushed after a grace period with the motes that did not publish listed as
+# missing. A publish of a round already flushed is dropped as late.
+
+# flushed round keys remembered to recognize late publishes
+FLUSHED_HISTORY = 64
+
+# round handed out by RoundAssembler: payloads in mote order, and the motes that did not publish in it
+AssembledRound = namedtuple('AssembledRound', ['key', 'messages', 'missing'])
+
+
+class _Watermark:
+    def __init__(self):
+        self.seq = None
+        self.uptime = None
+        # earliest epoch time the mote can have booted at, from the uptimes it published
+        self.boot = None
+
+
+class _Round:
+    def __init__(self, opened: float):
+        self.opened = opened
+        self.payloads = {}
+
+
+class RoundAssembler:
+    """ Adding a publish and flushing take constant time per publish, whatever the number of motes """
+
+    def __init__(self, motes: List[str], round_interval: int, grace: float):
+        if not motes or round_interval <= 0 or grace < 0:
+            raise ValueError("The round assembler needs motes, a positive round interval and a grace period.")
+        self.motes = list(motes)
+        self.round_interval = round_interval
+        self.grace = grace
+        self._marks: Dict[str, _Watermark] = {mote: _Watermark() for mote in self.motes}
+        # open rounds in the order they were opened, which is also the order their grace periods end in
+        self._open: Dict[int, _Round] = OrderedDict()
+        self._flushed: Dict[int, None] = OrderedDict()
+        self.complete = 0
+        self.incomplete = 0
+        self.duplicates = 0
+        self.late = 0
+
+    def add(self, mote: str, payload, now: float) -> List[AssembledRound]:
+        """ Adds a publish of mote received at now (epoch seconds). Returns the rounds it completes and the rounds
+        whose grace period is over.
+        """
+        rounds = self.poll(now)
+        if mote not in self._marks:
+            print('Warning! Publish of unknown mote {}, ignoring.'.format(mote))
+            return rounds
+        try:
+            info = json.loads(payload)['collector_info']
+        except (ValueError, KeyError, TypeError):
+            print('ERROR - malformed payload from mote {}.'.format(mote))
+            return rounds
+        key = self._round_key(mote, info, now)
+        if key is None:
+            self.duplicates += 1
+            print('Warning! Repeated publish of mote {}, ignoring.'.format(mote))
+            return rounds
+        if key in self._flushed:
+            self.late += 1
+            print('Warning! Publish of mote {} for round {} arrived after the round was stored.'.format(mote, key))
+            return rounds
+        current = self._open.get(key)
+        if current is None:
+            current = self._open[key] = _Round(now)
+        if mote in current.payloads:
+            self.duplicates += 1
+            print('Warning! Mote {} already published in round {}, ignoring.'.format(mote, key))
+            return rounds
+        current.payloads[mote] = payload
+        if len(current.payloads) == len(self.motes):
+            rounds.append(self._flush(key))
+        return rounds
+
+    def poll(self, now: float) -> List[AssembledRound]:
+        """ Flushes the open rounds whose grace period is over at now """
+        rounds = []
+        while self._open:
+            key, oldest = next(iter(self._open.items()))
+            if now - oldest.opened < self.grace:
+                break
+            rounds.append(self._flush(key))
+        return rounds
+
+    def flush_all(self) -> List[AssembledRound]:
+        return [self._flush(key) for key in list(self._open)]
+
+    def _flush(self, key: int) -> AssembledRound:
+        flushed = self._open.pop(key)
+        self._flushed[key] = None
+        if len(self._flushed) > FLUSHED_HISTORY:
+            self._flushed.popitem(last=False)
+        missing = [mote for mote in self.motes if mote not in flushed.payloads]
+        if missing:
+            self.incomplete += 1
+            print('Warning! Round {} is incomplete, missing motes: {}'.format(key, ', '.join(missing)))
+        else:
+            self.complete += 1
+        return AssembledRound(key, [flushed.payloads[mote] for mote in self.motes if mote in flushed.payloads],
+                              missing)
+
+    def _round_key(self, mote: str, info: dict, now: float) -> Optional[int]:
+        """ Round of a publish, None if the mote published it before """
+        mark = self._marks[mote]
+        seq = _number(info.get('Seq #'))
+        uptime = _number(info.get('Uptime (sec)'))
+        if seq is not None and mark.seq is not None:
+            rebooted = seq < mark.seq and (uptime is None or mark.uptime is None or uptime < mark.uptime)
+            if rebooted:
+                print('Mote {} restarted (Seq # {} after {}).'.format(mote, seq, mark.seq))
+                mark.boot = None
+            elif seq <= mark.seq:
+                return None
+        mark.seq = seq
+        mark.uptime = uptime
+
+        timestamp = _number(info.get('Timestamp'))
+        if timestamp is not None and timestamp > 0:
+            return int(timestamp // self.round_interval)
+        if uptime is not None:
+            # the publish with the shortest delay gives the best boot time estimate
+            boot = now - uptime
+            mark.boot = boot if mark.boot is None else min(mark.boot, boot)
+            return int((mark.boot + uptime) // self.round_interval)
+        return int(now // self.round_interval)
+
+
+def _number(value) -> Optional[float]:
+    try:
+        return None if value is None else float(value)
+    except (TypeError, ValueError):
+        return None
@@ -0,0 +1,106 @@
+import json
+import random
+import unittest
+from time import perf_counter
+from round_assembler import RoundAssembler
+
+MOTES = ['113', '056', '057']
+
+
+def publish(mote: str, seq: int, uptime: int, timestamp: int = 0) -> bytes:
+    return json.dumps({"collector_info": {"myName": mote, "Seq #": seq, "Uptime (sec)": uptime,
+                                          "Timestamp": timestamp},
+                       "collector_sensor_data": {"calibration": []}}).encode()
+
+
+class RoundAssemblerTestCase(unittest.TestCase):
+    def test_should_complete_round_when_every_mote_published(self):
+        rounds = RoundAssembler(MOTES, 3600, 1200)
+        self.assertEqual(rounds.add('056', publish('056', 1, 100, 7210), 7211), [])
+        self.assertEqual(rounds.add('113', publish('113', 1, 100, 7200), 7212), [])
+        completed = rounds.add('057', publish('057', 1, 100, 7205), 7213)
+        self.assertEqual(len(completed), 1)
+        self.assertEqual(completed[0].key, 2)
+        self.assertEqual(completed[0].missing, [])
+        # payloads in mote order, not arrival order
+        self.assertEqual([json.loads(m)['collector_info']['myName'] for m in completed[0].messages], MOTES)
+
+    def test_should_keep_interleaved_rounds_apart(self):
+        # a late publish of round 2 arrives after round 3 started, within the grace period
+        rounds = RoundAssembler(MOTES, 3600, 4000)
+        rounds.add('113', publish('113', 1, 100, 7200), 7201)
+        rounds.add('056', publish('056', 1, 100, 7200), 7202)
+        rounds.add('113', publish('113', 2, 3700, 10800), 10801)
+        completed = rounds.add('057', publish('057', 1, 100, 7200), 10802)
+        self.assertEqual([(c.key, c.missing) for c in completed], [(2, [])])
+        rounds.add('056', publish('056', 2, 3700, 10800), 10803)
+        completed = rounds.add('057', publish('057', 2, 3700, 10800), 10804)
+        self.assertEqual([(c.key, c.missing) for c in completed], [(3, [])])
+
+    def test_should_drop_repeated_publish(self):
+        rounds = RoundAssembler(MOTES, 3600, 1200)
+        rounds.add('113', publish('113', 1, 100, 7200), 7201)
+        self.assertEqual(rounds.add('113', publish('113', 1, 100, 7200), 7202), [])
+        self.assertEqual(rounds.duplicates, 1)
+        rounds.add('056', publish('056', 1, 100, 7200), 7203)
+        completed = rounds.add('057', publish('057', 1, 100, 7200), 7204)
+        self.assertEqual(len(completed[0].messages), 3)
+
+    def test_should_flush_incomplete_round_after_grace_period(self):
+        rounds = RoundAssembler(MOTES, 3600, 600)
+        rounds.add('113', publish('113', 1, 100, 7200), 7201)
+        rounds.add('057', publish('057', 1, 100, 7200), 7300)
+        self.assertEqual(rounds.poll(7700), [])
+        flushed = rounds.poll(7801)
+        self.assertEqual([(c.key, c.missing, len(c.messages)) for c in flushed], [(2, ['056'], 2)])
+        self.assertEqual(rounds.incomplete, 1)
+
+    def test_should_drop_publish_for_flushed_round(self):
+        rounds = RoundAssembler(MOTES, 3600, 600)
+        rounds.add('113', publish('113', 1, 100, 7200), 7201)
+        rounds.poll(7801)
+        self.assertEqual(rounds.add('056', publish('056', 1, 100, 7200), 7802), [])
+        self.assertEqual(rounds.late, 1)
+
+    def test_should_group_unsynchronized_motes_by_uptime(self):
+        # no timestamps: the boot time estimate absorbs the delivery delay of each publish
+        rounds = RoundAssembler(MOTES, 3600, 1200)
+        booted = {'113': 1000, '056': 1500, '057': 2000}
+        for mote in MOTES:
+            rounds.add(mote, publish(mote, 1, 7300 - booted[mote]), 7300)
+        completed = []
+        for mote, delay in zip(MOTES, (5, 400, 30)):
+            completed += rounds.add(mote, publish(mote, 2, 10900 - booted[mote]), 10900 + delay)
+        self.assertEqual([(c.key, c.missing) for c in completed], [(3, [])])
+
+    def test_should_accept_publishes_after_mote_restart(self):
+        rounds = RoundAssembler(['113'], 3600, 1200)
+        self.assertEqual(len(rounds.add('113', publish('113', 5, 20000, 7200), 7201)), 1)
+        # Seq # and uptime start over
+        self.assertEqual(len(rounds.add('113', publish('113', 1, 30, 10800), 10801)), 1)
+        self.assertEqual(rounds.duplicates, 0)
+
+    def test_should_ignore_unknown_mote_and_malformed_publish(self):
+        rounds = RoundAssembler(MOTES, 3600, 1200)
+        self.assertEqual(rounds.add('999', publish('999', 1, 100, 7200), 7201), [])
+        self.assertEqual(rounds.add('113', b'not json', 7201), [])
+
+    def test_should_assemble_hundreds_of_motes(self):
+        motes = ['{:03d}'.format(i) for i in range(500)]
+        rounds = RoundAssembler(motes, 60, 30)
+        order = list(motes)
+        completed = []
+        start = perf_counter()
+        for seq in range(1, 21):
+            random.Random(seq).shuffle(order)
+            for mote in order:
+                completed += rounds.add(mote, publish(mote, seq, seq * 60, 60000 + seq * 60), 60000 + seq * 60 + 1)
+        elapsed = perf_counter() - start
+        self.assertEqual(len(completed), 20)
+        self.assertTrue(all(not c.missing and len(c.messages) == 500 for c in completed))
+        # constant time per publish, well under a millisecond each
+        self.assertLess(elapsed / (20 * 500), 0.001)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,94 @@
+from datetime import datetime
+from typing import Dict, List, Optional, Union
+
+# MongoDB aggregation pipeline that normalizes the sensor data of the stored rounds server-side: it keeps the wanted
+# columns, averages the readings of the collectors of each round with the tolerance rule of SensorAggregator and pads
+# the missing columns with ''. Only the final columns come back, through a cursor. The collectors are folded with
+# $reduce within each document rather than $unwind/$group, because the tolerance rule depends on the order of the
+# collectors. Needs MongoDB 3.4 or later; sensor column names must not contain '.' or start with '$'.
+
+NUMBER_TYPES = ['double', 'int', 'long', 'decimal']
+
+
+def sensor_data_filter(columns_sensor: list, columns_external: list, before_date: Optional[datetime],
+                       after_date: Optional[datetime]) -> dict:
+    """ Rounds with at least one of the wanted columns, within the dates if given """
+    filter_column = {'$or': [{'collectors_data': {'$elemMatch': {'$or': [{key: {'$exists': True}}
+                                                                         for key in columns_sensor]}}}]}
+    for column in columns_external:
+        filter_column['$or'].append({column: {'$exists': True}})
+    if 'date' in columns_external:
+        if after_date is not None and before_date is None:
+            filter_column['date'] = {'$gte': after_date}
+        elif after_date is not None and before_date is not None:
+            filter_column['date'] = {'$gte': after_date, '$lte': before_date}
+        elif after_date is None and before_date is not None:
+            filter_column['date'] = {'$lte': before_date}
+    return filter_column
+
+
+def _is_number(expr) -> dict:
+    return {'$in': [{'$type': expr}, NUMBER_TYPES]}
+
+
+def _average(column: str, invalid_values: list, tolerance: float) -> dict:
+    """ SensorAggregator.aggregate() for one column: the value of a single collector as is, otherwise the average of
+    the numbers not more than tolerance below the running average, or the first value if it is not a number; '' if there
+    is none
+    """
+    values = {'$map': {'input': '$collectors_data', 'as': 'c', 'in': '$$c.' + column}}
+    # readings removed before aggregating
+    invalid = {'$or': [{'$eq': ['$$v', None]}, {'$in': ['$$v', invalid_values]}]}
+    skipped = {'$or': [invalid, {'$eq': ['$$v', '']}, {'$eq': ['$$v', -1]}]}
+    seen = {'$or': [{'$gt': ['$$a.n', 0]}, {'$ne': ['$$a.t', None]}]}
+    fold = {'$reduce': {
+        'input': values,
+        'initialValue': {'s': 0, 'n': 0, 't': None},
+        'in': {'$let': {'vars': {'v': '$$this', 'a': '$$value'}, 'in': {'$switch': {'branches': [
+            {'case': skipped, 'then': '$$a'},
+            # the first value of the column decides whether it is averaged
+            {'case': {'$and': [_is_number('$$v'), {'$not': [seen]}]}, 'then': {'s': '$$v', 'n': 1, 't': None}},
+            {'case': {'$not': [seen]}, 'then': {'s': 0, 'n': 0, 't': '$$v'}},
+            {'case': {'$and': [_is_number('$$v'), {'$gt': ['$$a.n', 0]},
+                               {'$lte': [{'$subtract': [{'$divide': ['$$a.s', '$$a.n']}, '$$v']}, tolerance]}]},
+             'then': {'s': {'$add': ['$$a.s', '$$v']}, 'n': {'$add': ['$$a.n', 1]}, 't': None}}],
+            'default': '$$a'}}}}
+    }}
+    single = {'$let': {'vars': {'v': {'$arrayElemAt': [values, 0]}},
+                       'in': {'$cond': [invalid, '', '$$v']}}}
+    return {'$cond': [
+        {'$eq': [{'$size': {'$ifNull': ['$collectors_data', []]}}, 1]},
+        single,
+        {'$let': {'vars': {'r': fold}, 'in': {'$cond': [
+            {'$gt': ['$$r.n', 0]}, {'$divide': ['$$r.s', '$$r.n']}, {'$ifNull': ['$$r.t', '']}]}}}]}
+
+
+def normalized_sensor_pipeline(match: dict, columns_sensor: list, columns_external: list, invalid_values: list,
+                               tolerance: float, limit: Optional[int] = None) -> List[dict]:
+    """ Pipeline of the normalized rows of the rounds that match, the latest limit rounds first if limit is given """
+    for column in columns_sensor:
+        if '.' in column or column.startswith('$'):
+            raise ValueError("Sensor column '{}' cannot be read by the aggregation pipeline.".format(column))
+    pipeline = [{'$match': match}]
+    if limit is not None:
+        pipeline.append({'$sort': {'date': -1}})
+        # 0 is no limit, as for find()
+        if limit > 0:
+            pipeline.append({'$limit': limit})
+    project: Dict[str, Union[int, dict]] = {'_id': 0}
+    for column in columns_sensor:
+        project[column] = _average(column, invalid_values, tolerance)
+    for column in columns_external:
+        project[column] = {'$ifNull': ['$' + column, '']}
+    pipeline.append({'$project': project})
+    return pipeline
+
+
+def format_row(row: dict) -> dict:
+    """ Lists as the CSV converter writes them, e.g. ['Clouds', 'Light Rain'] -> 'Clouds&LightRain' """
+    for key, val in row.items():
+        if isinstance(val, list):
+            new_val = str(val).replace(',', '&')
+            # remove non-alphanumeric characters
+            row[key] = ''.join(char for char in new_val if char.isalnum() or char == '&')
+    return row
@@ -0,0 +1,87 @@
+import os
+import random
+import unittest
+from datetime import datetime
+from sensor_aggregator import SensorAggregator
+from sensor_pipeline import format_row, normalized_sensor_pipeline, sensor_data_filter
+
+COLUMNS_SENSOR = ['Temperature (C)', 'PM25 (ug/m3)', 'Wind Direction']
+COLUMNS_EXTERNAL = ['api_weather', 'date']
+INVALID_VALUES = ['', 0]
+
+# host:port of a mongod to run the pipeline on, the tests that need one are skipped otherwise
+MONGO = os.environ.get('APC_TEST_MONGO', '')
+
+
+def python_row(document: dict, tolerance: float) -> dict:
+    """ Row as the former Python path built it """
+    collectors = [{key: value for key, value in collector.items()
+                   if key in COLUMNS_SENSOR and value not in INVALID_VALUES}
+                  for collector in document['collectors_data']]
+    aggregator = SensorAggregator(collectors, tolerance)
+    aggregator.aggregate()
+    row = aggregator.average_sensor_data
+    for column in COLUMNS_EXTERNAL:
+        row[column] = document.get(column, '')
+    for column in COLUMNS_SENSOR:
+        row.setdefault(column, '')
+    return format_row(row)
+
+
+class SensorPipelineTestCase(unittest.TestCase):
+    def test_should_restrict_filter_to_dates(self):
+        after = datetime(2021, 1, 1)
+        before = datetime(2021, 2, 1)
+        match = sensor_data_filter(COLUMNS_SENSOR, COLUMNS_EXTERNAL, before, after)
+        self.assertEqual(match['date'], {'$gte': after, '$lte': before})
+        self.assertEqual(len(match['$or']), 1 + len(COLUMNS_EXTERNAL))
+        self.assertNotIn('date', sensor_data_filter(COLUMNS_SENSOR, COLUMNS_EXTERNAL, None, None))
+
+    def test_should_sort_and_limit_before_projecting(self):
+        pipeline = normalized_sensor_pipeline({}, COLUMNS_SENSOR, COLUMNS_EXTERNAL, INVALID_VALUES, 10, 13)
+        self.assertEqual([list(stage)[0] for stage in pipeline], ['$match', '$sort', '$limit', '$project'])
+        self.assertEqual(pipeline[2], {'$limit': 13})
+        project = pipeline[-1]['$project']
+        self.assertEqual(list(project), ['_id', *COLUMNS_SENSOR, *COLUMNS_EXTERNAL])
+        pipeline = normalized_sensor_pipeline({}, COLUMNS_SENSOR, COLUMNS_EXTERNAL, INVALID_VALUES, 10)
+        self.assertEqual([list(stage)[0] for stage in pipeline], ['$match', '$project'])
+
+    def test_should_reject_column_read_as_path(self):
+        with self.assertRaises(ValueError):
+            normalized_sensor_pipeline({}, ['PM2.5'], [], [], 10)
+
+    def test_should_stringify_lists(self):
+        self.assertEqual(format_row({'api_weather': ['Clouds', 'Light Rain'], 'CO (PPM)': 1.5}),
+                         {'api_weather': 'Clouds&LightRain', 'CO (PPM)': 1.5})
+
+    @unittest.skipUnless(MONGO, 'APC_TEST_MONGO is not set')
+    def test_should_average_as_sensor_aggregator(self):
+        from pymongo import MongoClient
+        host, port = MONGO.split(':')
+        collection = MongoClient(host, int(port))['apc-iot-test']['apc_data_pipeline']
+        collection.drop()
+        rng = random.Random(1)
+        documents = []
+        for i in range(500):
+            collectors = []
+            for _ in range(rng.choice([1, 2, 3, 5])):
+                collector = {'Temperature (C)': rng.choice([rng.uniform(20, 40), rng.randint(20, 40), -1, '', 0]),
+                             'PM25 (ug/m3)': rng.choice([rng.randint(5, 80), -1]),
+                             'Wind Direction': rng.choice(['N', 'NE', ''])}
+                if rng.random() < 0.2:
+                    del collector['PM25 (ug/m3)']
+                collectors.append(collector)
+            documents.append({'collectors_data': collectors, 'api_weather': ['Clouds'], 'date': datetime(2021, 1, 1),
+                              'seq': i})
+        collection.insert_many(documents)
+        documents.sort(key=lambda document: document['seq'])
+        pipeline = normalized_sensor_pipeline({}, COLUMNS_SENSOR, COLUMNS_EXTERNAL, INVALID_VALUES, 5)
+        # keep the stored order to pair the rows with their documents
+        pipeline.insert(1, {'$sort': {'seq': 1}})
+        rows = [format_row(row) for row in collection.aggregate(pipeline)]
+        collection.drop()
+        self.assertEqual(rows, [python_row(document, 5) for document in documents])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -269,7 +269,9 @@ def switch_sensor_type_to_unit_string(sensor_type: SensorType):
     switcher = {
         SensorType.MICS4514_NOX_TYPE: "PPM",
         SensorType.MICS4514_RED_TYPE: "PPM",
-        SensorType.MQ131_TYPE: "PPB"
+        SensorType.MQ131_TYPE: "PPB",
+        SensorType.MQ7_TYPE: "PPM",
+        SensorType.MQ135_TYPE: "PPM"
     }
     return switcher.get(sensor_type, None)
 
@@ -277,6 +279,8 @@ def switch_sensor_type_to_unit(sensor_type: SensorType):
     switcher = {
         SensorType.MICS4514_NOX_TYPE: SensorUnit.PPM,
         SensorType.MICS4514_RED_TYPE: SensorUnit.PPM,
-        SensorType.MQ131_TYPE: SensorUnit.PPB
+        SensorType.MQ131_TYPE: SensorUnit.PPB,
+        SensorType.MQ7_TYPE: SensorUnit.PPM,
+        SensorType.MQ135_TYPE: SensorUnit.PPM
     }
     return switcher.get(sensor_type, None)
\ No newline at end of file
@@ -0,0 +1,164 @@
+import threading
+from collections import deque
+from datetime import datetime
+from queue import Queue, Full
+from time import perf_counter
+from typing import Callable, List, Optional, Tuple
+from sensor_msg_parser import SensorMessageParser
+
+# Staged pipeline of mqtt-subscriber.py. paho's network thread only hands each publish to the first queue, every
+# stage (parse, enrich, store) runs in its own thread, so a slow weather API or a Mongo stall no longer holds up
+# MQTT keepalives and incoming publishes. Queues are bounded: a stage that falls behind blocks the stage before it,
+# and once the first queue is full the receiver drops publishes instead of waiting.
+
+# number of latencies kept per stage for the percentiles
+STATS_WINDOW = 1000
+
+# marks the end of the input, passed down the stages on stop()
+_STOP = object()
+
+
+def percentile(samples: List[float], p: float) -> float:
+    """ Nearest-rank percentile of samples, 0 if there are none """
+    if not samples:
+        return 0.0
+    ordered = sorted(samples)
+    rank = max(1, -(-len(ordered) * p // 100))
+    return ordered[int(rank) - 1]
+
+
+class StageStats:
+    """ Latencies of one stage: time items waited in its queue and time it took to handle them (seconds) """
+
+    def __init__(self, name: str):
+        self.name = name
+        self.count = 0
+        self.errors = 0
+        self.max_depth = 0
+        self.wait = deque(maxlen=STATS_WINDOW)
+        self.service = deque(maxlen=STATS_WINDOW)
+
+    def __str__(self):
+        wait = list(self.wait)
+        service = list(self.service)
+        return '{} n={} errors={} max_queue={} wait p50={:.1f} p99={:.1f} ms, service p50={:.1f} p99={:.1f} ' \
+               'max={:.1f} ms'.format(self.name, self.count, self.errors, self.max_depth,
+                                      percentile(wait, 50) * 1000, percentile(wait, 99) * 1000,
+                                      percentile(service, 50) * 1000, percentile(service, 99) * 1000,
+                                      max(service, default=0) * 1000)
+
+
+class Many(list):
+    """ Items a stage passes on to the next one from a single input """
+
+
+class Pipeline:
+    """ Runs each item through the given stages, one thread per stage, in order.
+
+    A stage gets the item returned by the stage before it. Returning None ends the item there (e.g. a message that
+    does not complete a round), returning Many passes on each of its items. An exception is counted and printed and
+    also ends the item.
+    """
+
+    def __init__(self, stages: List[Tuple[str, Callable[[object], object]]], queue_size: int = 16):
+        if not stages or queue_size < 1:
+            raise ValueError("A pipeline needs at least one stage and a queue size of at least 1.")
+        self.stages = stages
+        self.queues = [Queue(maxsize=queue_size) for _ in stages]
+        self.stats = [StageStats(name) for name, _ in stages]
+        # time from the receiver to the end of the last stage
+        self.end_to_end = deque(maxlen=STATS_WINDOW)
+        self.received = 0
+        self.dropped = 0
+        self._threads = [threading.Thread(target=self._run, args=(i,), name='pipeline-' + name, daemon=True)
+                         for i, (name, _) in enumerate(stages)]
+
+    def start(self):
+        for thread in self._threads:
+            thread.start()
+
+    def submit(self, item, timeout: float = 0.5) -> bool:
+        """ Receive stage: queues item for the first stage, waiting at most timeout seconds for room.
+        Returns False if the item was dropped because the pipeline is full.
+        """
+        now = perf_counter()
+        try:
+            self.queues[0].put((item, now, now), timeout=timeout)
+        except Full:
+            self.dropped += 1
+            return False
+        self.received += 1
+        self.stats[0].max_depth = max(self.stats[0].max_depth, self.queues[0].qsize())
+        return True
+
+    def stop(self, timeout: Optional[float] = None):
+        """ Lets the stages finish the queued items, then ends their threads """
+        self.queues[0].put(_STOP)
+        for thread in self._threads:
+            thread.join(timeout)
+
+    def report(self) -> str:
+        end_to_end = list(self.end_to_end)
+        lines = ['pipeline received={} dropped={} end-to-end p50={:.1f} p99={:.1f} ms'
+                 .format(self.received, self.dropped, percentile(end_to_end, 50) * 1000,
+                         percentile(end_to_end, 99) * 1000)]
+        lines.extend(str(stats) for stats in self.stats)
+        return '\n'.join(lines)
+
+    def _run(self, index: int):
+        name, handler = self.stages[index]
+        queue_in = self.queues[index]
+        queue_out = self.queues[index + 1] if index + 1 < len(self.queues) else None
+        stats = self.stats[index]
+        while True:
+            entry = queue_in.get()
+            if entry is _STOP:
+                if queue_out is not None:
+                    queue_out.put(_STOP)
+                return
+            item, received, queued = entry
+            start = perf_counter()
+            stats.wait.append(start - queued)
+            try:
+                result = handler(item)
+            except Exception as err:
+                stats.errors += 1
+                print('Pipeline: ERROR - stage {} failed: {!r}'.format(name, err))
+                result = None
+            stats.service.append(perf_counter() - start)
+            stats.count += 1
+            if result is None:
+                continue
+            for output in (result if isinstance(result, Many) else (result,)):
+                if queue_out is None:
+                    self.end_to_end.append(perf_counter() - received)
+                else:
+                    # blocks while the next stage is behind
+                    queue_out.put((output, received, perf_counter()))
+                    next_stats = self.stats[index + 1]
+                    next_stats.max_depth = max(next_stats.max_depth, queue_out.qsize())
+
+
+def build_document(messages: list, round_key: Optional[int], round_interval: int,
+                   missing: Optional[List[str]] = None) -> Optional[dict]:
+    """ Document of a round as mqtt-subscriber.py stores it, None if a payload is malformed. missing lists the motes
+    that did not publish in the round.
+    """
+    document = {}
+    try:
+        parser = SensorMessageParser(messages)
+        parser.parse_data()
+        document["collectors_info"] = []
+        document["collectors_data"] = []
+        for msg in parser.sensor_msgs:
+            document["collectors_info"].append(msg.collector_info)
+            document["collectors_data"].append(msg.collector_data)
+    except (ValueError, KeyError, TypeError):
+        print("ERROR - malformed payload data.")
+        return None
+    document['date'] = datetime.now()
+    if round_key is not None:
+        document['round_date'] = datetime.fromtimestamp(round_key * round_interval)
+    if missing is not None:
+        document['missing_collectors'] = missing
+    return document
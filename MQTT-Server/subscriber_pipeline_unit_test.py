@@ -0,0 +1,90 @@
+import json
+import threading
+import unittest
+from subscriber_pipeline import Pipeline, Many, build_document, percentile
+
+
+def mote_payload(name: str, timestamp: int = 0) -> bytes:
+    return json.dumps({"collector_info": {"myName": name, "Seq #": 1, "Timestamp": timestamp},
+                       "collector_sensor_data": {"Temperature (C)": 25.5, "calibration": [500, 500]}}).encode()
+
+
+class SubscriberPipelineTestCase(unittest.TestCase):
+    def test_should_run_items_through_stages_in_order(self):
+        stored = []
+        pipeline = Pipeline([('double', lambda x: x * 2), ('store', stored.append)])
+        pipeline.start()
+        for i in range(50):
+            self.assertTrue(pipeline.submit(i))
+        pipeline.stop(timeout=5)
+        self.assertEqual(stored, [i * 2 for i in range(50)])
+        self.assertEqual(pipeline.stats[0].count, 50)
+        self.assertEqual(pipeline.dropped, 0)
+
+    def test_should_end_item_at_stage_returning_none(self):
+        stored = []
+        pipeline = Pipeline([('odd', lambda x: x if x % 2 else None), ('store', stored.append)])
+        pipeline.start()
+        for i in range(10):
+            pipeline.submit(i)
+        pipeline.stop(timeout=5)
+        self.assertEqual(stored, [1, 3, 5, 7, 9])
+        self.assertEqual(pipeline.stats[1].count, 5)
+
+    def test_should_count_stage_errors_and_go_on(self):
+        stored = []
+        pipeline = Pipeline([('parse', lambda x: 10 // x), ('store', stored.append)])
+        pipeline.start()
+        for i in (1, 0, 2):
+            pipeline.submit(i)
+        pipeline.stop(timeout=5)
+        self.assertEqual(stored, [10, 5])
+        self.assertEqual(pipeline.stats[0].errors, 1)
+
+    def test_should_drop_at_receiver_when_stalled_stage_fills_queues(self):
+        # the store stage stalls, the queues before it fill up one after the other
+        release = threading.Event()
+        pipeline = Pipeline([('parse', lambda x: x), ('store', lambda x: release.wait())], queue_size=2)
+        pipeline.start()
+        accepted = sum(pipeline.submit(i, timeout=0.05) for i in range(10))
+        # one item in each stage, two in each queue
+        self.assertEqual(accepted, 6)
+        self.assertEqual(pipeline.dropped, 4)
+        release.set()
+        pipeline.stop(timeout=5)
+        self.assertEqual(pipeline.stats[1].count, 6)
+        self.assertEqual(pipeline.stats[1].max_depth, 2)
+
+    def test_should_take_nearest_rank_percentile(self):
+        samples = list(range(1, 101))
+        self.assertEqual(percentile(samples, 50), 50)
+        self.assertEqual(percentile(samples, 99), 99)
+        self.assertEqual(percentile([], 99), 0.0)
+
+    def test_should_pass_on_each_item_of_many(self):
+        stored = []
+        pipeline = Pipeline([('split', lambda x: Many([x] * x)), ('store', stored.append)])
+        pipeline.start()
+        for i in (2, 0, 3):
+            pipeline.submit(i)
+        pipeline.stop(timeout=5)
+        self.assertEqual(stored, [2, 2, 3, 3, 3])
+
+    def test_should_build_round_document(self):
+        document = build_document([mote_payload('113', 7200), mote_payload('056', 7210)], 2, 3600)
+        self.assertEqual([info['myName'] for info in document['collectors_info']], ['113', '056'])
+        self.assertEqual(document['collectors_info'][0]['calibration'], [500, 500])
+        self.assertEqual(document['collectors_data'][0]['Temperature (C)'], 25.5)
+        self.assertEqual(document['round_date'].timestamp(), 7200)
+        self.assertNotIn('missing_collectors', document)
+
+    def test_should_list_missing_motes_in_document(self):
+        document = build_document([mote_payload('113', 7200)], 2, 3600, ['056'])
+        self.assertEqual(document['missing_collectors'], ['056'])
+
+    def test_should_reject_malformed_round(self):
+        self.assertIsNone(build_document([b'{"collector_info": {}}'], None, 3600))
+
+
+if __name__ == '__main__':
+    unittest.main()
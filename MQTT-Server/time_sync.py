@@ -0,0 +1,52 @@
+import json
+from time import time
+
+TIME_REQUEST_EVENT = 'time-req'
+TIME_SYNC_COMMAND = 'time-sync'
+
+
+def epoch_millis():
+    return int(time() * 1000)
+
+
+def is_time_request(topic: str):
+    # topic format: <top level>/<mote id>/evt/time-req/fmt/json
+    parts = topic.split('/')
+    return len(parts) > 3 and parts[2] == 'evt' and parts[3] == TIME_REQUEST_EVENT
+
+
+def time_sync_topic(top_level_topic: str, subtopic: str):
+    return "{}/{}/cmd/{}/fmt/json".format(top_level_topic, subtopic, TIME_SYNC_COMMAND)
+
+
+def build_time_sync_reply(payload, t2: int, t3: int = None):
+    """ Build the reply to a mote time request (NTP-like exchange).
+
+    :param payload: request payload from the mote, {"t1": <mote uptime in ms>}
+    :param t2: epoch time (ms) when the request was received
+    :param t3: epoch time (ms) when the reply is sent, defaults to now
+    :return: reply payload "t1,t2,t3", or None when the request is malformed
+    """
+    try:
+        t1 = int(json.loads(payload)['t1'])
+    except (ValueError, KeyError, TypeError):
+        return None
+    if t3 is None:
+        t3 = epoch_millis()
+    return "{},{},{}".format(t1, t2, t3)
+
+
+def get_round_key(payload, round_interval: int):
+    """ Round a mote publish belongs to, from the collection timestamp it carries.
+
+    :param payload: mote publish payload (JSON)
+    :param round_interval: publish interval of the motes in seconds
+    :return: round number (epoch seconds // round_interval), or None if the mote is not synchronized yet
+    """
+    try:
+        timestamp = int(json.loads(payload)['collector_info'].get('Timestamp', 0))
+    except (ValueError, KeyError, TypeError, AttributeError):
+        return None
+    if timestamp <= 0 or round_interval <= 0:
+        return None
+    return timestamp // round_interval
@@ -0,0 +1,34 @@
+import json
+import unittest
+import time_sync
+
+
+class TimeSyncTestCase(unittest.TestCase):
+    def test_should_echo_mote_time_in_reply(self):
+        reply = time_sync.build_time_sync_reply(b'{"t1":123456}', 1600000000000, 1600000000005)
+        self.assertEqual(reply, "123456,1600000000000,1600000000005")
+
+    def test_should_reject_malformed_request(self):
+        self.assertIsNone(time_sync.build_time_sync_reply(b'{"t0":1}', 1))
+        self.assertIsNone(time_sync.build_time_sync_reply(b'not json', 1))
+
+    def test_should_recognize_time_request_topic(self):
+        self.assertTrue(time_sync.is_time_request("apc-iot/056/evt/time-req/fmt/json"))
+        self.assertFalse(time_sync.is_time_request("apc-iot/056/evt/status/fmt/json"))
+        self.assertEqual(time_sync.time_sync_topic("apc-iot", "056"), "apc-iot/056/cmd/time-sync/fmt/json")
+
+    def test_should_put_motes_of_same_round_together(self):
+        # motes publish in different slots within the same round
+        payload1 = json.dumps({"collector_info": {"Timestamp": 1600002000}})
+        payload2 = json.dumps({"collector_info": {"Timestamp": 1600002055}})
+        payload3 = json.dumps({"collector_info": {"Timestamp": 1600005600}})
+        self.assertEqual(time_sync.get_round_key(payload1, 3600), time_sync.get_round_key(payload2, 3600))
+        self.assertNotEqual(time_sync.get_round_key(payload1, 3600), time_sync.get_round_key(payload3, 3600))
+
+    def test_should_not_key_unsynchronized_motes(self):
+        self.assertIsNone(time_sync.get_round_key(json.dumps({"collector_info": {"Timestamp": 0}}), 3600))
+        self.assertIsNone(time_sync.get_round_key(json.dumps({"collector_info": {}}), 3600))
+
+
+if __name__ == '__main__':
+    unittest.main()
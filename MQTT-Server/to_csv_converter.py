@@ -51,12 +51,11 @@ class CsvConverter:
         if self.columns_sensor.count == 0:
             raise ValueError("columns_sensor is empty.")
 
-        documents = self.db_access.get_all_sensor_data_normalized(self.columns_sensor, self.columns_external,
-                                                                  self.invalid_values,self.before_date,
-                                                                  self.after_date, self.tolerance)
+        # rows are written as the cursor returns them, not gathered first
+        documents = self.db_access.stream_sensor_data_normalized(self.columns_sensor, self.columns_external,
+                                                                 self.invalid_values, self.before_date,
+                                                                 self.after_date, self.tolerance)
 
-        if len(documents) == 0:
-            print('WARNING - no data to write other than headers.')
         csv_columns = [*self.columns_sensor, *self.columns_external]
         data_stream = StringIO()
         writer = csv.DictWriter(data_stream, fieldnames=csv_columns)
@@ -69,10 +68,14 @@ class CsvConverter:
         data_stream.truncate(0)
 
         # write each row item
+        rows = 0
         for document in documents:
             writer.writerow(document)
+            rows += 1
             yield data_stream.getvalue()
             data_stream.seek(0)
             data_stream.truncate(0)
 
+        if rows == 0:
+            print('WARNING - no data to write other than headers.')
         print('write done!')
@@ -2,10 +2,30 @@ import configparser
 import requests
 import json
 import sys
+
+API_URL = "https://api.openweathermap.org/data/2.5/weather"
+# seconds to wait for the API to connect and to answer
+DEFAULT_TIMEOUT = 10
+
+def weather_fields(weather):
+    """ api_weather and api_wind of an OpenWeatherMap reply, as the documents store them """
+    weather_params = {}
+    if weather is None:
+        return weather_params
+    for key, val in weather.items():
+        if key == 'weather':
+            weather_params['api_weather'] = [weather_info['main'] for weather_info in val]
+        elif key == 'wind':
+            weather_params['api_wind'] = val
+    return weather_params
  
-def get_weather_with_loc(api_key, location):
-    url = "https://api.openweathermap.org/data/2.5/weather?q={}&units=metric&appid={}".format(location, api_key)
-    r = requests.get(url)
+def get_weather_with_loc(api_key, location, timeout=DEFAULT_TIMEOUT):
+    url = "{}?q={}&units=metric&appid={}".format(API_URL, location, api_key)
+    try:
+        r = requests.get(url, timeout=timeout)
+    except requests.RequestException as err:
+        print("Weather API: ERROR - {}".format(err))
+        return None
     if r.status_code == 200:
         return r.json()
     elif r.status_code == 404:
@@ -24,9 +44,13 @@ def get_weather_with_loc(api_key, location):
         print("Weather API: ERROR - Unknown error.")
         return None
 
-def get_weather_with_id(api_key, loc_id):
-    url = "https://api.openweathermap.org/data/2.5/weather?id={}&units=metric&appid={}".format(loc_id, api_key)
-    r = requests.get(url)
+def get_weather_with_id(api_key, loc_id, timeout=DEFAULT_TIMEOUT):
+    url = "{}?id={}&units=metric&appid={}".format(API_URL, loc_id, api_key)
+    try:
+        r = requests.get(url, timeout=timeout)
+    except requests.RequestException as err:
+        print("Weather API: ERROR - {}".format(err))
+        return None
     if r.status_code == 200:
         return r.json()
     elif r.status_code == 404:
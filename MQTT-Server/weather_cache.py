@@ -0,0 +1,89 @@
+import threading
+from datetime import datetime
+from time import time
+from typing import Callable, Optional
+from weather_access import weather_fields
+
+# OpenWeatherMap replies shared by every round. A background thread refreshes the reply before it is ttl seconds old,
+# so the collectors read the weather without waiting on the API. When the API cannot be reached the last reply is
+# kept and the documents are marked stale.
+
+# seconds between retries while the API cannot be reached
+RETRY_INTERVAL = 30
+
+
+class WeatherCache:
+    """ fetch returns the OpenWeatherMap reply or None, it is called from the refresh thread only """
+
+    def __init__(self, fetch: Callable[[], Optional[dict]], ttl: float = 600, retry_interval: float = RETRY_INTERVAL):
+        if ttl <= 0:
+            raise ValueError("The weather cache TTL must be positive.")
+        self.ttl = ttl
+        self.retry_interval = min(retry_interval, ttl)
+        self._fetch = fetch
+        self._lock = threading.Lock()
+        self._weather = None
+        self._fetched_at = None
+        self._fetched = threading.Event()
+        self._stop = threading.Event()
+        self._thread = threading.Thread(target=self._run, name='weather-cache', daemon=True)
+
+    def start(self):
+        self._thread.start()
+
+    def stop(self):
+        self._stop.set()
+        self._thread.join()
+
+    def wait_ready(self, timeout: Optional[float] = None) -> bool:
+        """ Waits for the first reply, returns False if there is none after timeout seconds """
+        return self._fetched.wait(timeout)
+
+    def refresh(self) -> bool:
+        """ Fetches a new reply now, returns False if the API gave none and the last one is kept """
+        try:
+            weather = self._fetch()
+        except ValueError as err:
+            # reply that is not JSON
+            print("Weather cache: ERROR - {}".format(err))
+            weather = None
+        if weather is None:
+            return False
+        with self._lock:
+            self._weather = weather
+            self._fetched_at = time()
+        self._fetched.set()
+        return True
+
+    def latest(self) -> Optional[dict]:
+        """ Last reply, however old, None if the API never answered """
+        with self._lock:
+            return self._weather
+
+    def age(self) -> Optional[float]:
+        """ Seconds since the last reply, None if the API never answered """
+        with self._lock:
+            return None if self._fetched_at is None else time() - self._fetched_at
+
+    def fields(self) -> dict:
+        """ api_weather and api_wind as the documents store them, with the time of the reply and whether it is older
+        than the TTL; empty if the API never answered
+        """
+        with self._lock:
+            weather, fetched_at = self._weather, self._fetched_at
+        if weather is None:
+            return {}
+        fields = weather_fields(weather)
+        fields['api_weather_date'] = datetime.fromtimestamp(fetched_at)
+        fields['api_weather_stale'] = time() - fetched_at > self.ttl
+        return fields
+
+    def _run(self):
+        while not self._stop.is_set():
+            if self.refresh():
+                # refresh at half the TTL, a failed refresh still leaves time for retries before the reply is stale
+                interval = self.ttl / 2
+            else:
+                print("Weather cache: refresh failed, retrying in {} s".format(self.retry_interval))
+                interval = self.retry_interval
+            self._stop.wait(interval)
@@ -0,0 +1,111 @@
+import json
+import threading
+import unittest
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from time import perf_counter, sleep
+import weather_access
+from weather_cache import WeatherCache
+
+
+class WeatherStandIn(BaseHTTPRequestHandler):
+    """ OpenWeatherMap weather endpoint: answers server.reply with server.status after server.delay seconds """
+
+    def do_GET(self):
+        self.server.requests += 1
+        sleep(self.server.delay)
+        body = json.dumps(self.server.reply).encode()
+        try:
+            self.send_response(self.server.status)
+            self.send_header('Content-Type', 'application/json')
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+        except ConnectionError:
+            pass
+
+    def log_message(self, fmt, *args):
+        pass
+
+
+class WeatherCacheTestCase(unittest.TestCase):
+    def setUp(self):
+        self.server = ThreadingHTTPServer(('127.0.0.1', 0), WeatherStandIn)
+        self.server.reply = {"weather": [{"main": "Rain"}], "wind": {"speed": 3.5, "deg": 90}}
+        self.server.status = 200
+        self.server.delay = 0
+        self.server.requests = 0
+        threading.Thread(target=self.server.serve_forever, daemon=True).start()
+        self.api_url = weather_access.API_URL
+        weather_access.API_URL = 'http://127.0.0.1:{}/data/2.5/weather'.format(self.server.server_address[1])
+        self.cache = None
+
+    def tearDown(self):
+        if self.cache is not None:
+            self.cache.stop()
+        self.server.shutdown()
+        self.server.server_close()
+        weather_access.API_URL = self.api_url
+
+    def start_cache(self, ttl: float, retry_interval: float = 0.05, timeout: float = 2) -> WeatherCache:
+        self.cache = WeatherCache(lambda: weather_access.get_weather_with_id('0', '1729525', timeout), ttl,
+                                  retry_interval)
+        self.cache.start()
+        return self.cache
+
+    def test_should_give_fresh_weather_fields(self):
+        cache = self.start_cache(60)
+        self.assertTrue(cache.wait_ready(2))
+        fields = cache.fields()
+        self.assertEqual(fields['api_weather'], ['Rain'])
+        self.assertEqual(fields['api_wind'], {"speed": 3.5, "deg": 90})
+        self.assertFalse(fields['api_weather_stale'])
+        self.assertEqual(self.server.requests, 1)
+
+    def test_should_not_wait_for_slow_api(self):
+        self.server.delay = 1
+        cache = self.start_cache(60)
+        start = perf_counter()
+        self.assertEqual(cache.fields(), {})
+        self.assertIsNone(cache.latest())
+        self.assertLess(perf_counter() - start, 0.1)
+        self.assertTrue(cache.wait_ready(3))
+        self.assertEqual(cache.fields()['api_weather'], ['Rain'])
+
+    def test_should_refresh_in_background(self):
+        cache = self.start_cache(0.2)
+        self.assertTrue(cache.wait_ready(2))
+        self.server.reply = {"weather": [{"main": "Clear"}], "wind": {"speed": 1.0, "deg": 0}}
+        sleep(0.4)
+        self.assertEqual(cache.fields()['api_weather'], ['Clear'])
+        self.assertGreaterEqual(self.server.requests, 2)
+
+    def test_should_fall_back_to_stale_weather_when_api_fails(self):
+        cache = self.start_cache(0.2)
+        self.assertTrue(cache.wait_ready(2))
+        self.server.status = 429
+        self.server.reply = {"cod": 429}
+        sleep(0.4)
+        fields = cache.fields()
+        self.assertEqual(fields['api_weather'], ['Rain'])
+        self.assertTrue(fields['api_weather_stale'])
+        self.assertGreater(cache.age(), 0.2)
+
+    def test_should_fall_back_to_stale_weather_on_api_timeout(self):
+        cache = self.start_cache(0.2, timeout=0.1)
+        self.assertTrue(cache.wait_ready(2))
+        self.server.delay = 0.5
+        sleep(0.4)
+        self.assertTrue(cache.fields()['api_weather_stale'])
+        self.assertEqual(cache.latest()['weather'], [{"main": "Rain"}])
+
+    def test_should_retry_until_api_answers(self):
+        self.server.status = 401
+        cache = self.start_cache(60)
+        self.assertFalse(cache.wait_ready(0.2))
+        self.server.status = 200
+        self.assertTrue(cache.wait_ready(2))
+        self.assertFalse(cache.fields()['api_weather_stale'])
+
+
+if __name__ == '__main__':
+    unittest.main()
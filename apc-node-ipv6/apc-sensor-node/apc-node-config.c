@@ -0,0 +1,237 @@
+/* C std libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+/* Contiki Core Libraries */
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "lib/crc16.h"
+/* Project Sourcefiles */
+#include "apc-node-config.h"
+/*---------------------------------------------------------------------------*/
+#define DEBUG 0
+#if DEBUG
+	#define PRINTF(...) printf(__VA_ARGS__)
+#else
+	#define PRINTF(...)
+#endif
+/*---------------------------------------------------------------------------*/
+#define CONFIG_FILENAME              "apc-conf"
+#define CONFIG_MAGIC                 0xA9C0
+/* bump when apc_node_config_t changes, older records are then ignored */
+#define CONFIG_VERSION               1
+/*---------------------------------------------------------------------------*/
+typedef struct {
+	uint16_t magic;
+	uint16_t version;
+	apc_node_config_t config;
+	uint16_t crc;
+} config_record_t;
+/*---------------------------------------------------------------------------*/
+typedef struct {
+	const char *name;
+	uint8_t offset;
+	uint8_t is_mask; //accept hex input and reply in hex
+	uint32_t min;
+	uint32_t max;
+} config_key_t;
+/*---------------------------------------------------------------------------*/
+static const config_key_t config_keys[] = {
+	{ "collect", offsetof(apc_node_config_t, collect_interval), 0,
+		COLLECT_INTERVAL_MIN, COLLECT_INTERVAL_MAX },
+	{ "publish", offsetof(apc_node_config_t, publish_interval), 0,
+		PUBLISH_INTERVAL_MIN, PUBLISH_INTERVAL_MAX },
+	{ "ping", offsetof(apc_node_config_t, ping_interval), 0,
+		RSSI_MEASURE_INTERVAL_MIN, RSSI_MEASURE_INTERVAL_MAX },
+	{ "sensors", offsetof(apc_node_config_t, sensor_mask), 1,
+		0, (1UL << SENSOR_COUNT) - 1 },
+};
+#define CONFIG_KEY_COUNT             (sizeof(config_keys) / sizeof(config_keys[0]))
+#define CONFIG_VALUE(cfg, key)       (*(uint32_t *)((uint8_t *)(cfg) + (key)->offset))
+/*---------------------------------------------------------------------------*/
+apc_node_config_t apc_node_config;
+static apc_node_config_t default_config;
+/*---------------------------------------------------------------------------*/
+static const config_key_t *
+find_key(const char *name, int len)
+{
+	for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+		if (strlen(config_keys[i].name) == len && strncmp(config_keys[i].name, name, len) == 0)
+			return &config_keys[i];
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+is_valid_config(apc_node_config_t *cfg)
+{
+	for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+		uint32_t value = CONFIG_VALUE(cfg, &config_keys[i]);
+		if (value < config_keys[i].min || value > config_keys[i].max)
+			return 0;
+	}
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+save_config(void)
+{
+	config_record_t record;
+	int fd;
+
+	record.magic = CONFIG_MAGIC;
+	record.version = CONFIG_VERSION;
+	memcpy(&record.config, &apc_node_config, sizeof(apc_node_config_t));
+	record.crc = crc16_data((const unsigned char *)&record, offsetof(config_record_t, crc), 0);
+
+	fd = cfs_open(CONFIG_FILENAME, CFS_WRITE);
+	if (fd < 0) {
+		PRINTF("apc_node_config: ERROR - unable to open %s for writing\n", CONFIG_FILENAME);
+		return;
+	}
+	if (cfs_write(fd, &record, sizeof(record)) != sizeof(record)) {
+		PRINTF("apc_node_config: ERROR - failed to save the configuration\n");
+	}
+	cfs_close(fd);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+load_config(void)
+{
+	config_record_t record;
+	int fd, len;
+
+	fd = cfs_open(CONFIG_FILENAME, CFS_READ);
+	if (fd < 0)
+		return 0;
+	len = cfs_read(fd, &record, sizeof(record));
+	cfs_close(fd);
+
+	if (len != sizeof(record) || record.magic != CONFIG_MAGIC || record.version != CONFIG_VERSION ||
+			record.crc != crc16_data((const unsigned char *)&record, offsetof(config_record_t, crc), 0)) {
+		PRINTF("apc_node_config: saved configuration is invalid, ignoring\n");
+		return 0;
+	}
+	//bounds may have changed since the record was written
+	if (!is_valid_config(&record.config)) {
+		PRINTF("apc_node_config: saved configuration is out of bounds, ignoring\n");
+		return 0;
+	}
+	memcpy(&apc_node_config, &record.config, sizeof(apc_node_config_t));
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+write_value(char *buf, int len, const config_key_t *key)
+{
+	if (key->is_mask)
+		return snprintf(buf, len, "\"%s\":\"0x%02lx\"", key->name,
+			(unsigned long)CONFIG_VALUE(&apc_node_config, key));
+	return snprintf(buf, len, "\"%s\":%lu", key->name,
+		(unsigned long)CONFIG_VALUE(&apc_node_config, key));
+}
+/*---------------------------------------------------------------------------*/
+/* {"ok":1,<key>:<value>,...}, all keys if key is NULL */
+static void
+write_reply(char *buf, int len, const config_key_t *key)
+{
+	int n = snprintf(buf, len, "{\"ok\":1");
+
+	for (int i = 0; i < CONFIG_KEY_COUNT && n < len; i++) {
+		if (key != NULL && key != &config_keys[i])
+			continue;
+		n += snprintf(&buf[n], len - n, ",");
+		if (n < len)
+			n += write_value(&buf[n], len - n, &config_keys[i]);
+	}
+	if (n < len)
+		snprintf(&buf[n], len - n, "}");
+}
+/*---------------------------------------------------------------------------*/
+/* {"ok":0,"error":<reason>[,"key":<key>,"min":..,"max":..]} */
+static void
+write_error(char *buf, int len, const char *reason, const config_key_t *key)
+{
+	if (key == NULL) {
+		snprintf(buf, len, "{\"ok\":0,\"error\":\"%s\"}", reason);
+	} else {
+		snprintf(buf, len, "{\"ok\":0,\"error\":\"%s\",\"key\":\"%s\",\"min\":%lu,\"max\":%lu}",
+			reason, key->name, (unsigned long)key->min, (unsigned long)key->max);
+	}
+}
+/*---------------------------------------------------------------------------*/
+void
+apc_node_config_init(const apc_node_config_t *defaults)
+{
+	memcpy(&default_config, defaults, sizeof(apc_node_config_t));
+	if (!load_config()) {
+		memcpy(&apc_node_config, &default_config, sizeof(apc_node_config_t));
+	}
+	PRINTF("apc_node_config: collect %lus, publish %lus, ping %lus, sensors 0x%02lx\n",
+		(unsigned long)apc_node_config.collect_interval, (unsigned long)apc_node_config.publish_interval,
+		(unsigned long)apc_node_config.ping_interval, (unsigned long)apc_node_config.sensor_mask);
+}
+/*---------------------------------------------------------------------------*/
+int
+apc_node_config_command(const char *cmd, char *reply_buf, int reply_len)
+{
+	apc_node_config_t pending;
+	const config_key_t *key;
+	const char *ptr, *eq;
+	char *value_end;
+	unsigned long value;
+
+	if (cmd[0] == '?') {
+		key = NULL;
+		if (cmd[1] != '\0' && (key = find_key(&cmd[1], strlen(&cmd[1]))) == NULL) {
+			write_error(reply_buf, reply_len, "unknown key", NULL);
+			return APC_NODE_CONFIG_UNCHANGED;
+		}
+		write_reply(reply_buf, reply_len, key);
+		return APC_NODE_CONFIG_UNCHANGED;
+	}
+	if (cmd[0] == '!') {
+		memcpy(&apc_node_config, &default_config, sizeof(apc_node_config_t));
+		cfs_remove(CONFIG_FILENAME);
+		write_reply(reply_buf, reply_len, NULL);
+		return APC_NODE_CONFIG_CHANGED;
+	}
+
+	//validate every assignment before applying any of them
+	memcpy(&pending, &apc_node_config, sizeof(apc_node_config_t));
+	ptr = cmd;
+	while (*ptr != '\0') {
+		eq = strchr(ptr, '=');
+		if (eq == NULL) {
+			write_error(reply_buf, reply_len, "syntax", NULL);
+			return APC_NODE_CONFIG_UNCHANGED;
+		}
+		key = find_key(ptr, eq - ptr);
+		if (key == NULL) {
+			write_error(reply_buf, reply_len, "unknown key", NULL);
+			return APC_NODE_CONFIG_UNCHANGED;
+		}
+		value = strtoul(eq + 1, &value_end, key->is_mask ? 0 : 10);
+		if (value_end == eq + 1 || (*value_end != ';' && *value_end != '\0')) {
+			write_error(reply_buf, reply_len, "value", key);
+			return APC_NODE_CONFIG_UNCHANGED;
+		}
+		if (value < key->min || value > key->max) {
+			write_error(reply_buf, reply_len, "range", key);
+			return APC_NODE_CONFIG_UNCHANGED;
+		}
+		CONFIG_VALUE(&pending, key) = value;
+		ptr = *value_end == ';' ? value_end + 1 : value_end;
+	}
+
+	if (memcmp(&pending, &apc_node_config, sizeof(apc_node_config_t)) == 0) {
+		write_reply(reply_buf, reply_len, NULL);
+		return APC_NODE_CONFIG_UNCHANGED;
+	}
+	memcpy(&apc_node_config, &pending, sizeof(apc_node_config_t));
+	save_config();
+	write_reply(reply_buf, reply_len, NULL);
+	return APC_NODE_CONFIG_CHANGED;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,51 @@
+#ifndef APC_NODE_CONFIG_H_
+#define APC_NODE_CONFIG_H_
+/* Project Sourcefiles */
+#include "../apc-common.h"
+/*---------------------------------------------------------------------------*/
+/* Bounds of the runtime-tunable settings */
+#define COLLECT_INTERVAL_MAX         86400  /* secs: 1 day */
+#define COLLECT_INTERVAL_MIN         30     /* secs, a full sweep takes a few seconds */
+#define RSSI_MEASURE_INTERVAL_MAX    604800 /* secs: 7 days */
+#define RSSI_MEASURE_INTERVAL_MIN    5      /* secs */
+#define PUBLISH_INTERVAL_MAX         604800 /* secs: 7 days */
+#ifndef PUBLISH_CONF_INTERVAL_SEC
+#define PUBLISH_INTERVAL_MIN         1200   /* secs: 20 mins */
+#else
+#define PUBLISH_INTERVAL_MIN         PUBLISH_CONF_INTERVAL_SEC
+#endif
+/*---------------------------------------------------------------------------*/
+//return codes
+#define APC_NODE_CONFIG_UNCHANGED    0
+#define APC_NODE_CONFIG_CHANGED      1
+/*---------------------------------------------------------------------------*/
+typedef struct {
+	uint32_t collect_interval; //secs
+	uint32_t publish_interval; //secs
+	uint32_t ping_interval;    //secs
+	uint32_t sensor_mask;      //bit i enables SENSOR_TYPES[i]
+} apc_node_config_t;
+/*---------------------------------------------------------------------------*/
+extern apc_node_config_t apc_node_config;
+/*---------------------------------------------------------------------------*/
+/* Load the configuration saved in flash, or the defaults if there is none
+ * (or it does not pass validation).
+ */
+void
+apc_node_config_init(const apc_node_config_t *defaults);
+/*---------------------------------------------------------------------------*/
+/* Execute a configuration command received on the cmd/config topic.
+ *
+ * "?"                         get all keys
+ * "?<key>"                    get one key
+ * "<key>=<value>[;...]"       set keys; all are validated before any is applied
+ * "!"                         restore the defaults
+ *
+ * Keys: collect, publish, ping (seconds), sensors (bitmap, 0x.. accepted).
+ * Changes are saved to flash. A JSON reply is written to reply_buf.
+ * @returns: APC_NODE_CONFIG_CHANGED if the running configuration changed
+ */
+int
+apc_node_config_command(const char *cmd, char *reply_buf, int reply_len);
+/*---------------------------------------------------------------------------*/
+#endif /* ifndef APC_NODE_CONFIG_H_ */
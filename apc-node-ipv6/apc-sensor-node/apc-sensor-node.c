@@ -13,26 +13,44 @@
 #include "net/rpl/rpl.h"
 #include "rpl/rpl-private.h"
 #include "net/linkaddr.h"
+#include "net/link-stats.h"
 #include "net/netstack.h"
 /* Contiki Dev and Utilities */
+#if CONTIKI_TARGET_COOJA
+#include "sim-sensors.h"
+#else
 #include "dev/dht22.h"
 #include "dev/adc-zoul.h"
 #include "dev/zoul-sensors.h"
 #include "dev/pm25-sensor.h"
-#include "dev/leds.h"
 #include "dev/cc2538-sensors.h"
+#endif
+#include "dev/leds.h"
 #include "sys/etimer.h"
 #include "sys/ctimer.h"
 #include "sys/timer.h"
 /* Contiki Apps */
 #include "mqtt.h"
+#if WITH_POWERTRACE
+#include "powertrace.h"
+#endif
+#if WITH_TSCH
+#include "net/mac/tsch/tsch.h"
+#include "../apc-tsch-schedule.h"
+#endif
 /* Project Sourcefiles */
 #include "apc-sensor-node.h"
+#include "apc-node-config.h"
+#if !CONTIKI_TARGET_COOJA
 #include "dev/air-quality-sensor.h"
 #include "dev/anemometer-sensor.h"
 #if !ADC_SENSORS_CONF_USE_EXTERNAL_ADC
 #include "dev/shared-sensors.h"
 #endif
+#endif /* !CONTIKI_TARGET_COOJA */
+#ifndef SIM_EVENT
+#define SIM_EVENT(...)
+#endif
 /*---------------------------------------------------------------------------*/
 #define DEBUG 0 //DEBUG_PRINT
 #include "net/ip/uip-debug.h"
@@ -67,6 +85,13 @@ const uint8_t SENSOR_CALIB_TYPES[SENSOR_CALIB_COUNT] =
 #define APC_SENSOR_NODE_READ_INTERVAL_SECONDS             APC_SENSOR_NODE_READ_INTERVAL_SECONDS_CONF
 #endif
 /*----------------------------------------------------------------------------------*/
+/* Interval of the duty cycle reports when built with MAKE_WITH_POWERTRACE=1 */
+#ifndef APC_SENSOR_NODE_POWERTRACE_INTERVAL_SECONDS_CONF
+#define APC_SENSOR_NODE_POWERTRACE_INTERVAL_SECONDS       60
+#else
+#define APC_SENSOR_NODE_POWERTRACE_INTERVAL_SECONDS       APC_SENSOR_NODE_POWERTRACE_INTERVAL_SECONDS_CONF
+#endif
+/*----------------------------------------------------------------------------------*/
 /* Identifier for this mote, used for MQTT subtopic */
 #define APC_SENSOR_TOPIC_NAME                             "apc-iot"
 #ifdef  APC_SENSOR_MOTE_ID_CONF
@@ -161,6 +186,8 @@ static const char *broker_ip = "0064:ff9b:0000:0000:0000:0000:b8ac:7cbd";
 #define CONNECTION_STABLE_TIME     (CLOCK_SECOND * 5)
 static struct timer connection_life;
 static uint8_t connect_attempt;
+/* Joined the RPL DAG, with a global address */
+static uint8_t joined;
 /*---------------------------------------------------------------------------*/
 /* Various states */
 static uint8_t state;
@@ -180,15 +207,8 @@ static uint8_t state;
 #define CONFIG_EVENT_TYPE_ID_LEN 32
 #define CONFIG_CMD_TYPE_LEN       8
 #define CONFIG_IP_ADDR_STR_LEN   64
-/*---------------------------------------------------------------------------*/
-#define RSSI_MEASURE_INTERVAL_MAX    604800 /* secs: 7 days */
-#define RSSI_MEASURE_INTERVAL_MIN    5      /* secs */
-#define PUBLISH_INTERVAL_MAX         604800 /* secs: 7 days */
-#ifndef PUBLISH_CONF_INTERVAL_SEC
-#define PUBLISH_INTERVAL_MIN         1200   /* secs: 20 mins */
-#else
-#define PUBLISH_INTERVAL_MIN         PUBLISH_CONF_INTERVAL_SEC
-#endif
+#define CONFIG_NODE_CMD_LEN      64
+#define CONFIG_NODE_REPLY_LEN    96
 /*---------------------------------------------------------------------------*/
 /* A timeout used when waiting to connect to a network */
 #define NET_CONNECT_PERIODIC        (CLOCK_SECOND >> 2)
@@ -204,7 +224,34 @@ static uint8_t state;
 #define DEFAULT_KEEP_ALIVE_TIMER    PUBLISH_INTERVAL_MIN + 300
 #define DEFAULT_RSSI_MEAS_INTERVAL  (CLOCK_SECOND * 30)
 /*---------------------------------------------------------------------------*/
-/* Payload length of ICMPv6 echo requests used to measure RSSI with def rt */
+/* Replies to cmd/config are published on this event type */
+#define CONFIG_EVENT_TYPE_ID        "config"
+/*---------------------------------------------------------------------------*/
+/* Time synchronization with the subscriber (NTP-like exchange over MQTT) */
+#define TIME_REQ_EVENT_TYPE_ID      "time-req"
+#ifndef APC_TIME_SYNC_CONF_INTERVAL_SEC
+#define APC_TIME_SYNC_INTERVAL      (CLOCK_SECOND * 21600) /* 6 hours */
+#else
+#define APC_TIME_SYNC_INTERVAL      (CLOCK_SECOND * APC_TIME_SYNC_CONF_INTERVAL_SEC)
+#endif
+#define APC_TIME_SYNC_RETRY_INTERVAL (CLOCK_SECOND * 30)
+/* Samples with a longer round trip are too asymmetric to be trusted */
+#define APC_TIME_SYNC_MAX_RTT_MS    3000
+/*
+* Once synchronized, collection and publishing are aligned to the epoch
+* (multiples of their intervals) and offset by a per-mote slot, so that
+* every mote reports the same round without transmitting at the same time.
+*/
+#ifndef APC_TIME_SYNC_CONF_PUBLISH_SLOTS
+#define APC_TIME_SYNC_PUBLISH_SLOTS 12
+#else
+#define APC_TIME_SYNC_PUBLISH_SLOTS APC_TIME_SYNC_CONF_PUBLISH_SLOTS
+#endif
+#define APC_TIME_SYNC_SLOT_MS       5000
+/* Publish this long after collection starts, enough for a full sweep */
+#define APC_TIME_SYNC_COLLECT_LEAD_MS 4000
+/*---------------------------------------------------------------------------*/
+/* Payload length of ICMPv6 echo requests used to probe the def rt link */
 #define ECHO_REQ_PAYLOAD_LEN   20
 /*---------------------------------------------------------------------------*/
 /**
@@ -242,12 +289,14 @@ typedef struct mqtt_client_config {
 static char client_id[BUFFER_SIZE];
 static char pub_topic[BUFFER_SIZE];
 static char sub_topic[BUFFER_SIZE];
+static char time_req_topic[BUFFER_SIZE];
+static char config_topic[BUFFER_SIZE];
 /*---------------------------------------------------------------------------*/
 /*
 * The main MQTT buffers.
 * We will need to increase if we start publishing more data.
 */
-#define APP_BUFFER_SIZE 600
+#define APP_BUFFER_SIZE 720
 static struct mqtt_connection conn;
 static char app_buffer[APP_BUFFER_SIZE];
 /*---------------------------------------------------------------------------*/
@@ -259,10 +308,32 @@ static struct ctimer ct_led;
 static char *buf_ptr;
 static uint16_t seq_nr_value = 0;
 /*---------------------------------------------------------------------------*/
-/* Parent RSSI functionality */
-static struct uip_icmp6_echo_reply_notification echo_reply_notification;
+/*
+* Parent link quality is read from the link-stats of the RPL preferred parent,
+* kept up to date by our own traffic and the parent's DIOs. The parent is only
+* probed with an echo request when those stats have gone stale.
+*/
 static struct etimer echo_request_timer;
-static int def_rt_rssi = 0;
+static uint16_t link_probe_count;
+/*---------------------------------------------------------------------------*/
+/* Time synchronization, epoch (ms) = uptime (ms) + epoch_offset_ms */
+static struct etimer time_sync_timer;
+static char time_req_buffer[32];
+static int64_t epoch_offset_ms;
+static uint64_t time_sync_t1;
+static uint8_t time_synced;
+static uint8_t collect_reschedule_pending;
+static unsigned long collect_timestamp;
+/*---------------------------------------------------------------------------*/
+/* Runtime configuration (cmd/config), see apc-node-config.h */
+static const apc_node_config_t default_node_config = {
+	APC_SENSOR_NODE_READ_INTERVAL_SECONDS,
+	DEFAULT_PUBLISH_INTERVAL / CLOCK_SECOND,
+	DEFAULT_RSSI_MEAS_INTERVAL / CLOCK_SECOND,
+	(1UL << SENSOR_COUNT) - 1
+};
+static struct etimer config_reply_timer;
+static char config_reply_buffer[CONFIG_NODE_REPLY_LEN];
 /*---------------------------------------------------------------------------*/
 static mqtt_client_config_t conf;
 /* MQTT-specific Configuration END (code copied from cc2538-common/mqtt-demo)*/
@@ -557,12 +628,12 @@ read_sensor
 		} while (value == DHT22_BUSY);
 		if (value != DHT22_ERROR) {
 			sprintf(sensor_infos[index].sensor_reading,
-			"%d.%d",
-			value / 10, value % 10
+			"%s%d.%d",
+			value < 0 ? "-" : "", abs(value) / 10, abs(value) % 10
 			);
 			PRINTF("-----------------\n");
 			PRINTF("read_sensor: TEMPERATURE_T \n");
-			PRINTF("Temperature %d.%d deg. C\n", value / 10, value % 10);
+			PRINTF("Temperature %s deg. C\n", sensor_infos[index].sensor_reading);
 			PRINTF("-----------------\n");
 			// reflect values in aqs sensor
 			aqs_temperature =  value;
@@ -837,13 +908,160 @@ ipaddr_sprintf(char *buf, uint8_t buf_len, const uip_ipaddr_t *addr)
 	return len;
 }
 /*---------------------------------------------------------------------------*/
+static uint64_t
+uptime_millis(void)
+{
+	return ((uint64_t)clock_time() * 1000) / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+/* Ticks from now until the next epoch instant t where t % period_ms == phase_ms */
+static clock_time_t
+ticks_until_aligned(uint64_t period_ms, uint64_t phase_ms)
+{
+	uint64_t now = uptime_millis() + epoch_offset_ms;
+	uint64_t next = now - (now % period_ms) + (phase_ms % period_ms);
+
+	if (next <= now)
+		next += period_ms;
+	return (clock_time_t)(((next - now) * CLOCK_SECOND) / 1000);
+}
+/*---------------------------------------------------------------------------*/
+static uint64_t
+publish_slot_millis(void)
+{
+	return (linkaddr_node_addr.u8[LINKADDR_SIZE - 1] % APC_TIME_SYNC_PUBLISH_SLOTS) * APC_TIME_SYNC_SLOT_MS;
+}
+/*---------------------------------------------------------------------------*/
+/* Delay until the next publish, on our epoch slot once synchronized */
+static clock_time_t
+next_publish_delay(void)
+{
+	if (!time_synced)
+		return conf.pub_interval;
+	return ticks_until_aligned(((uint64_t)conf.pub_interval * 1000) / CLOCK_SECOND,
+		publish_slot_millis() + APC_TIME_SYNC_COLLECT_LEAD_MS);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_time_request(void)
+{
+	int len;
+
+	time_sync_t1 = uptime_millis();
+	len = snprintf(time_req_buffer, sizeof(time_req_buffer), "{\"t1\":%llu}", time_sync_t1);
+	if(len < 0 || len >= sizeof(time_req_buffer)) {
+		printf("Buffer too short. Have %d, need %d + \\0\n", (int)sizeof(time_req_buffer), len);
+		return;
+	}
+	mqtt_publish(&conn, NULL, time_req_topic, (uint8_t *)time_req_buffer,
+	len, MQTT_QOS_LEVEL_0, MQTT_RETAIN_OFF);
+	DBG("APP - Time request (t1=%llu)\n", time_sync_t1);
+}
+/*---------------------------------------------------------------------------*/
+/*
+* Reply to a time request, payload: "t1,t2,t3"
+* t1: our uptime (ms) when the request was sent, echoed back
+* t2, t3: subscriber epoch time (ms) at request reception and reply transmission
+*/
+static void
+time_sync_handler(const uint8_t *chunk, uint16_t chunk_len)
+{
+	char buf[64];
+	char *ptr;
+	uint64_t t1, t2, t3, t4, rtt;
+
+	t4 = uptime_millis();
+	if (time_sync_t1 == 0 || chunk_len >= sizeof(buf)) {
+		return;
+	}
+	memcpy(buf, chunk, chunk_len);
+	buf[chunk_len] = '\0';
+
+	t1 = strtoull(buf, &ptr, 10);
+	if (*ptr != ',')
+		return;
+	t2 = strtoull(ptr + 1, &ptr, 10);
+	if (*ptr != ',')
+		return;
+	t3 = strtoull(ptr + 1, NULL, 10);
+	if (t1 != time_sync_t1 || t3 < t2) {
+		PRINTF("time_sync_handler: stale or malformed reply, ignoring\n");
+		return;
+	}
+	rtt = (t4 - t1) - (t3 - t2);
+	if (rtt > APC_TIME_SYNC_MAX_RTT_MS) {
+		PRINTF("time_sync_handler: round trip too long (%llu ms), ignoring\n", rtt);
+		return;
+	}
+	epoch_offset_ms = ((int64_t)(t2 - t1) + ((int64_t)t3 - (int64_t)t4)) / 2;
+	time_sync_t1 = 0;
+	time_synced = 1;
+	PRINTF("time_sync_handler: offset %lld ms, rtt %llu ms\n", epoch_offset_ms, rtt);
+
+	//the collection process may be mid-sweep, let it realign when it is done
+	collect_reschedule_pending = 1;
+	process_poll(&apc_sensor_node_collect_gather_process);
+
+	//MQTT callbacks run in the mqtt process, our timers belong to mqtt_handler_process
+	PROCESS_CONTEXT_BEGIN(&mqtt_handler_process);
+	if (state == STATE_PUBLISHING) {
+		etimer_set(&publish_periodic_timer, next_publish_delay());
+	}
+	etimer_set(&time_sync_timer, APC_TIME_SYNC_INTERVAL);
+	PROCESS_CONTEXT_END(&mqtt_handler_process);
+}
+/*---------------------------------------------------------------------------*/
+/* Apply apc_node_config to the running timers, call from mqtt_handler_process */
 static void
-echo_reply_handler(uip_ipaddr_t *source, uint8_t ttl, uint8_t *data,
-uint16_t datalen)
+apply_node_config(void)
 {
-	if(uip_ip6addr_cmp(source, uip_ds6_defrt_choose())) {
-		def_rt_rssi = sicslowpan_get_last_rssi();
+	conf.pub_interval = apc_node_config.publish_interval * CLOCK_SECOND;
+	conf.def_rt_ping_interval = apc_node_config.ping_interval * CLOCK_SECOND;
+	etimer_set(&echo_request_timer, conf.def_rt_ping_interval);
+	if (state == STATE_PUBLISHING) {
+		etimer_set(&publish_periodic_timer, next_publish_delay());
 	}
+	collect_reschedule_pending = 1;
+	process_poll(&apc_sensor_node_collect_gather_process);
+}
+/*---------------------------------------------------------------------------*/
+static void
+config_handler(const uint8_t *chunk, uint16_t chunk_len)
+{
+	char cmd[CONFIG_NODE_CMD_LEN];
+	int res = APC_NODE_CONFIG_UNCHANGED;
+
+	if (chunk_len >= sizeof(cmd)) {
+		snprintf(config_reply_buffer, sizeof(config_reply_buffer), "{\"ok\":0,\"error\":\"length\"}");
+	} else {
+		memcpy(cmd, chunk, chunk_len);
+		cmd[chunk_len] = '\0';
+		res = apc_node_config_command(cmd, config_reply_buffer, sizeof(config_reply_buffer));
+	}
+	//MQTT callbacks run in the mqtt process, our timers belong to mqtt_handler_process
+	PROCESS_CONTEXT_BEGIN(&mqtt_handler_process);
+	if (res == APC_NODE_CONFIG_CHANGED) {
+		apply_node_config();
+	}
+	//the reply is published once the connection is free
+	etimer_set(&config_reply_timer, 0);
+	PROCESS_CONTEXT_END(&mqtt_handler_process);
+}
+/*---------------------------------------------------------------------------*/
+static rpl_parent_t *
+get_preferred_parent(void)
+{
+	rpl_dag_t *dag = rpl_get_any_dag();
+
+	return dag != NULL ? dag->preferred_parent : NULL;
+}
+/*---------------------------------------------------------------------------*/
+static const struct link_stats *
+get_parent_link_stats(void)
+{
+	rpl_parent_t *parent = get_preferred_parent();
+
+	return parent != NULL ? rpl_get_parent_link_stats(parent) : NULL;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -877,6 +1095,16 @@ uint16_t chunk_len)
 		}
 		return;
 	}
+	else if(strncmp(&topic[16], "config", 6) == 0){
+		PRINTF("received command: config\n");
+		config_handler(chunk, chunk_len);
+		return;
+	}
+	else if(strncmp(&topic[16], "time-sync", 9) == 0){
+		PRINTF("received command: time-sync\n");
+		time_sync_handler(chunk, chunk_len);
+		return;
+	}
 	else if(strncmp(&topic[16], "timer-reset", 9) == 0){
 		PRINTF("received command: timer-reset\n");
 		if(chunk[0] == '1') {
@@ -893,6 +1121,7 @@ mqtt_event(struct mqtt_connection *m, mqtt_event_t event, void *data)
 	switch(event) {
 	case MQTT_EVENT_CONNECTED: {
 			DBG("APP - Application has a MQTT connection\n");
+			SIM_EVENT("connected\n");
 			timer_set(&connection_life, CONNECTION_STABLE_TIME);
 			state = STATE_CONNECTED;
 			break;
@@ -950,6 +1179,21 @@ construct_pub_topic(void)
 }
 /*---------------------------------------------------------------------------*/
 static int
+construct_event_topic(char *topic, const char *event_type_id)
+{
+	int len = snprintf(topic, BUFFER_SIZE, "%s/%s/evt/%s/fmt/json",
+			APC_SENSOR_TOPIC_NAME,
+			APC_SENSOR_MOTE_ID,
+			event_type_id);
+	/* len < 0: Error. Len >= BUFFER_SIZE: Buffer too small */
+	if(len < 0 || len >= BUFFER_SIZE) {
+		printf("Event Topic (%s): %d, Buffer %d\n", event_type_id, len, BUFFER_SIZE);
+		return 0;
+	}
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
 construct_sub_topic(void)
 {
 	int len = snprintf(sub_topic, BUFFER_SIZE, "%s/%s/cmd/%s/fmt/json",
@@ -998,6 +1242,12 @@ update_config(void)
 		state = STATE_CONFIG_ERROR;
 		return;
 	}
+	if(construct_event_topic(time_req_topic, TIME_REQ_EVENT_TYPE_ID) == 0 ||
+			construct_event_topic(config_topic, CONFIG_EVENT_TYPE_ID) == 0) {
+		/* Fatal error. Topic larger than the buffer */
+		state = STATE_CONFIG_ERROR;
+		return;
+	}
 	/* Reset the counter */
 	seq_nr_value = 0;
 	state = STATE_INIT;
@@ -1026,8 +1276,8 @@ init_config()
 	memcpy(conf.broker_ip, broker_ip, strlen(broker_ip));
 	memcpy(conf.cmd_type, DEFAULT_SUBSCRIBE_CMD_TYPE, 1);
 	conf.broker_port = DEFAULT_BROKER_PORT;
-	conf.pub_interval = DEFAULT_PUBLISH_INTERVAL;
-	conf.def_rt_ping_interval = DEFAULT_RSSI_MEAS_INTERVAL;
+	conf.pub_interval = apc_node_config.publish_interval * CLOCK_SECOND;
+	conf.def_rt_ping_interval = apc_node_config.ping_interval * CLOCK_SECOND;
 	return 1;
 }
 /*---------------------------------------------------------------------------*/
@@ -1144,6 +1394,7 @@ publish(void)
 	/* Publish MQTT topic in IBM quickstart format */
 	int len;
 	int remaining = APP_BUFFER_SIZE;
+	mqtt_status_t status;
 	seq_nr_value++;
 	buf_ptr = app_buffer;
 	len = snprintf(buf_ptr, remaining,
@@ -1151,8 +1402,9 @@ publish(void)
 	"\"collector_info\":{"
 	"\"myName\":\"%s\","
 	"\"Seq #\":%d,"
-	"\"Uptime (sec)\":%lu",
-	BOARD_STRING, seq_nr_value, clock_seconds());
+	"\"Uptime (sec)\":%lu,"
+	"\"Timestamp\":%lu",
+	BOARD_STRING, seq_nr_value, clock_seconds(), collect_timestamp);
 	if(len < 0 || len >= remaining) {
 		printf("Buffer too short. Have %d, need %d + \\0\n", remaining, len);
 		return;
@@ -1163,14 +1415,42 @@ publish(void)
 	char def_rt_str[64];
 	memset(def_rt_str, 0, sizeof(def_rt_str));
 	ipaddr_sprintf(def_rt_str, sizeof(def_rt_str), uip_ds6_defrt_choose());
-	len = snprintf(buf_ptr, remaining, ",\"Def Route\":\"%s\",\"RSSI (dBm)\":%d",
-	def_rt_str, def_rt_rssi);
+	len = snprintf(buf_ptr, remaining, ",\"Def Route\":\"%s\"", def_rt_str);
 	if(len < 0 || len >= remaining) {
 		printf("Buffer too short. Have %d, need %d + \\0\n", remaining, len);
 		return;
 	}
 	remaining -= len;
 	buf_ptr += len;
+	/* Link to the preferred parent, RSSI 0 and ETX 0 until it has been heard */
+	rpl_dag_t *dag = rpl_get_any_dag();
+	rpl_parent_t *parent = get_preferred_parent();
+	const struct link_stats *stats = get_parent_link_stats();
+	uint16_t etx = stats != NULL ? stats->etx : 0;
+	len = snprintf(buf_ptr, remaining,
+	",\"RSSI (dBm)\":%d,\"ETX\":%u.%02u,\"Rank\":%u,\"Parent Rank\":%u,\"Link Probes\":%u",
+	stats != NULL ? stats->rssi : 0,
+	etx / LINK_STATS_ETX_DIVISOR, (etx % LINK_STATS_ETX_DIVISOR) * 100 / LINK_STATS_ETX_DIVISOR,
+	dag != NULL ? dag->rank : RPL_INFINITE_RANK,
+	parent != NULL ? parent->rank : RPL_INFINITE_RANK,
+	link_probe_count);
+	if(len < 0 || len >= remaining) {
+		printf("Buffer too short. Have %d, need %d + \\0\n", remaining, len);
+		return;
+	}
+	remaining -= len;
+	buf_ptr += len;
+#if UIP_STATISTICS
+	/* TCP segments sent and retransmitted since boot, mostly our own MQTT traffic */
+	len = snprintf(buf_ptr, remaining, ",\"TCP Sent\":%u,\"TCP Rexmit\":%u",
+	uip_stat.tcp.sent, uip_stat.tcp.rexmit);
+	if(len < 0 || len >= remaining) {
+		printf("Buffer too short. Have %d, need %d + \\0\n", remaining, len);
+		return;
+	}
+	remaining -= len;
+	buf_ptr += len;
+#endif
 	/* Put our preferred address string representation in a buffer */
 	char pref_addr_str[64];
 	memset(pref_addr_str, 0, sizeof(pref_addr_str));
@@ -1226,8 +1506,9 @@ publish(void)
 	remaining -= len;
 	buf_ptr += len;
 
-	mqtt_publish(&conn, NULL, pub_topic, (uint8_t *)app_buffer,
+	status = mqtt_publish(&conn, NULL, pub_topic, (uint8_t *)app_buffer,
 	strlen(app_buffer), MQTT_QOS_LEVEL_0, MQTT_RETAIN_OFF);
+	SIM_EVENT("pub %d %d\n", seq_nr_value, status);
 	DBG("APP - Publish!\n");
 }
 /*---------------------------------------------------------------------------*/
@@ -1246,6 +1527,11 @@ ping_parent(void)
 	if(uip_ds6_get_global(ADDR_PREFERRED) == NULL) {
 		return;
 	}
+	/* Recent traffic with the parent already measured the link */
+	if(link_stats_is_fresh(get_parent_link_stats())) {
+		return;
+	}
+	link_probe_count++;
 	uip_icmp6_send(uip_ds6_defrt_choose(), ICMP6_ECHO_REQUEST, 0,
 	ECHO_REQ_PAYLOAD_LEN);
 }
@@ -1282,6 +1568,10 @@ state_machine(void)
 		if(uip_ds6_get_global(ADDR_PREFERRED) != NULL) {
 			/* Registered and with a public IP. Connect */
 			DBG("Registered. Connect attempt %u\n", connect_attempt);
+			if(!joined) {
+				joined = 1;
+				SIM_EVENT("join\n");
+			}
 			ping_parent();
 			connect_to_broker();
 		} else {
@@ -1394,14 +1684,21 @@ PROCESS_THREAD(apc_sensor_node_collect_gather_process, ev, data)
 	PROCESS_BEGIN();
 	PRINTF("APC Sensor Node (Collector Gather) begins...\n");
 
-	etimer_set(&et_collect, CLOCK_SECOND * APC_SENSOR_NODE_READ_INTERVAL_SECONDS);
+	etimer_set(&et_collect, CLOCK_SECOND * apc_node_config.collect_interval);
 	while (1)
 	{
 		PROCESS_YIELD();
 		if (ev == PROCESS_EVENT_TIMER && data == &et_collect) {
 			PRINTF("apc_sensor_node_collect_gather_process: starting collection\n");
+			//epoch seconds of this sweep, 0 until synchronized with the subscriber
+			collect_timestamp = time_synced ? (uptime_millis() + epoch_offset_ms) / 1000 : 0;
 			// collect general sensor data
 			for (index = 0; index < SENSOR_COUNT; index++){
+				if (!(apc_node_config.sensor_mask & (1UL << index))){
+					//disabled sensors are published as -1
+					sensor_infos[index].sensor_reading[0] = '\0';
+					continue;
+				}
 				read_sensor(sensor_infos[index].sensor_type);
 
 				etimer_set(&et_read_wait, APC_SENSOR_NODE_READ_WAIT_MILLIS);
@@ -1429,7 +1726,19 @@ PROCESS_THREAD(apc_sensor_node_collect_gather_process, ev, data)
 				}
 			}
 			PRINTF("apc_sensor_node_collect_gather_process: collection finished\n");
-			etimer_reset(&et_collect);
+			//the first period after an alignment is shorter, restore the interval
+			etimer_reset_with_new_interval(&et_collect, CLOCK_SECOND * apc_node_config.collect_interval);
+		}
+		//new interval or new epoch alignment
+		if (collect_reschedule_pending){
+			collect_reschedule_pending = 0;
+			if (time_synced) {
+				etimer_set(&et_collect, ticks_until_aligned(apc_node_config.collect_interval * 1000ULL,
+					publish_slot_millis()));
+			} else {
+				etimer_set(&et_collect, CLOCK_SECOND * apc_node_config.collect_interval);
+			}
+			PRINTF("%s: collection timer rescheduled\n", apc_sensor_node_collect_gather_process.name);
 		}
 		if (ev == PROCESS_EVENT_RESET_TIMERS){
 			etimer_restart(&et_collect);
@@ -1448,6 +1757,8 @@ PROCESS_THREAD(apc_sensor_node_en_sensors_process, ev, data)
 	PROCESS_EXITHANDLER();
 	PROCESS_BEGIN();
 	PRINTF("APC Sensor Node (Sensor Initialization) begins...\n");
+	//saved runtime configuration, used by the collection and MQTT processes
+	apc_node_config_init(&default_node_config);
 	leds_on(LEDS_YELLOW);
 	//initialize sensor types and configure
 	for (i = 0; i < SENSOR_COUNT; i++) {
@@ -1491,10 +1802,16 @@ PROCESS_THREAD(mqtt_handler_process, ev, data)
 		PROCESS_EXIT();
 	}
 	update_config();
-	def_rt_rssi = 0x8000000;
-	uip_icmp6_echo_reply_callback_add(&echo_reply_notification,
-	echo_reply_handler);
+#if WITH_TSCH
+	//collectors join the TSCH network; the uplink cell follows the RPL parent
+	apc_tsch_schedule_init(0);
+	NETSTACK_MAC.on();
+#endif
+#if WITH_POWERTRACE
+	powertrace_start(CLOCK_SECOND * APC_SENSOR_NODE_POWERTRACE_INTERVAL_SECONDS);
+#endif
 	etimer_set(&echo_request_timer, conf.def_rt_ping_interval);
+	etimer_set(&time_sync_timer, APC_TIME_SYNC_RETRY_INTERVAL);
 	/* Main loop */
 	while(1) {
 		PROCESS_YIELD();
@@ -1506,6 +1823,22 @@ PROCESS_THREAD(mqtt_handler_process, ev, data)
 			ping_parent();
 			etimer_set(&echo_request_timer, conf.def_rt_ping_interval);
 		}
+		if(ev == PROCESS_EVENT_TIMER && data == &config_reply_timer) {
+			//kept until the node is publishing again, e.g. after a reconnect
+			if(state == STATE_PUBLISHING && mqtt_ready(&conn) && conn.out_buffer_sent) {
+				mqtt_publish(&conn, NULL, config_topic, (uint8_t *)config_reply_buffer,
+				strlen(config_reply_buffer), MQTT_QOS_LEVEL_0, MQTT_RETAIN_OFF);
+			} else {
+				etimer_set(&config_reply_timer, STATE_MACHINE_PERIODIC);
+			}
+		}
+		if(ev == PROCESS_EVENT_TIMER && data == &time_sync_timer) {
+			//retried until a reply arrives, the handler then backs off to APC_TIME_SYNC_INTERVAL
+			if(state == STATE_PUBLISHING && mqtt_ready(&conn) && conn.out_buffer_sent) {
+				send_time_request();
+			}
+			etimer_set(&time_sync_timer, APC_TIME_SYNC_RETRY_INTERVAL);
+		}
 		if (ev == PROCESS_EVENT_RESET_TIMERS){
 			etimer_restart(&publish_periodic_timer);
 			PRINTF("%s: reset signal received, resetting MQTT publish timer\n", mqtt_handler_process.name);
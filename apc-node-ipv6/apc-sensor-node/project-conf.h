@@ -4,10 +4,18 @@
 /*----------------------------------------------------------------*/
 /*------------------SENSOR-CONFIGURATION-------------------------*/
 /*----------------------------------------------------------------*/
+#if CONTIKI_TARGET_COOJA
+// simulated motes (sim-sensors.c): read every 30 seconds, publish every 2 minutes
+#define APC_SENSOR_NODE_READ_INTERVAL_SECONDS_CONF                  30
+#define PUBLISH_CONF_INTERVAL_SEC                                   120
+#else
 // make a reading every 5 minutes
 #define APC_SENSOR_NODE_READ_INTERVAL_SECONDS_CONF                  300
 // publish readings every 60 minutes
 #define PUBLISH_CONF_INTERVAL_SEC                                   3600
+#endif /* CONTIKI_TARGET_COOJA */
+/* flash reserved for the runtime configuration (cmd/config) saved by apc-node-config.c */
+#define COFFEE_CONF_SIZE                                            (4 * COFFEE_SECTOR_SIZE)
 /* designated id for mote */
 #define MOTE_ID                         056
 #define FORCE_CALIBRATION               0
@@ -107,12 +115,18 @@
 /*------------------------IP-CONFIGURATION------------------------*/
 /*----------------------------------------------------------------*/
 #define MQTT_CONF_BROKER_IP_ADDR        "FD00::1"
+#if CONTIKI_TARGET_COOJA
+// every simulated mote publishes under its Cooja node id
+#define APC_SENSOR_MOTE_ID_CONF         sim_sensors_mote_id()
+#define MQTT_CONF_STATUS_LED            LEDS_GREEN
+#else
 #if MOTE_ID == 056
 #define APC_SENSOR_MOTE_ID_CONF         "056"
 #elif MOTE_ID == 113
 #define APC_SENSOR_MOTE_ID_CONF         "113"
 #endif
 #define MQTT_CONF_STATUS_LED            LEDS_WHITE
+#endif /* CONTIKI_TARGET_COOJA */
 /*----------------------------------------------------------------*/
 /*This code was taken from rpl-collect example found in example/ipv6*/
 /*----------------------------------------------------------------*/
@@ -120,23 +134,37 @@
 #define WITH_NON_STORING 0 /* Set this to run with non-storing mode */
 #endif /* WITH_NON_STORING */
 
-#undef NBR_TABLE_CONF_MAX_NEIGHBORS
-#undef UIP_CONF_MAX_ROUTES
-
+/* make MAX_NEIGHBORS=<n> MAX_ROUTES=<n> overrides these (scale tests) */
+#ifndef NBR_TABLE_CONF_MAX_NEIGHBORS
 #ifdef TEST_MORE_ROUTES
-/* configure number of neighbors and routes */
 #define NBR_TABLE_CONF_MAX_NEIGHBORS     10
-#define UIP_CONF_MAX_ROUTES              40
 #else
-/* configure number of neighbors and routes */
 #define NBR_TABLE_CONF_MAX_NEIGHBORS     5
+#endif /* TEST_MORE_ROUTES */
+#endif /* NBR_TABLE_CONF_MAX_NEIGHBORS */
+
+#ifndef UIP_CONF_MAX_ROUTES
+#ifdef TEST_MORE_ROUTES
+#define UIP_CONF_MAX_ROUTES              40
+#else
 #define UIP_CONF_MAX_ROUTES              10
 #endif /* TEST_MORE_ROUTES */
+#endif /* UIP_CONF_MAX_ROUTES */
 
+#ifndef WITH_TSCH
+#define WITH_TSCH 0 /* Set this to run over TSCH instead of nullrdc (make MAKE_WITH_TSCH=1) */
+#endif /* WITH_TSCH */
+
+#if WITH_TSCH
+#include "../apc-tsch-conf.h"
+/* Set to 1 if this collector has children in the DAG */
+#define APC_TSCH_CONF_RELAY              0
+#else
 #undef NETSTACK_CONF_RDC
 #define NETSTACK_CONF_RDC     nullrdc_driver
 #undef NULLRDC_CONF_802154_AUTOACK
 #define NULLRDC_CONF_802154_AUTOACK       1
+#endif /* WITH_TSCH */
 
 /* Define as minutes */
 #define RPL_CONF_DEFAULT_LIFETIME_UNIT   60
@@ -155,6 +183,10 @@
 #define SICSLOWPAN_CONF_FRAG           1
 /* END - Save some ROM */
 
+/* uip_stat TCP counters are published with the link telemetry */
+#undef UIP_CONF_STATISTICS
+#define UIP_CONF_STATISTICS            1
+
 #if WITH_NON_STORING
 #undef RPL_NS_CONF_LINK_NUM
 #define RPL_NS_CONF_LINK_NUM 10 /* Number of links maintained at the root. Can be set to 0 at non-root nodes. */
@@ -0,0 +1,355 @@
+/**
+ * \file
+ *         Simulated sensors of the sensor node for Cooja, see sim-sensors.h
+ */
+#include <stdio.h>
+
+#include "contiki.h"
+#include "lib/random.h"
+#include "sys/node-id.h"
+
+#include "sim-sensors.h"
+/*---------------------------------------------------------------------------*/
+#define SIM_DHT22                    0x01
+#define SIM_PM25                     0x02
+#define SIM_MICS4514                 0x04
+#define SIM_MQ131                    0x08
+#define SIM_WIND_SPEED               0x10
+#define SIM_WIND_DIR                 0x20
+#define SIM_MQ7                      0x40
+#define SIM_MQ135                    0x80
+#define SIM_ADC                      0x100
+/* gas sensors by their configure value (MQ7_SENSOR to MICS4514_SENSOR) */
+#define GAS_SENSORS                  4
+/*---------------------------------------------------------------------------*/
+int16_t aqs_temperature;
+uint8_t aqs_humidity;
+/*---------------------------------------------------------------------------*/
+static const uint8_t gas_bits[GAS_SENSORS] = {
+	SIM_MQ7, SIM_MQ131, SIM_MQ135, SIM_MICS4514
+};
+static uint16_t enabled;
+static unsigned long gas_enabled_at[GAS_SENSORS];
+static char mote_id[6];
+/*---------------------------------------------------------------------------*/
+/* 0 at midnight, 1000 at midday and back, shifted a little for every mote */
+static int32_t
+daily_swing(void)
+{
+	unsigned long day = SIM_SENSORS_DAY_SECONDS;
+	unsigned long phase = (clock_seconds() + node_id * (day / 97)) % day;
+
+	if(phase > day / 2) {
+		phase = day - phase;
+	}
+	return (int32_t)(phase * 2000 / day);
+}
+/*---------------------------------------------------------------------------*/
+/* Uniform in [-range, range] */
+static int32_t
+noise(int32_t range)
+{
+	return (int32_t)(random_rand() % (2 * range + 1)) - range;
+}
+/*---------------------------------------------------------------------------*/
+static int
+fails(void)
+{
+	return SIM_SENSORS_FAIL_PERCENT > 0 &&
+		random_rand() % 100 < SIM_SENSORS_FAIL_PERCENT;
+}
+/*---------------------------------------------------------------------------*/
+static int
+enable(uint16_t sensor, int on)
+{
+	int gas;
+
+	if(on) {
+		for(gas = 0; gas < GAS_SENSORS; gas++) {
+			if(sensor == gas_bits[gas] && !(enabled & sensor)) {
+				gas_enabled_at[gas] = clock_seconds();
+			}
+		}
+		enabled |= sensor;
+	} else {
+		enabled &= ~sensor;
+	}
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dht22_value(int type)
+{
+	if(!(enabled & SIM_DHT22) || fails()) {
+		return DHT22_ERROR;
+	}
+	switch(type) {
+	case DHT22_READ_ALL:
+		return DHT22_SUCCESS;
+	case DHT22_READ_TEMP:
+		return 240 + node_id % 20 + daily_swing() * 80 / 1000 + noise(3);
+	case DHT22_READ_HUM:
+		return 800 - node_id % 50 - daily_swing() * 250 / 1000 + noise(10);
+	default:
+		return DHT22_ERROR;
+	}
+}
+/*---------------------------------------------------------------------------*/
+static int
+dht22_configure(int type, int value)
+{
+	if(type != SENSORS_ACTIVE) {
+		return DHT22_ERROR;
+	}
+	return enable(SIM_DHT22, value) == 0 ? DHT22_SUCCESS : DHT22_ERROR;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dht22_status(int type)
+{
+	return (enabled & SIM_DHT22) != 0;
+}
+/*---------------------------------------------------------------------------*/
+SENSORS_SENSOR(dht22, "DHT22 sensor", dht22_value, dht22_configure, dht22_status);
+/*---------------------------------------------------------------------------*/
+int
+dht22_read_all(int *temperature, int *humidity)
+{
+	*temperature = dht22_value(DHT22_READ_TEMP);
+	*humidity = dht22_value(DHT22_READ_HUM);
+	if(*temperature == DHT22_ERROR || *humidity == DHT22_ERROR) {
+		return DHT22_ERROR;
+	}
+	return DHT22_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+static int
+pm25_value(int type)
+{
+	if(!(enabled & SIM_PM25) || fails()) {
+		return PM25_ERROR;
+	}
+	return 15 + (node_id * 7) % 20 + daily_swing() * 20 / 1000 + noise(5);
+}
+/*---------------------------------------------------------------------------*/
+static int
+pm25_configure(int type, int value)
+{
+	if(type != SENSORS_ACTIVE) {
+		return PM25_ERROR;
+	}
+	enable(SIM_PM25, value == PM25_ENABLE);
+	return PM25_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+static int
+pm25_status(int type)
+{
+	return (enabled & SIM_PM25) != 0;
+}
+/*---------------------------------------------------------------------------*/
+SENSORS_SENSOR(pm25, "PM25 sensor", pm25_value, pm25_configure, pm25_status);
+/*---------------------------------------------------------------------------*/
+static int
+preheating(unsigned long enabled_at)
+{
+	return clock_seconds() - enabled_at < SIM_SENSORS_PREHEAT_SECONDS;
+}
+/*---------------------------------------------------------------------------*/
+int64_t
+aqs_value(int type)
+{
+	//value and calibration types of a sensor share the low nibble
+	int gas = type & 0x0F;
+
+	if(gas >= GAS_SENSORS) {
+		gas = MICS4514_SENSOR;
+	}
+	if(!(enabled & gas_bits[gas]) || fails()) {
+		return AQS_ERROR;
+	}
+	if(preheating(gas_enabled_at[gas])) {
+		return AQS_INITIALIZING;
+	}
+	switch(type) {
+	case MQ7_SENSOR:
+		return 900 + daily_swing() / 3 + noise(40);
+	case MQ135_SENSOR:
+		return 1500 - daily_swing() / 4 + noise(60);
+	case MICS4514_SENSOR_RED:
+		return 800 + daily_swing() / 4 + noise(40);
+	case MICS4514_SENSOR_NOX:
+		return 1200 - daily_swing() / 5 + noise(60);
+	case MQ131_SENSOR:
+		return 1000 + daily_swing() / 2 + noise(50);
+	/* clean air resistances of mote 056 */
+	case MICS4514_SENSOR_RED_RO:
+		return 247027590LL + noise(1000);
+	case MICS4514_SENSOR_NOX_RO:
+		return 11712528LL + noise(1000);
+	case MQ131_SENSOR_RO:
+		return 422852364LL + noise(1000);
+	case MQ7_SENSOR_RO:
+	case MQ135_SENSOR_RO:
+		return 10000000LL + noise(1000);
+	default:
+		return AQS_ERROR;
+	}
+}
+/*---------------------------------------------------------------------------*/
+static int
+aqs_configure(int type, int value)
+{
+	if(value < 0 || value >= GAS_SENSORS) {
+		return AQS_ERROR;
+	}
+	enable(gas_bits[value], type == AQS_ENABLE);
+	return AQS_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+static int
+aqs_status(int type)
+{
+	return (enabled & (SIM_MQ7 | SIM_MQ131 | SIM_MQ135 | SIM_MICS4514)) != 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+aqs_sensor_value(int type)
+{
+	return (int)aqs_value(type);
+}
+/*---------------------------------------------------------------------------*/
+SENSORS_SENSOR(aqs_sensor, "AQS sensor", aqs_sensor_value, aqs_configure, aqs_status);
+/*---------------------------------------------------------------------------*/
+static int
+anem_value(int type)
+{
+	static const uint16_t directions[] = {
+		WIND_DIR_NORTH, WIND_DIR_NORTH | WIND_DIR_EAST,
+		WIND_DIR_EAST, WIND_DIR_SOUTH | WIND_DIR_EAST,
+		WIND_DIR_SOUTH, WIND_DIR_SOUTH | WIND_DIR_WEST,
+		WIND_DIR_WEST, WIND_DIR_NORTH | WIND_DIR_WEST
+	};
+
+	switch(type) {
+	case WIND_SPEED_SENSOR:
+		if(!(enabled & SIM_WIND_SPEED) || fails()) {
+			return WIND_SENSOR_ERROR;
+		}
+		return 150 + daily_swing() * 300 / 1000 + noise(50);
+	case WIND_DIR_SENSOR:
+		if(!(enabled & SIM_WIND_DIR) || fails()) {
+			return WIND_SENSOR_ERROR;
+		}
+		return directions[(daily_swing() / 250 + node_id) % 8];
+	default:
+		return WIND_SENSOR_ERROR;
+	}
+}
+/*---------------------------------------------------------------------------*/
+static int
+anem_configure(int type, int value)
+{
+	if(type != SENSORS_ACTIVE ||
+		(value != WIND_SPEED_SENSOR && value != WIND_DIR_SENSOR)) {
+		return WIND_SENSOR_ERROR;
+	}
+	enable(value == WIND_SPEED_SENSOR ? SIM_WIND_SPEED : SIM_WIND_DIR, 1);
+	return WIND_SENSOR_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+static int
+anem_status(int type)
+{
+	return (enabled & (SIM_WIND_SPEED | SIM_WIND_DIR)) != 0;
+}
+/*---------------------------------------------------------------------------*/
+SENSORS_SENSOR(anem_sensor, "Anemometer sensor", anem_value, anem_configure, anem_status);
+/*---------------------------------------------------------------------------*/
+static int
+adc_value(int type)
+{
+	if(!(enabled & SIM_ADC) || type < 0 || type > ADC128S022_ADC_MAX_CHANNEL) {
+		return ADC128S022_ERROR;
+	}
+	return (1024 + type * 256 + daily_swing() + noise(8)) & ADC128S022_ADC_MAX_LEVEL;
+}
+/*---------------------------------------------------------------------------*/
+static int
+adc_configure(int type, int value)
+{
+	switch(type) {
+	case ADC128S022_INIT:
+		if(value < 0 || value > ADC128S022_ADC_MAX_CHANNEL) {
+			return ADC128S022_ERROR;
+		}
+		enable(SIM_ADC, 1);
+		return ADC128S022_SUCCESS;
+	case ADC128S022_ACTIVE:
+		enable(SIM_ADC, value);
+		return ADC128S022_SUCCESS;
+	default:
+		return ADC128S022_ERROR;
+	}
+}
+/*---------------------------------------------------------------------------*/
+static int
+adc_status(int type)
+{
+	return (enabled & SIM_ADC) != 0;
+}
+/*---------------------------------------------------------------------------*/
+SENSORS_SENSOR(adc128s022, "ADC128S022 12-bit ADC", adc_value, adc_configure, adc_status);
+/*---------------------------------------------------------------------------*/
+int
+adc128s022_read_burst(const uint8_t *channels, uint8_t count, uint16_t *values)
+{
+	int value;
+	uint8_t i;
+
+	for(i = 0; i < count; i++) {
+		value = adc_value(channels[i]);
+		if(value == ADC128S022_ERROR) {
+			return ADC128S022_ERROR;
+		}
+		values[i] = value;
+	}
+	return ADC128S022_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+static int
+temp_value(int type)
+{
+	return 27000 + daily_swing() * 5 + noise(200);
+}
+/*---------------------------------------------------------------------------*/
+static int
+vdd3_value(int type)
+{
+	return 3300 + noise(10);
+}
+/*---------------------------------------------------------------------------*/
+static int
+onchip_configure(int type, int value)
+{
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+onchip_status(int type)
+{
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+SENSORS_SENSOR(cc2538_temp_sensor, "Temp sensor", temp_value, onchip_configure, onchip_status);
+SENSORS_SENSOR(vdd3_sensor, "VDD3 sensor", vdd3_value, onchip_configure, onchip_status);
+/*---------------------------------------------------------------------------*/
+const char *
+sim_sensors_mote_id(void)
+{
+	if(mote_id[0] == '\0') {
+		snprintf(mote_id, sizeof(mote_id), "%03u", node_id);
+	}
+	return mote_id;
+}
+/*---------------------------------------------------------------------------*/
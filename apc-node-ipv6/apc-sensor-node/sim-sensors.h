@@ -0,0 +1,121 @@
+#ifndef SIM_SENSORS_H_
+#define SIM_SENSORS_H_
+/*---------------------------------------------------------------------------*/
+/* Stand-in for the Zoul sensor drivers when a sensor node (IPv6 or Rime) is
+ * built for Cooja (make TARGET=cooja), or the driver benchmark for Cooja or
+ * native. Same sensor objects, value units and return codes as dev/dht22.h,
+ * dev/pm25-sensor.h, dev/air-quality-sensor.h, dev/anemometer-sensor.h,
+ * dev/adc128s022.h and dev/cc2538-sensors.h, so apc-sensor-node.c runs
+ * unchanged. Readings are synthetic: a slow daily swing, an offset per mote
+ * (node_id) and some noise from the simulation's random seed, so a run is
+ * repeatable.
+ */
+/*---------------------------------------------------------------------------*/
+#include <stdio.h>
+
+#include "contiki.h"
+#include "lib/sensors.h"
+/*---------------------------------------------------------------------------*/
+/* Percentage of readings that fail (return the driver's error code) */
+#ifdef SIM_SENSORS_CONF_FAIL_PERCENT
+#define SIM_SENSORS_FAIL_PERCENT     SIM_SENSORS_CONF_FAIL_PERCENT
+#else
+#define SIM_SENSORS_FAIL_PERCENT     0
+#endif
+/* Simulated seconds in one day of the daily swing, shorter days vary faster */
+#ifdef SIM_SENSORS_CONF_DAY_SECONDS
+#define SIM_SENSORS_DAY_SECONDS      SIM_SENSORS_CONF_DAY_SECONDS
+#else
+#define SIM_SENSORS_DAY_SECONDS      86400UL
+#endif
+/* Gas sensors report AQS_INITIALIZING for this long after being enabled */
+#ifdef SIM_SENSORS_CONF_PREHEAT_SECONDS
+#define SIM_SENSORS_PREHEAT_SECONDS  SIM_SENSORS_CONF_PREHEAT_SECONDS
+#else
+#define SIM_SENSORS_PREHEAT_SECONDS  10
+#endif
+/*---------------------------------------------------------------------------*/
+/* GPIO port numbers used by project-conf.h (dev/gpio.h) */
+#define GPIO_A_NUM                   0
+#define GPIO_B_NUM                   1
+#define GPIO_C_NUM                   2
+#define GPIO_D_NUM                   3
+/*---------------------------------------------------------------------------*/
+/* DHT22 (dev/dht22.h), tenths of %RH and of deg. C */
+#define DHT22_READ_HUM               0x01
+#define DHT22_READ_TEMP              0x02
+#define DHT22_READ_ALL               0x03
+#define DHT22_ERROR                  (-1)
+#define DHT22_SUCCESS                0x00
+#define DHT22_BUSY                   0xFF
+extern const struct sensors_sensor dht22;
+int dht22_read_all(int *temperature, int *humidity);
+/*---------------------------------------------------------------------------*/
+/* GP2Y1014AU0F (dev/pm25-sensor.h), ug/m3 */
+#define PM25_ERROR                   (-1)
+#define PM25_SUCCESS                 0x00
+#define PM25_ENABLE                  0x01
+extern const struct sensors_sensor pm25;
+/*---------------------------------------------------------------------------*/
+/* MICS4514 and MQ131 (dev/air-quality-sensor.h), Rs/Ro and Ro x 1000; MQ7
+ * and MQ135 for the Rime sensor node */
+#define MQ7_SENSOR                   0x00
+#define MQ131_SENSOR                 0x01
+#define MQ135_SENSOR                 0x02
+#define MICS4514_SENSOR              0x03
+#define MICS4514_SENSOR_NOX          0x03
+#define MICS4514_SENSOR_RED          0x04
+#define MQ7_SENSOR_RO                0xA0
+#define MQ131_SENSOR_RO              0xA1
+#define MQ135_SENSOR_RO              0xA2
+#define MICS4514_SENSOR_NOX_RO       0xA3
+#define MICS4514_SENSOR_RED_RO       0xA4
+#define AQS_ERROR                    (-1)
+#define AQS_SUCCESS                  0x00
+#define AQS_INITIALIZING             0x0F
+#define AQS_BUSY                     0xFF
+#define AQS_ENABLE                   SENSORS_ACTIVE
+#define AQS_DISABLE                  0x00
+extern const struct sensors_sensor aqs_sensor;
+int64_t aqs_value(int type);
+extern int16_t aqs_temperature;
+extern uint8_t aqs_humidity;
+/*---------------------------------------------------------------------------*/
+/* Anemometer and wind vane (dev/anemometer-sensor.h), m/s x 100 */
+#define WIND_SPEED_SENSOR            0x00
+#define WIND_DIR_SENSOR              0x01
+#define WIND_DIR_NORTH               0x0001
+#define WIND_DIR_EAST                0x0010
+#define WIND_DIR_SOUTH               0x1000
+#define WIND_DIR_WEST                0x0100
+#define WIND_SENSOR_ERROR            (-1)
+#define WIND_SENSOR_SUCCESS          0x00
+extern const struct sensors_sensor anem_sensor;
+/*---------------------------------------------------------------------------*/
+/* ADC128S022 external ADC (dev/adc128s022.h), 12-bit codes; every channel
+ * reads as initialized */
+#define ADC128S022_ACTIVE            SENSORS_ACTIVE
+#define ADC128S022_INIT              SENSORS_HW_INIT
+#define ADC128S022_ERROR             (-1)
+#define ADC128S022_SUCCESS           0x00
+#define ADC128S022_ENABLE            1
+#define ADC128S022_DISABLE           0
+#define ADC128S022_ADC_MAX_LEVEL     4095
+#define ADC128S022_ADC_MAX_CHANNEL   7
+extern const struct sensors_sensor adc128s022;
+int adc128s022_read_burst(const uint8_t *channels, uint8_t count, uint16_t *values);
+/*---------------------------------------------------------------------------*/
+/* On-chip sensors (dev/cc2538-sensors.h), mC and mV */
+#define CC2538_SENSORS_VALUE_TYPE_CONVERTED 1
+extern const struct sensors_sensor cc2538_temp_sensor;
+extern const struct sensors_sensor vdd3_sensor;
+/*---------------------------------------------------------------------------*/
+/* Mote id for the MQTT topics: the Cooja node id, zero-padded to 3 digits */
+const char *sim_sensors_mote_id(void);
+/*---------------------------------------------------------------------------*/
+/* Events of the node for the scale tests (cooja/scale-test.py), one
+ * "#sim <event> ..." line each in the mote output
+ */
+#define SIM_EVENT(...)               printf("#sim " __VA_ARGS__)
+/*---------------------------------------------------------------------------*/
+#endif /* SIM_SENSORS_H_ */
@@ -0,0 +1,40 @@
+#ifndef APC_TSCH_CONF_H
+#define APC_TSCH_CONF_H
+/*----------------------------------------------------------------*/
+/* TSCH build profile shared by apc-sensor-node and rpl-border-router,
+ * included from project-conf.h when built with MAKE_WITH_TSCH=1.
+ * The schedule itself is installed by apc-tsch-schedule.c.
+ */
+/*----------------------------------------------------------------*/
+#undef NETSTACK_CONF_MAC
+#define NETSTACK_CONF_MAC                    tschmac_driver
+#undef NETSTACK_CONF_RDC
+#define NETSTACK_CONF_RDC                    nordc_driver
+#undef FRAME802154_CONF_VERSION
+#define FRAME802154_CONF_VERSION             FRAME802154_IEEE802154E_2012
+
+/* The MAC is started by the application once the schedule is in place */
+#define TSCH_CONF_AUTOSTART                  0
+/* Use our own schedule instead of the 6TiSCH minimal one */
+#define TSCH_SCHEDULE_CONF_WITH_6TISCH_MINIMAL 0
+#define TSCH_SCHEDULE_CONF_MAX_LINKS         (APC_TSCH_CONF_UPLINK_SLOTFRAME_LENGTH + 4)
+#define TSCH_CONF_DEFAULT_HOPPING_SEQUENCE   TSCH_HOPPING_SEQUENCE_4_4
+
+/* Let RPL drive the time source and the uplink cell */
+#define RPL_CALLBACK_PARENT_SWITCH           apc_tsch_schedule_parent_switch
+#define TSCH_CALLBACK_JOINING_NETWORK        tsch_rpl_callback_joining_network
+#define TSCH_CALLBACK_LEAVING_NETWORK        tsch_rpl_callback_leaving_network
+
+#ifndef APC_TSCH_CONF_SHARED_SLOTFRAME_LENGTH
+#define APC_TSCH_CONF_SHARED_SLOTFRAME_LENGTH 33
+#endif
+#ifndef APC_TSCH_CONF_UPLINK_SLOTFRAME_LENGTH
+#define APC_TSCH_CONF_UPLINK_SLOTFRAME_LENGTH 11
+#endif
+
+#if CONTIKI_TARGET_ZOUL
+/* cc2538 frame filtering does not understand 802.15.4e frames */
+#define TSCH_CONF_HW_FRAME_FILTERING         0
+#endif
+/*----------------------------------------------------------------*/
+#endif /* APC_TSCH_CONF_H */
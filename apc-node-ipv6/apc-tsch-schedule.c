@@ -0,0 +1,99 @@
+/* C std libraries */
+#include <stdio.h>
+/* Contiki Core and Networking Libraries */
+#include "contiki.h"
+#include "net/linkaddr.h"
+#include "net/mac/tsch/tsch.h"
+#include "net/mac/tsch/tsch-schedule.h"
+#include "net/mac/tsch/tsch-rpl.h"
+#include "net/rpl/rpl.h"
+#include "net/rpl/rpl-private.h"
+/* Project Sourcefiles */
+#include "apc-tsch-schedule.h"
+/*---------------------------------------------------------------------------*/
+#define DEBUG 0
+#include "net/ip/uip-debug.h"
+/*---------------------------------------------------------------------------*/
+static struct tsch_slotframe *sf_uplink;
+static struct tsch_link *uplink_cell;
+static uint8_t schedule_is_root;
+/*---------------------------------------------------------------------------*/
+uint16_t
+apc_tsch_schedule_uplink_timeslot(void)
+{
+	//timeslot 0 of the uplink slotframe is left free: both slotframes start
+	//at ASN 0 and the shared length is a multiple of the uplink length, so
+	//the shared cell only ever coincides with uplink timeslot 0
+	return 1 + (linkaddr_node_addr.u8[LINKADDR_SIZE - 1] % (APC_TSCH_UPLINK_SLOTFRAME_LENGTH - 1));
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_uplink_cell(const linkaddr_t *parent)
+{
+	if (sf_uplink == NULL)
+		return;
+	if (uplink_cell != NULL) {
+		tsch_schedule_remove_link(sf_uplink, uplink_cell);
+		uplink_cell = NULL;
+	}
+	if (parent == NULL) {
+#if APC_TSCH_RELAY
+		//only one link per timeslot, give the relay its RX cell back
+		tsch_schedule_add_link(sf_uplink, LINK_OPTION_RX, LINK_TYPE_NORMAL,
+				&tsch_broadcast_address, apc_tsch_schedule_uplink_timeslot(),
+				APC_TSCH_UPLINK_CHANNEL_OFFSET);
+#endif
+		return;
+	}
+
+	//shared option: collectors whose addresses map to the same timeslot back off
+	uplink_cell = tsch_schedule_add_link(sf_uplink,
+			LINK_OPTION_TX | LINK_OPTION_SHARED | (APC_TSCH_RELAY ? LINK_OPTION_RX : 0),
+			LINK_TYPE_NORMAL, parent,
+			apc_tsch_schedule_uplink_timeslot(), APC_TSCH_UPLINK_CHANNEL_OFFSET);
+	PRINTF("apc_tsch_schedule: uplink cell at ts %u towards ", apc_tsch_schedule_uplink_timeslot());
+	PRINTLLADDR((const uip_lladdr_t *)parent);
+	PRINTF("\n");
+}
+/*---------------------------------------------------------------------------*/
+void
+apc_tsch_schedule_parent_switch(rpl_parent_t *old, rpl_parent_t *new)
+{
+	//keep the TSCH time source following the preferred parent
+	tsch_rpl_callback_parent_switch(old, new);
+
+	if (schedule_is_root)
+		return;
+	set_uplink_cell(new != NULL ? (const linkaddr_t *)rpl_get_parent_lladdr(new) : NULL);
+}
+/*---------------------------------------------------------------------------*/
+void
+apc_tsch_schedule_init(uint8_t is_root)
+{
+	struct tsch_slotframe *sf_shared;
+	uint16_t ts;
+
+	schedule_is_root = is_root;
+	tsch_schedule_remove_all_slotframes();
+
+	sf_shared = tsch_schedule_add_slotframe(APC_TSCH_SHARED_SLOTFRAME_HANDLE,
+			APC_TSCH_SHARED_SLOTFRAME_LENGTH);
+	tsch_schedule_add_link(sf_shared,
+			LINK_OPTION_TX | LINK_OPTION_RX | LINK_OPTION_SHARED | LINK_OPTION_TIME_KEEPING,
+			LINK_TYPE_ADVERTISING, &tsch_broadcast_address, 0, 0);
+
+	sf_uplink = tsch_schedule_add_slotframe(APC_TSCH_UPLINK_SLOTFRAME_HANDLE,
+			APC_TSCH_UPLINK_SLOTFRAME_LENGTH);
+	uplink_cell = NULL;
+
+	if (is_root || APC_TSCH_RELAY) {
+		for (ts = 1; ts < APC_TSCH_UPLINK_SLOTFRAME_LENGTH; ts++) {
+			tsch_schedule_add_link(sf_uplink, LINK_OPTION_RX, LINK_TYPE_NORMAL,
+					&tsch_broadcast_address, ts, APC_TSCH_UPLINK_CHANNEL_OFFSET);
+		}
+	}
+	//the dedicated TX cell is installed once RPL selects a preferred parent
+	PRINTF("apc_tsch_schedule: shared sf %u slots, uplink sf %u slots, root %u\n",
+			APC_TSCH_SHARED_SLOTFRAME_LENGTH, APC_TSCH_UPLINK_SLOTFRAME_LENGTH, is_root);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,65 @@
+#ifndef APC_TSCH_SCHEDULE_H
+#define APC_TSCH_SCHEDULE_H
+/*---------------------------------------------------------*/
+#include "contiki.h"
+#include "net/rpl/rpl.h"
+/*---------------------------------------------------------*/
+/* Minimal TSCH schedule shared by the collectors and the border router.
+ *
+ * Slotframe 0 (shared): one TX/RX/shared/time-keeping cell at timeslot 0,
+ * carries EBs, RPL control traffic and downlink (broker -> collector) data.
+ *
+ * Slotframe 1 (uplink): one dedicated TX cell per collector, at a timeslot
+ * derived from its link-layer address and pointed at its RPL preferred
+ * parent. The border router (and relays, if enabled) listen on every
+ * uplink timeslot. A publish or collection burst therefore drains through
+ * the collector's own cell instead of contending for the shared cell,
+ * and the radio stays off in every other slot.
+ */
+/*---------------------------------------------------------*/
+//length of the shared slotframe (in timeslots)
+#ifdef APC_TSCH_CONF_SHARED_SLOTFRAME_LENGTH
+#define APC_TSCH_SHARED_SLOTFRAME_LENGTH   APC_TSCH_CONF_SHARED_SLOTFRAME_LENGTH
+#else
+#define APC_TSCH_SHARED_SLOTFRAME_LENGTH   33
+#endif
+//length of the uplink slotframe (in timeslots), the shared slotframe length
+//must be a multiple of it: the shared cell then always falls on uplink
+//timeslot 0, which no collector uses
+#ifdef APC_TSCH_CONF_UPLINK_SLOTFRAME_LENGTH
+#define APC_TSCH_UPLINK_SLOTFRAME_LENGTH   APC_TSCH_CONF_UPLINK_SLOTFRAME_LENGTH
+#else
+#define APC_TSCH_UPLINK_SLOTFRAME_LENGTH   11
+#endif
+//set to 1 on collectors that forward traffic for children
+#ifdef APC_TSCH_CONF_RELAY
+#define APC_TSCH_RELAY                     APC_TSCH_CONF_RELAY
+#else
+#define APC_TSCH_RELAY                     0
+#endif
+#if APC_TSCH_SHARED_SLOTFRAME_LENGTH % APC_TSCH_UPLINK_SLOTFRAME_LENGTH != 0
+#error "APC_TSCH_SHARED_SLOTFRAME_LENGTH must be a multiple of APC_TSCH_UPLINK_SLOTFRAME_LENGTH"
+#endif
+/*---------------------------------------------------------*/
+#define APC_TSCH_SHARED_SLOTFRAME_HANDLE   0
+#define APC_TSCH_UPLINK_SLOTFRAME_HANDLE   1
+#define APC_TSCH_UPLINK_CHANNEL_OFFSET     1
+/*---------------------------------------------------------*/
+/* Build the schedule, call before NETSTACK_MAC.on().
+ * @param: is_root = 1 for the border router (listens on all uplink cells)
+ */
+void
+apc_tsch_schedule_init(uint8_t is_root);
+/*---------------------------------------------------------*/
+/* Timeslot of this node's dedicated uplink cell within the uplink slotframe */
+uint16_t
+apc_tsch_schedule_uplink_timeslot(void);
+/*---------------------------------------------------------*/
+/* RPL_CALLBACK_PARENT_SWITCH hook, re-targets the uplink cell to the new
+ * preferred parent and keeps the TSCH time source in sync with RPL.
+ */
+void
+apc_tsch_schedule_parent_switch(rpl_parent_t *old, rpl_parent_t *new);
+/*---------------------------------------------------------*/
+#endif /* ifndef APC_TSCH_SCHEDULE_H */
+/*---------------------------------------------------------*/
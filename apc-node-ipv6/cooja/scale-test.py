@@ -0,0 +1,442 @@
+#!/usr/bin/env python3
+""" Cooja scale tests of the IPv6 network: border router and apc-sensor-node motes.
+
+generate writes one scenario per size and topology (scale/<topology>-<motes>.csc)
+from apc-mesh.csc: 10, 50 and 100 motes in a line, a grid or at random, node 1
+being the border router. Every scenario logs the '#sim' events of the motes
+(SIM_EVENT in sim-sensors.h) and their powertrace reports with the host time,
+and stops after --duration. With --tsch both firmwares are built with the TSCH
+profile (scale/<topology>-<motes>-tsch.csc), to compare against nullrdc.
+
+run starts a scenario headless with tunslip6 on its serial socket, collects the
+publishes that reach the MQTT broker and polls the border router tables, then
+reports:
+  - PDR: publishes received by the broker / publishes made by the motes
+  - publish latency: mote publish to broker delivery, host clock
+  - DAG convergence: simulation time until the last mote joined the DAG
+  - table use at the border router (routes, or links in non-storing mode)
+  - radio duty cycle of the motes, from powertrace
+ram builds the Zoul firmwares with the same make arguments and reports the RAM
+left on the cc2538. report compares saved runs.
+
+    python3 scale-test.py generate --make-args "MAX_ROUTES=40"
+    python3 scale-test.py generate --tsch
+    python3 scale-test.py run scale/grid-50.csc
+    python3 scale-test.py run scale/grid-50-tsch.csc
+    python3 scale-test.py ram --make-args "MAX_ROUTES=40"
+    python3 scale-test.py report results/*.json
+"""
+import argparse
+import json
+import math
+import os
+import random
+import shlex
+import socket
+import subprocess
+import tempfile
+import threading
+import time
+import urllib.request
+import xml.etree.ElementTree as ET
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_CONTIKI = os.path.normpath(os.path.join(HERE, '..', '..', '..'))
+TEMPLATE = os.path.join(HERE, 'apc-mesh.csc')
+SIZES = (10, 50, 100)
+TOPOLOGIES = ('line', 'grid', 'random')
+SERIAL_SOCKET_PORT = 60001
+# Cooja motes get fd00::201:<id>:<id>:<id>, node 1 is the border router
+ROUTER_ADDRESS = 'fd00::201:1:1:1'
+CC2538_RAM = 32 * 1024
+# the collectors print their duty cycle (make MAKE_WITH_POWERTRACE=1), the border router ignores it
+POWERTRACE_MAKE_ARGS = 'MAKE_WITH_POWERTRACE=1'
+TSCH_MAKE_ARGS = 'MAKE_WITH_TSCH=1'
+# '<clock> P <node> <seq> <all cpu> <all lpm> <all tx> <all listen> <all idle tx> <all idle listen> <cpu> <lpm> <tx>
+# <listen> ... (radio ...)': the totals since boot, then of the last interval
+POWERTRACE_INTERVAL_FIELDS = slice(8, 12)
+EVENT_SCRIPT = """/* '#sim' mote events and powertrace reports with the host time (ms), for scale-test.py */
+TIMEOUT({timeout_ms}, log.testOK());
+sim.setSpeedLimit(1.0);
+while(true) {{
+  if(msg.indexOf("#sim ") == 0) {{
+    log.log(java.lang.System.currentTimeMillis() + " " + time + " " + id + " " + msg.substring(5) + "\\n");
+  }} else if(msg.indexOf(" P ") > 0 && msg.indexOf(" (radio") > 0) {{
+    log.log(java.lang.System.currentTimeMillis() + " " + time + " " + id + " power " +
+            msg.substring(msg.indexOf(" P ") + 3, msg.indexOf(" (radio")) + "\\n");
+  }}
+  YIELD();
+}}
+"""
+
+
+def positions(topology: str, motes: int, spacing: float, radio_range: float, seed: int):
+    """ :return: (x, y) of every mote, the border router first """
+    if topology == 'line':
+        return [(i * spacing, 0.0) for i in range(motes)]
+    if topology == 'grid':
+        side = math.ceil(math.sqrt(motes))
+        cells = [(c * spacing, r * spacing) for r in range(side) for c in range(side)][:motes]
+        # border router in the middle of the field
+        center = ((side - 1) * spacing / 2, (side - 1) * spacing / 2)
+        router = min(cells, key=lambda p: (p[0] - center[0]) ** 2 + (p[1] - center[1]) ** 2)
+        cells.remove(router)
+        return [router] + cells
+    if topology == 'random':
+        rng = random.Random(seed)
+        side = spacing * math.sqrt(motes)
+        for _ in range(1000):
+            points = [(side / 2, side / 2)] + [(rng.uniform(0, side), rng.uniform(0, side))
+                                               for _ in range(motes - 1)]
+            if connected(points, radio_range):
+                return [(round(x, 1), round(y, 1)) for x, y in points]
+        raise RuntimeError('no connected random placement, increase the radio range')
+    raise ValueError(topology)
+
+
+def connected(points: list, radio_range: float):
+    """ :return: True if every point reaches the first one over hops within radio_range """
+    reached = {0}
+    frontier = [0]
+    while frontier:
+        i = frontier.pop()
+        for j, (x, y) in enumerate(points):
+            if j not in reached and math.hypot(x - points[i][0], y - points[i][1]) <= radio_range:
+                reached.add(j)
+                frontier.append(j)
+    return len(reached) == len(points)
+
+
+def rebase_source(path: str, out_dir: str):
+    """ :return: path, relative to [CONFIG_DIR] of the template, made relative to the scenario written in out_dir """
+    prefix = '[CONFIG_DIR]/'
+    if not path.startswith(prefix):
+        return path
+    target = os.path.normpath(os.path.join(HERE, path[len(prefix):]))
+    return prefix + os.path.relpath(target, os.path.abspath(out_dir)).replace(os.sep, '/')
+
+
+def make_scenario(topology: str, motes: int, duration: int, make_args: str,
+                  spacing: float, radio_range: float, seed: int, out_dir: str = HERE, tsch: bool = False):
+    """ :return: ElementTree of the scenario written in out_dir, built from apc-mesh.csc """
+    tree = ET.parse(TEMPLATE)
+    root = tree.getroot()
+    sim = root.find('simulation')
+    sim.find('title').text = 'APC IPv6 scale test: {} motes, {}{}'.format(motes, topology, ', TSCH' if tsch else '')
+    sim.find('randomseed').text = str(seed)
+    medium = sim.find('radiomedium')
+    medium.find('transmitting_range').text = str(radio_range)
+    medium.find('interference_range').text = str(2 * radio_range)
+    # clean builds, the table sizes are compiled in
+    for motetype in sim.findall('motetype'):
+        # [CONFIG_DIR] is the directory of the scenario, not of the template
+        source = motetype.find('source')
+        source.text = rebase_source(source.text.strip(), out_dir)
+        commands = motetype.find('commands')
+        build = commands.text.strip() + ' ' + POWERTRACE_MAKE_ARGS
+        if tsch:
+            build += ' ' + TSCH_MAKE_ARGS
+        if make_args:
+            build += ' ' + make_args
+        commands.text = 'make clean TARGET=cooja\n' + build
+    template_mote = sim.find('mote')
+    for mote in sim.findall('mote'):
+        sim.remove(mote)
+    for i, (x, y) in enumerate(positions(topology, motes, spacing, radio_range, seed)):
+        mote = ET.fromstring(ET.tostring(template_mote))
+        for config in mote.findall('interface_config'):
+            if config.text.strip().endswith('Position'):
+                config.find('x').text = str(float(x))
+                config.find('y').text = str(float(y))
+            elif config.text.strip().endswith('ContikiMoteID'):
+                config.find('id').text = str(i + 1)
+        mote.find('motetype_identifier').text = 'br' if i == 0 else 'node'
+        sim.append(mote)
+    # headless: keep the serial socket, log the mote events instead of showing them
+    for plugin in root.findall('plugin'):
+        if not plugin.text.strip().endswith('SerialSocketServer'):
+            root.remove(plugin)
+    runner = ET.SubElement(root, 'plugin')
+    runner.text = '\n    org.contikios.cooja.plugins.ScriptRunner\n    '
+    config = ET.SubElement(runner, 'plugin_config')
+    ET.SubElement(config, 'script').text = EVENT_SCRIPT.format(timeout_ms=duration * 1000)
+    ET.SubElement(config, 'active').text = 'true'
+    for name, value in (('width', 600), ('z', 0), ('height', 400), ('location_x', 0), ('location_y', 0)):
+        ET.SubElement(runner, name).text = str(value)
+    ET.indent(tree, space='  ')
+    return tree
+
+
+def generate(args):
+    os.makedirs(args.out, exist_ok=True)
+    for topology in args.topology:
+        for motes in args.motes:
+            path = os.path.join(args.out, '{}-{}{}.csc'.format(topology, motes, '-tsch' if args.tsch else ''))
+            tree = make_scenario(topology, motes, args.duration, args.make_args,
+                                 args.spacing, args.range, args.seed + motes, args.out, args.tsch)
+            tree.write(path, encoding='UTF-8', xml_declaration=True)
+            print(path)
+    return 0
+
+
+class Collector:
+    """ Publishes reaching the broker: (host ms, mote id, seq) """
+
+    def __init__(self, broker: str, port: int):
+        import paho.mqtt.client as mqtt
+        self.arrivals = []
+        self.lock = threading.Lock()
+        self.client = mqtt.Client()
+        self.client.on_connect = lambda client, userdata, flags, rc: client.subscribe('apc-iot/+/evt/+/fmt/json')
+        self.client.on_message = self.on_message
+        self.client.connect(broker, port)
+        self.client.loop_start()
+
+    def on_message(self, client, userdata, message):
+        now = time.time() * 1000
+        try:
+            info = json.loads(message.payload.decode('utf-8'))['collector_info']
+            seq = int(info['Seq #'])
+        except (ValueError, KeyError, TypeError):
+            return  # config replies, time requests
+        with self.lock:
+            self.arrivals.append((now, message.topic.split('/')[1], seq))
+
+    def stop(self):
+        self.client.loop_stop()
+        self.client.disconnect()
+
+
+def fetch_table(router: str, name: str, timeout: float = 10.0):
+    """ :return: entries of /<name>.json on the border router, None if it did not answer """
+    url = 'http://[{}]/{}.json'.format(router, name)
+    entries = []
+    since = 0
+    try:
+        while since is not None:
+            with urllib.request.urlopen('{}?since={}'.format(url, since), timeout=timeout) as response:
+                table = json.loads(response.read().decode('ascii'))
+            since = table.pop('next')
+            entries += next(iter(table.values()))
+    except (OSError, ValueError, StopIteration):
+        return None
+    return entries
+
+
+def wait_for_port(port: int, timeout: float):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            socket.create_connection(('127.0.0.1', port), timeout=1).close()
+            return True
+        except OSError:
+            time.sleep(1)
+    return False
+
+
+def parse_events(path: str):
+    """ :return: (host ms, sim us, mote id, event, args) of every '#sim' line in a Cooja test log """
+    events = []
+    with open(path) as log:
+        for line in log:
+            fields = line.split()
+            if len(fields) < 4 or not fields[0].isdigit():
+                continue
+            events.append((int(fields[0]), int(fields[1]), int(fields[2]), fields[3], fields[4:]))
+    return events
+
+
+def percentile(values: list, q: float):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(q * len(values)))] if values else None
+
+
+def duty_cycle(radio: list):
+    """ :return: % of the time the radio was on, from the [cpu, lpm, tx, listen] sums of the powertrace intervals """
+    cpu, lpm, transmit, listen = radio
+    return 100.0 * (transmit + listen) / (cpu + lpm) if cpu + lpm else None
+
+
+def kpis(events: list, arrivals: list, motes: int, grace_ms: float, tables: list):
+    """ :return: KPIs of one run, see the module doc """
+    joins = {}
+    published = {}
+    # the interval values are summed, the totals since boot wrap around on long runs
+    radio = {}
+    end_ms = max([e[0] for e in events], default=0)
+    for host_ms, sim_us, mote, event, fields in events:
+        if event == 'join':
+            joins.setdefault(mote, sim_us / 1e6)
+        elif event == 'pub' and host_ms <= end_ms - grace_ms:
+            published[(mote, int(fields[0]))] = host_ms
+        elif event == 'power':
+            sums = radio.setdefault(mote, [0, 0, 0, 0])
+            for i, value in enumerate(fields[POWERTRACE_INTERVAL_FIELDS]):
+                sums[i] += int(value)
+    received = {}
+    for host_ms, mote_id, seq in arrivals:
+        key = (int(mote_id), seq)
+        if key in published:
+            received.setdefault(key, host_ms)
+    latencies = [received[key] - published[key] for key in received]
+    routes = [len(t) for t in tables if t is not None]
+    duty = [d for d in map(duty_cycle, radio.values()) if d is not None]
+    return {
+        'motes': motes,
+        'joined': len(joins),
+        'convergence_s': max(joins.values()) if len(joins) == motes - 1 else None,
+        'published': len(published),
+        'received': len(received),
+        'pdr': len(received) / len(published) if published else None,
+        'latency_ms_p50': percentile(latencies, 0.5),
+        'latency_ms_p95': percentile(latencies, 0.95),
+        'latency_ms_max': max(latencies, default=None),
+        'routes_max': max(routes, default=None),
+        'duty_cycle_pct_mean': sum(duty) / len(duty) if duty else None,
+        'duty_cycle_pct_max': max(duty, default=None),
+        'silent_motes': sorted(set(range(2, motes + 1)) - {m for m, _ in published}),
+    }
+
+
+def run(args):
+    contiki = os.path.abspath(args.contiki)
+    csc = os.path.abspath(args.csc)
+    motes = len(ET.parse(csc).getroot().find('simulation').findall('mote'))
+    collector = Collector(args.broker, args.broker_port)
+    workdir = tempfile.mkdtemp(prefix='apc-scale-')
+    cooja = subprocess.Popen(['java', '-mx{}m'.format(args.java_mb), '-jar',
+                              os.path.join(contiki, 'tools', 'cooja', 'dist', 'cooja.jar'),
+                              '-nogui=' + csc, '-contiki=' + contiki],
+                             cwd=workdir, stdout=open(os.path.join(workdir, 'cooja.out'), 'w'),
+                             stderr=subprocess.STDOUT)
+    tunslip = None
+    tables = []
+    try:
+        # both firmwares are compiled first
+        if not wait_for_port(SERIAL_SOCKET_PORT, args.build_timeout):
+            raise RuntimeError('no serial socket, see {}'.format(os.path.join(workdir, 'cooja.out')))
+        tunslip = subprocess.Popen(shlex.split(args.tunslip.format(contiki=contiki, prefix=args.prefix)))
+        start = time.monotonic()
+        while cooja.poll() is None:
+            time.sleep(args.poll)
+            # links instead of routes in non-storing mode
+            entries = fetch_table(args.router, 'routes')
+            tables.append(entries)
+            print('{:.0f} s: routes {}'.format(time.monotonic() - start, '-' if entries is None else len(entries)),
+                  flush=True)
+        time.sleep(1)
+    finally:
+        if cooja.poll() is None:
+            cooja.terminate()
+        if tunslip is not None:
+            tunslip.terminate()
+        collector.stop()
+    events = parse_events(os.path.join(workdir, 'COOJA.testlog'))
+    result = kpis(events, collector.arrivals, motes, args.grace * 1000, tables)
+    result['scenario'] = os.path.splitext(os.path.basename(csc))[0]
+    print_results([result])
+    if args.out:
+        os.makedirs(os.path.dirname(os.path.abspath(args.out)), exist_ok=True)
+        with open(args.out, 'w') as f:
+            json.dump(result, f, indent=1)
+    return 0 if result['pdr'] is not None else 1
+
+
+def firmware_ram(contiki: str, directory: str, project: str, make_args: str, size_tool: str):
+    """ :return: (data, bss) bytes of the Zoul build of project """
+    make = ['make', '-C', directory, 'TARGET=zoul', 'CONTIKI=' + contiki] + shlex.split(make_args)
+    subprocess.run(make + ['clean'], check=True, stdout=subprocess.DEVNULL)
+    subprocess.run(make + [project], check=True, stdout=subprocess.DEVNULL)
+    out = subprocess.run([size_tool, os.path.join(directory, project + '.zoul')], check=True,
+                         stdout=subprocess.PIPE, universal_newlines=True).stdout
+    text, data, bss = (int(v) for v in out.splitlines()[1].split()[:3])
+    return data, bss
+
+
+def ram(args):
+    contiki = os.path.abspath(args.contiki)
+    print('{:<16} {:>7} {:>7} {:>9}'.format('firmware', 'data', 'bss', 'headroom'))
+    for directory, project in (('rpl-border-router', 'border-router'), ('apc-sensor-node', 'apc-sensor-node')):
+        data, bss = firmware_ram(contiki, os.path.join(HERE, '..', directory), project,
+                                 args.make_args, args.size)
+        print('{:<16} {:>7} {:>7} {:>9}'.format(project, data, bss, args.ram_size - data - bss))
+    return 0
+
+
+def fmt(value, spec: str):
+    return '-' if value is None else format(value, spec)
+
+
+def print_results(results: list):
+    print('{:<19} {:>5} {:>6} {:>8} {:>10} {:>6} {:>7} {:>7} {:>6} {:>6} {:>6}'.format(
+        'scenario', 'motes', 'joined', 'conv s', 'pub/recv', 'pdr %', 'p50 ms', 'p95 ms', 'routes', 'duty %',
+        'max %'))
+    for r in results:
+        # runs saved before the duty cycle was reported have none
+        print('{:<19} {:>5} {:>6} {:>8} {:>10} {:>6} {:>7} {:>7} {:>6} {:>6} {:>6}'.format(
+            r['scenario'], r['motes'], r['joined'], fmt(r['convergence_s'], '.1f'),
+            '{}/{}'.format(r['published'], r['received']),
+            fmt(None if r['pdr'] is None else r['pdr'] * 100, '.1f'),
+            fmt(r['latency_ms_p50'], '.0f'), fmt(r['latency_ms_p95'], '.0f'), fmt(r['routes_max'], 'd'),
+            fmt(r.get('duty_cycle_pct_mean'), '.1f'), fmt(r.get('duty_cycle_pct_max'), '.1f')))
+
+
+def report(args):
+    results = []
+    for path in args.results:
+        with open(path) as f:
+            results.append(json.load(f))
+    print_results(results)
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Cooja scale tests of the IPv6 APC network')
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    p = commands.add_parser('generate', help='write the scenarios')
+    p.add_argument('--out', default=os.path.join(HERE, 'scale'), help='directory (default scale/)')
+    p.add_argument('--motes', type=int, nargs='+', default=list(SIZES), help='motes, border router included')
+    p.add_argument('--topology', nargs='+', default=list(TOPOLOGIES), choices=TOPOLOGIES)
+    p.add_argument('--duration', type=int, default=1800, help='simulated seconds (default 1800)')
+    p.add_argument('--make-args', default='', help='for both firmwares, e.g. "MAX_ROUTES=40 MAX_NEIGHBORS=10"')
+    p.add_argument('--spacing', type=float, default=35.0, help='m between neighbors (default 35)')
+    p.add_argument('--range', type=float, default=50.0, help='radio range in m (default 50)')
+    p.add_argument('--seed', type=int, default=123456, help='simulation and placement seed')
+    p.add_argument('--tsch', action='store_true', help='build both firmwares with MAKE_WITH_TSCH=1, '
+                                                      'written as <topology>-<motes>-tsch.csc')
+    p.set_defaults(func=generate)
+
+    p = commands.add_parser('run', help='run one scenario and report its KPIs')
+    p.add_argument('csc', help='scenario, e.g. scale/grid-50.csc')
+    p.add_argument('--contiki', default=DEFAULT_CONTIKI, help='Contiki tree (default ../../..)')
+    p.add_argument('--broker', default='localhost', help='MQTT broker the motes publish to')
+    p.add_argument('--broker-port', type=int, default=1883)
+    p.add_argument('--router', default=ROUTER_ADDRESS, help='border router address')
+    p.add_argument('--prefix', default='fd00::1/64', help='tunslip6 prefix')
+    p.add_argument('--tunslip', default='sudo {contiki}/tools/tunslip6 -a 127.0.0.1 {prefix}',
+                   help='tunslip6 command, {contiki} and {prefix} are filled in')
+    p.add_argument('--poll', type=float, default=30.0, help='seconds between border router table polls')
+    p.add_argument('--grace', type=float, default=30.0, help='publishes this close to the end are not counted')
+    p.add_argument('--build-timeout', type=float, default=600.0, help='seconds for Cooja to build and start')
+    p.add_argument('--java-mb', type=int, default=2048, help='Java heap for Cooja')
+    p.add_argument('--out', help='save the KPIs as JSON, e.g. results/grid-50.json')
+    p.set_defaults(func=run)
+
+    p = commands.add_parser('ram', help='RAM headroom of the Zoul firmwares')
+    p.add_argument('--contiki', default=DEFAULT_CONTIKI, help='Contiki tree (default ../../..)')
+    p.add_argument('--make-args', default='', help='same as given to generate')
+    p.add_argument('--size', default='arm-none-eabi-size', help='size tool of the toolchain')
+    p.add_argument('--ram-size', type=int, default=CC2538_RAM, help='bytes of RAM (default 32768, cc2538)')
+    p.set_defaults(func=ram)
+
+    p = commands.add_parser('report', help='compare saved runs')
+    p.add_argument('results', nargs='+', help='JSON files written by run --out')
+    p.set_defaults(func=report)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == '__main__':
+    exit(main())
@@ -46,10 +46,17 @@
 #include "net/rpl/rpl-ns.h"
 #endif /* RPL_WITH_NON_STORING */
 #include "net/netstack.h"
+#include "net/queuebuf.h"
 #include "dev/button-sensor.h"
 #include "dev/slip.h"
+#if WITH_TSCH
+#include "net/mac/tsch/tsch.h"
+#include "../apc-tsch-schedule.h"
+#endif /* WITH_TSCH */
 
 #include "../apc-common.h"
+#include "slip-debug.h"
+#include "br-stats.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -73,8 +80,10 @@ AUTOSTART_PROCESSES(&border_router_process);
 AUTOSTART_PROCESSES(&border_router_process,&webserver_nogui_process);
 #else
 /* Use simple webserver with only one page for minimum footprint.
- * Multiple connections can result in interleaved tcp segments since
- * a single static buffer is used for all segments.
+ * Pages are produced one TCP segment at a time straight into uip_appdata
+ * (PSOCK_GENERATOR_SEND). The position in the page is kept per connection
+ * and only moves on once a segment is acked, so retransmissions regenerate
+ * the same segment and concurrent connections do not share any buffer.
  */
 #include "httpd-simple.h"
 /* The internal webserver can provide additional information if
@@ -83,15 +92,7 @@ AUTOSTART_PROCESSES(&border_router_process,&webserver_nogui_process);
 #define WEBSERVER_CONF_LOADTIME 1
 #define WEBSERVER_CONF_FILESTATS 0
 #define WEBSERVER_CONF_NEIGHBOR_STATUS 1
-/* Adding links requires a larger RAM buffer. To avoid static allocation
- * the stack can be used for formatting; however tcp retransmissions
- * and multiple connections can result in garbled segments.
- * TODO:use PSOCk_GENERATOR_SEND and tcp state storage to fix this.
- */
 #define WEBSERVER_CONF_ROUTE_LINKS 0
-#if WEBSERVER_CONF_ROUTE_LINKS
-#define BUF_USES_STACK 1
-#endif
 
 PROCESS(webserver_nogui_process, "Web server");
 PROCESS_THREAD(webserver_nogui_process, ev, data)
@@ -111,18 +112,52 @@ AUTOSTART_PROCESSES(&border_router_process,&webserver_nogui_process);
 
 static const char *TOP = "<html><head><title>ContikiRPL</title></head><body>\n";
 static const char *BOTTOM = "</body></html>\n";
-#if BUF_USES_STACK
+/* Output of the segment being generated, only valid inside a generator */
 static char *bufptr, *bufend;
 #define ADD(...) do {                                                   \
-    bufptr += snprintf(bufptr, bufend - bufptr, __VA_ARGS__);      \
+    if(bufptr < bufend) {                                               \
+      bufptr += snprintf(bufptr, bufend - bufptr, __VA_ARGS__);         \
+    }                                                                   \
   } while(0)
-#else
-static char buf[256];
-static int blen;
-#define ADD(...) do {                                                   \
-    blen += snprintf(&buf[blen], sizeof(buf) - blen, __VA_ARGS__);      \
-  } while(0)
-#endif
+
+/* Sections of the routes page, in order */
+enum {
+  ROUTES_TOP,
+  ROUTES_NEIGHBORS,
+  ROUTES_ROUTES_HEADER,
+  ROUTES_ROUTES,
+  ROUTES_LINKS_HEADER,
+  ROUTES_LINKS,
+  ROUTES_FOOTER
+};
+/* Sections of the JSON tables */
+enum {
+  JSON_TOP,
+  JSON_ENTRIES
+};
+/* Sections of the statistics page */
+enum {
+  STATS_SLIP,
+  STATS_RADIO,
+  STATS_QUEUEBUF,
+  STATS_DEBUG,
+  STATS_HISTOGRAMS,
+  STATS_NEIGHBORS_TOP,
+  STATS_NEIGHBORS,
+  STATS_END
+};
+#define PAGE_DONE 0xff
+/* Entries per JSON page unless ?limit= is given */
+#define JSON_DEFAULT_LIMIT 0xffff
+
+/* Writes one page item at the cursor: returns 1 while the section has more
+ * items, 0 when the section is over and -1 when the page is over.
+ */
+typedef int (*page_item_t)(struct httpd_state *s, struct httpd_cursor *c);
+/* Writes the table entry at a position: returns 1 if it was written, 0 if
+ * there is nothing to show for it and -1 past the end of the table.
+ */
+typedef int (*json_entry_t)(uint16_t index, const char *sep);
 
 /*---------------------------------------------------------------------------*/
 static void
@@ -145,208 +180,520 @@ ipaddr_add(const uip_ipaddr_t *addr)
   }
 }
 /*---------------------------------------------------------------------------*/
-static
-PT_THREAD(generate_routes(struct httpd_state *s))
+/* Table entries are looked up by position on every segment: entries may be
+ * removed while a page is being sent, and a position never dangles.
+ */
+static uip_ds6_nbr_t *
+nbr_at(uint16_t index)
 {
-  static uip_ds6_route_t *r;
-#if RPL_WITH_NON_STORING
-  static rpl_ns_node_t *link;
-#endif /* RPL_WITH_NON_STORING */
-  static uip_ds6_nbr_t *nbr;
-#if BUF_USES_STACK
-  char buf[256];
-#endif
-#if WEBSERVER_CONF_LOADTIME
-  static clock_time_t numticks;
-  numticks = clock_time();
-#endif
+  uip_ds6_nbr_t *nbr = nbr_table_head(ds6_neighbors);
 
-  PSOCK_BEGIN(&s->sout);
-
-  SEND_STRING(&s->sout, TOP);
-#if BUF_USES_STACK
-  bufptr = buf;bufend=bufptr+sizeof(buf);
-#else
-  blen = 0;
-#endif
-  ADD("Neighbors<pre>");
+  while(nbr != NULL && index-- > 0) {
+    nbr = nbr_table_next(ds6_neighbors, nbr);
+  }
+  return nbr;
+}
+/*---------------------------------------------------------------------------*/
+static uip_ds6_route_t *
+route_at(uint16_t index)
+{
+  uip_ds6_route_t *r = uip_ds6_route_head();
 
-  for(nbr = nbr_table_head(ds6_neighbors);
-      nbr != NULL;
-      nbr = nbr_table_next(ds6_neighbors, nbr)) {
+  while(r != NULL && index-- > 0) {
+    r = uip_ds6_route_next(r);
+  }
+  return r;
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_WITH_NON_STORING
+static rpl_ns_node_t *
+link_at(uint16_t index)
+{
+  rpl_ns_node_t *link = rpl_ns_node_head();
 
-#if WEBSERVER_CONF_NEIGHBOR_STATUS
-#if BUF_USES_STACK
-{char* j=bufptr+25;
-      ipaddr_add(&nbr->ipaddr);
-      while (bufptr < j) ADD(" ");
-      switch (nbr->state) {
-      case NBR_INCOMPLETE: ADD(" INCOMPLETE");break;
-      case NBR_REACHABLE: ADD(" REACHABLE");break;
-      case NBR_STALE: ADD(" STALE");break;
-      case NBR_DELAY: ADD(" DELAY");break;
-      case NBR_PROBE: ADD(" NBR_PROBE");break;
-      }
+  while(link != NULL && index-- > 0) {
+    link = rpl_ns_node_next(link);
+  }
+  return link;
 }
-#else
-{uint8_t j=blen+25;
-      ipaddr_add(&nbr->ipaddr);
-      while (blen < j) ADD(" ");
-      switch (nbr->state) {
-      case NBR_INCOMPLETE: ADD(" INCOMPLETE");break;
-      case NBR_REACHABLE: ADD(" REACHABLE");break;
-      case NBR_STALE: ADD(" STALE");break;
-      case NBR_DELAY: ADD(" DELAY");break;
-      case NBR_PROBE: ADD(" NBR_PROBE");break;
-      }
+#endif /* RPL_WITH_NON_STORING */
+/*---------------------------------------------------------------------------*/
+static const char *
+nbr_state_name(uint8_t state)
+{
+  switch(state) {
+  case NBR_INCOMPLETE: return "INCOMPLETE";
+  case NBR_REACHABLE: return "REACHABLE";
+  case NBR_STALE: return "STALE";
+  case NBR_DELAY: return "DELAY";
+  case NBR_PROBE: return "NBR_PROBE";
+  }
+  return NULL;
 }
-#endif
-#else
-      ipaddr_add(&nbr->ipaddr);
-#endif
-
-      ADD("\n");
-#if BUF_USES_STACK
-      if(bufptr > bufend - 45) {
-        SEND_STRING(&s->sout, buf);
-        bufptr = buf; bufend = bufptr + sizeof(buf);
-      }
+/*---------------------------------------------------------------------------*/
+static void
+add_host(const uip_ipaddr_t *addr)
+{
+#if WEBSERVER_CONF_ROUTE_LINKS
+  ADD("<a href=http://[");
+  ipaddr_add(addr);
+  ADD("]/status.shtml>");
+  ipaddr_add(addr);
+  ADD("</a>");
 #else
-      if(blen > sizeof(buf) - 45) {
-        SEND_STRING(&s->sout, buf);
-        blen = 0;
-      }
+  ipaddr_add(addr);
 #endif
-  }
-  ADD("</pre>Routes<pre>\n");
-  SEND_STRING(&s->sout, buf);
-#if BUF_USES_STACK
-  bufptr = buf; bufend = bufptr + sizeof(buf);
-#else
-  blen = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* page_item_t of the routes page */
+static int
+add_routes_item(struct httpd_state *s, struct httpd_cursor *c)
+{
+  uip_ds6_nbr_t *nbr;
+  uip_ds6_route_t *r;
+#if RPL_WITH_NON_STORING
+  rpl_ns_node_t *link;
+#endif /* RPL_WITH_NON_STORING */
+#if WEBSERVER_CONF_LOADTIME
+  clock_time_t numticks;
 #endif
 
-  for(r = uip_ds6_route_head(); r != NULL; r = uip_ds6_route_next(r)) {
-
-#if BUF_USES_STACK
-#if WEBSERVER_CONF_ROUTE_LINKS
-    ADD("<a href=http://[");
-    ipaddr_add(&r->ipaddr);
-    ADD("]/status.shtml>");
-    ipaddr_add(&r->ipaddr);
-    ADD("</a>");
-#else
-    ipaddr_add(&r->ipaddr);
-#endif
-#else
-#if WEBSERVER_CONF_ROUTE_LINKS
-    ADD("<a href=http://[");
-    ipaddr_add(&r->ipaddr);
-    ADD("]/status.shtml>");
-    SEND_STRING(&s->sout, buf); //TODO: why tunslip6 needs an output here, wpcapslip does not
-    blen = 0;
-    ipaddr_add(&r->ipaddr);
-    ADD("</a>");
+  switch(c->section) {
+  case ROUTES_TOP:
+    ADD("%sNeighbors<pre>", TOP);
+    return 0;
+  case ROUTES_NEIGHBORS:
+    nbr = nbr_at(c->index);
+    if(nbr == NULL) {
+      return 0;
+    }
+#if WEBSERVER_CONF_NEIGHBOR_STATUS
+    {
+      char *j = bufptr + 25;
+      ipaddr_add(&nbr->ipaddr);
+      while(bufptr < j && bufptr < bufend) ADD(" ");
+      if(nbr_state_name(nbr->state) != NULL) {
+        ADD(" %s", nbr_state_name(nbr->state));
+      }
+    }
 #else
-    ipaddr_add(&r->ipaddr);
-#endif
+    ipaddr_add(&nbr->ipaddr);
 #endif
+    ADD("\n");
+    return 1;
+  case ROUTES_ROUTES_HEADER:
+    ADD("</pre>Routes<pre>\n");
+    return 0;
+  case ROUTES_ROUTES:
+    r = route_at(c->index);
+    if(r == NULL) {
+      return 0;
+    }
+    add_host(&r->ipaddr);
     ADD("/%u (via ", r->length);
     ipaddr_add(uip_ds6_route_nexthop(r));
-    if(1 || (r->state.lifetime < 600)) {
-      ADD(") %lus\n", (unsigned long)r->state.lifetime);
-    } else {
-      ADD(")\n");
-    }
-    SEND_STRING(&s->sout, buf);
-#if BUF_USES_STACK
-    bufptr = buf; bufend = bufptr + sizeof(buf);
-#else
-    blen = 0;
-#endif
-  }
-  ADD("</pre>");
-
+    ADD(") %lus\n", (unsigned long)r->state.lifetime);
+    return 1;
+  case ROUTES_LINKS_HEADER:
+    ADD("</pre>");
 #if RPL_WITH_NON_STORING
-  ADD("Links<pre>\n");
-  SEND_STRING(&s->sout, buf);
-#if BUF_USES_STACK
-  bufptr = buf; bufend = bufptr + sizeof(buf);
-#else
-  blen = 0;
-#endif
-  for(link = rpl_ns_node_head(); link != NULL; link = rpl_ns_node_next(link)) {
+    ADD("Links<pre>\n");
+#endif /* RPL_WITH_NON_STORING */
+    return 0;
+  case ROUTES_LINKS:
+#if RPL_WITH_NON_STORING
+    link = link_at(c->index);
+    if(link == NULL) {
+      return 0;
+    }
     if(link->parent != NULL) {
       uip_ipaddr_t child_ipaddr;
       uip_ipaddr_t parent_ipaddr;
 
       rpl_ns_get_node_global_addr(&child_ipaddr, link);
       rpl_ns_get_node_global_addr(&parent_ipaddr, link->parent);
-
-#if BUF_USES_STACK
-#if WEBSERVER_CONF_ROUTE_LINKS
-      ADD("<a href=http://[");
-      ipaddr_add(&child_ipaddr);
-      ADD("]/status.shtml>");
-      ipaddr_add(&child_ipaddr);
-      ADD("</a>");
-#else
-      ipaddr_add(&child_ipaddr);
-#endif
-#else
-#if WEBSERVER_CONF_ROUTE_LINKS
-      ADD("<a href=http://[");
-      ipaddr_add(&child_ipaddr);
-      ADD("]/status.shtml>");
-      SEND_STRING(&s->sout, buf); //TODO: why tunslip6 needs an output here, wpcapslip does not
-      blen = 0;
-      ipaddr_add(&child_ipaddr);
-      ADD("</a>");
+      add_host(&child_ipaddr);
+      ADD(" (parent: ");
+      ipaddr_add(&parent_ipaddr);
+      ADD(") %us\n", (unsigned int)link->lifetime); // iotlab printf does not have %lu
+    }
+    return 1;
 #else
-      ipaddr_add(&child_ipaddr);
+    return 0;
+#endif /* RPL_WITH_NON_STORING */
+  case ROUTES_FOOTER:
+#if RPL_WITH_NON_STORING
+    ADD("</pre>");
+#endif /* RPL_WITH_NON_STORING */
+#if WEBSERVER_CONF_FILESTATS
+    {
+      static uint16_t numtimes;
+      ADD("<br><i>This page sent %u times</i>", ++numtimes);
+    }
 #endif
+#if WEBSERVER_CONF_LOADTIME
+    numticks = clock_time() - s->start + 1;
+    ADD(" <i>(%u.%02u sec)</i>", numticks / CLOCK_SECOND, (100 * (numticks % CLOCK_SECOND)) / CLOCK_SECOND);
 #endif
+    ADD("%s", BOTTOM);
+    return -1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* JSON entries, sep goes before each entry but the first of the page */
+static int
+add_neighbor_json(uint16_t index, const char *sep)
+{
+  uip_ds6_nbr_t *nbr = nbr_at(index);
+  const uip_lladdr_t *lladdr;
+  int i;
 
-      ADD(" (parent: ");
-      ipaddr_add(&parent_ipaddr);
-      if(1 || (link->lifetime < 600)) {
-        ADD(") %us\n", (unsigned int)link->lifetime); // iotlab printf does not have %lu
-        //ADD(") %lus\n", (unsigned long)r->state.lifetime);
-      } else {
-        ADD(")\n");
+  if(nbr == NULL) {
+    return -1;
+  }
+  ADD("%s{\"ip\":\"", sep);
+  ipaddr_add(&nbr->ipaddr);
+  ADD("\",\"ll\":\"");
+  lladdr = uip_ds6_nbr_get_ll(nbr);
+  for(i = 0; lladdr != NULL && i < sizeof(uip_lladdr_t); i++) {
+    ADD("%02x", lladdr->addr[i]);
+  }
+  ADD("\",\"state\":\"%s\",\"router\":%u",
+      nbr_state_name(nbr->state) != NULL ? nbr_state_name(nbr->state) : "?",
+      nbr->isrouter);
+#if UIP_ND6_SEND_NA || UIP_ND6_SEND_RA
+  ADD(",\"reachable\":%lu", (unsigned long)stimer_remaining(&nbr->reachable));
+#endif /* UIP_ND6_SEND_NA || UIP_ND6_SEND_RA */
+  ADD("}");
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+#if RPL_WITH_NON_STORING
+static int
+add_link_json(uint16_t index, const char *sep)
+{
+  rpl_ns_node_t *link = link_at(index);
+  uip_ipaddr_t child_ipaddr;
+  uip_ipaddr_t parent_ipaddr;
+
+  if(link == NULL) {
+    return -1;
+  }
+  if(link->parent == NULL) {
+    return 0;
+  }
+  rpl_ns_get_node_global_addr(&child_ipaddr, link);
+  rpl_ns_get_node_global_addr(&parent_ipaddr, link->parent);
+  ADD("%s{\"child\":\"", sep);
+  ipaddr_add(&child_ipaddr);
+  ADD("\",\"parent\":\"");
+  ipaddr_add(&parent_ipaddr);
+  ADD("\",\"lifetime\":%u}", (unsigned int)link->lifetime);
+  return 1;
+}
+#else /* RPL_WITH_NON_STORING */
+static int
+add_route_json(uint16_t index, const char *sep)
+{
+  uip_ds6_route_t *r = route_at(index);
+
+  if(r == NULL) {
+    return -1;
+  }
+  ADD("%s{\"dest\":\"", sep);
+  ipaddr_add(&r->ipaddr);
+  ADD("\",\"len\":%u,\"via\":\"", r->length);
+  ipaddr_add(uip_ds6_route_nexthop(r));
+  ADD("\",\"lifetime\":%lu}", (unsigned long)r->state.lifetime);
+  return 1;
+}
+#endif /* RPL_WITH_NON_STORING */
+/*---------------------------------------------------------------------------*/
+/* {"<name>":[<entries from ?since= on, at most ?limit=>],"next":<since of the
+ * following page or null>}. Positions are table positions, so a page never
+ * repeats or skips an entry unless the table changes between requests.
+ */
+static int
+add_json_item(struct httpd_state *s, struct httpd_cursor *c,
+              const char *name, json_entry_t add_entry)
+{
+  int written;
+
+  switch(c->section) {
+  case JSON_TOP:
+    ADD("{\"%s\":[", name);
+    return 0;
+  case JSON_ENTRIES:
+    if(c->count < s->limit) {
+      written = add_entry(s->since + c->index, c->count > 0 ? "," : "");
+      if(written >= 0) {
+        c->count += written;
+        return 1;
       }
-      SEND_STRING(&s->sout, buf);
-#if BUF_USES_STACK
-      bufptr = buf; bufend = bufptr + sizeof(buf);
-#else
-      blen = 0;
-#endif
+      ADD("],\"next\":null}\n");
+    } else {
+      ADD("],\"next\":%u}\n", s->since + c->index);
     }
+    return -1;
   }
-  ADD("</pre>");
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+add_neighbors_json_item(struct httpd_state *s, struct httpd_cursor *c)
+{
+  return add_json_item(s, c, "neighbors", add_neighbor_json);
+}
+/*---------------------------------------------------------------------------*/
+static int
+add_routes_json_item(struct httpd_state *s, struct httpd_cursor *c)
+{
+#if RPL_WITH_NON_STORING
+  /* The root of a non-storing network keeps links, not routes */
+  return add_json_item(s, c, "links", add_link_json);
+#else /* RPL_WITH_NON_STORING */
+  return add_json_item(s, c, "routes", add_route_json);
 #endif /* RPL_WITH_NON_STORING */
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_u16_array(const char *name, const uint16_t *values, uint8_t n)
+{
+  uint8_t i;
 
-#if WEBSERVER_CONF_FILESTATS
-  static uint16_t numtimes;
-  ADD("<br><i>This page sent %u times</i>",++numtimes);
-#endif
+  ADD("\"%s\":[", name);
+  for(i = 0; i < n; i++) {
+    ADD(i > 0 ? ",%u" : "%u", values[i]);
+  }
+  ADD("]");
+}
+/*---------------------------------------------------------------------------*/
+/* page_item_t of /stats, see br-stats.h */
+static int
+add_stats_item(struct httpd_state *s, struct httpd_cursor *c)
+{
+  const struct br_stats *st = br_stats_get();
+  const struct slip_debug_stats *debug = slip_debug_get_stats();
+  const struct br_stats_neighbor *n;
+  int i;
 
-#if WEBSERVER_CONF_LOADTIME
-  numticks = clock_time() - numticks + 1;
-  ADD(" <i>(%u.%02u sec)</i>",numticks/CLOCK_SECOND,(100*(numticks%CLOCK_SECOND))/CLOCK_SECOND);
-#endif
+  switch(c->section) {
+  case STATS_SLIP:
+    ADD("{\"slip\":{\"in_frames\":%lu,\"in_bytes\":%lu,\"out_frames\":%lu,\"out_bytes\":%lu,"
+        "\"bounce_drops\":%u},",
+        (unsigned long)st->slip_in_frames, (unsigned long)st->slip_in_bytes,
+        (unsigned long)st->slip_out_frames, (unsigned long)st->slip_out_bytes, st->bounce_drops);
+    return 0;
+  case STATS_RADIO:
+    ADD("\"radio\":{\"in\":%u,\"dao_in\":%u,\"tx_ok\":%u,\"tx_noack\":%u,\"tx_collision\":%u,"
+        "\"tx_err\":%u},",
+        st->radio_in, st->dao_in, st->tx_ok, st->tx_noack, st->tx_collision, st->tx_err);
+    return 0;
+  case STATS_QUEUEBUF:
+    ADD("\"queuebuf\":{\"len\":%u,\"max\":%u,\"num\":%u},",
+        br_stats_queuebuf_len(), st->queuebuf_max, QUEUEBUF_NUM);
+    return 0;
+  case STATS_DEBUG:
+    ADD("\"debug\":{\"lines\":%u,", debug->lines);
+    add_u16_array("rate_drops", debug->rate_drops, SLIP_DEBUG_LEVELS);
+    ADD(",");
+    add_u16_array("full_drops", debug->full_drops, SLIP_DEBUG_LEVELS);
+    ADD("},");
+    return 0;
+  case STATS_HISTOGRAMS:
+    ADD("\"hist\":{");
+    add_u16_array("slip_in_size", st->slip_in_size, BR_STATS_SIZE_BINS);
+    ADD(",");
+    add_u16_array("slip_out_size", st->slip_out_size, BR_STATS_SIZE_BINS);
+    ADD(",");
+    add_u16_array("queue_depth", st->queue_depth, BR_STATS_QUEUE_BINS);
+    ADD("},");
+    return 0;
+  case STATS_NEIGHBORS_TOP:
+    ADD("\"neighbors\":[");
+    return 0;
+  case STATS_NEIGHBORS:
+    if(c->index >= BR_STATS_NEIGHBORS) {
+      return 0;
+    }
+    n = &st->neighbors[c->index];
+    if(linkaddr_cmp(&n->addr, &linkaddr_null)) {
+      return 1;
+    }
+    ADD("%s{\"ll\":\"", c->count > 0 ? "," : "");
+    for(i = 0; i < LINKADDR_SIZE; i++) {
+      ADD("%02x", n->addr.u8[i]);
+    }
+    ADD("\",\"tx_ok\":%u,\"tx_fail\":%u}", n->tx_ok, n->tx_fail);
+    c->count++;
+    return 1;
+  case STATS_END:
+    ADD("]}\n");
+    return -1;
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+cursor_advance(struct httpd_cursor *c, int more)
+{
+  if(more > 0) {
+    c->index++;
+  } else if(more == 0) {
+    c->section++;
+    c->index = 0;
+    c->count = 0;
+  } else {
+    c->section = PAGE_DONE;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Fill one segment from s->cursor, leaving the position after it in
+ * s->next. Items that do not fit wait for the next segment.
+ */
+static unsigned short
+generate_segment(struct httpd_state *s, page_item_t add_item)
+{
+  struct httpd_cursor c = s->cursor;
+  struct httpd_cursor item_cursor;
+  char *item;
+  int more;
+
+  bufptr = (char *)uip_appdata;
+  bufend = bufptr + uip_mss();
+  while(c.section != PAGE_DONE) {
+    item = bufptr;
+    item_cursor = c;
+    more = add_item(s, &c);
+    if(bufptr >= bufend) {
+      if(item == (char *)uip_appdata) {
+        //larger than a whole segment: send it truncated rather than stall
+        bufptr = bufend - 1;
+        cursor_advance(&c, more);
+      } else {
+        //retry in the next segment
+        bufptr = item;
+        c = item_cursor;
+      }
+      break;
+    }
+    cursor_advance(&c, more);
+  }
+  s->next = c;
+  return bufptr - (char *)uip_appdata;
+}
+/*---------------------------------------------------------------------------*/
+/* PSOCK_GENERATOR_SEND callbacks, one per page */
+static unsigned short
+generate_routes_segment(void *arg)
+{
+  return generate_segment((struct httpd_state *)arg, add_routes_item);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
+generate_neighbors_json_segment(void *arg)
+{
+  return generate_segment((struct httpd_state *)arg, add_neighbors_json_item);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
+generate_routes_json_segment(void *arg)
+{
+  return generate_segment((struct httpd_state *)arg, add_routes_json_item);
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
+generate_stats_segment(void *arg)
+{
+  return generate_segment((struct httpd_state *)arg, add_stats_item);
+}
+/*---------------------------------------------------------------------------*/
+/* Value of key in the query string of the requested path, def if absent */
+static uint16_t
+query_value(const char *filename, const char *key, uint16_t def)
+{
+  const char *q = strchr(filename, '?');
+  size_t len = strlen(key);
+
+  while(q != NULL) {
+    q++;
+    if(strncmp(q, key, len) == 0 && q[len] == '=' && isdigit((unsigned char)q[len + 1])) {
+      return (uint16_t)atoi(&q[len + 1]);
+    }
+    q = strchr(q, '&');
+  }
+  return def;
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(send_page(struct httpd_state *s, unsigned short (*generate)(void *)))
+{
+  PSOCK_BEGIN(&s->sout);
 
-  SEND_STRING(&s->sout, buf);
-  SEND_STRING(&s->sout, BOTTOM);
+  s->cursor.section = 0;
+  s->cursor.index = 0;
+  s->cursor.count = 0;
+  s->since = query_value(s->filename, "since", 0);
+  s->limit = query_value(s->filename, "limit", 0);
+  if(s->limit == 0) {
+    s->limit = JSON_DEFAULT_LIMIT;
+  }
+  s->start = clock_time();
+  while(s->cursor.section != PAGE_DONE) {
+    PSOCK_GENERATOR_SEND(&s->sout, generate, s);
+    s->cursor = s->next;
+  }
 
   PSOCK_END(&s->sout);
 }
 /*---------------------------------------------------------------------------*/
+static
+PT_THREAD(generate_routes(struct httpd_state *s))
+{
+  return send_page(s, generate_routes_segment);
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(generate_neighbors_json(struct httpd_state *s))
+{
+  return send_page(s, generate_neighbors_json_segment);
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(generate_routes_json(struct httpd_state *s))
+{
+  return send_page(s, generate_routes_json_segment);
+}
+/*---------------------------------------------------------------------------*/
+static
+PT_THREAD(generate_stats(struct httpd_state *s))
+{
+  return send_page(s, generate_stats_segment);
+}
+/*---------------------------------------------------------------------------*/
+/* name is the requested path without the leading '/', query included */
+static int
+path_is(const char *name, const char *path)
+{
+  size_t len = strlen(path);
+
+  return strncmp(name, path, len) == 0 && (name[len] == '\0' || name[len] == '?');
+}
+/*---------------------------------------------------------------------------*/
 httpd_simple_script_t
 httpd_simple_get_script(const char *name)
 {
-
-  return generate_routes;
+  if(path_is(name, "neighbors.json")) {
+    return generate_neighbors_json;
+  } else if(path_is(name, "routes.json")) {
+    return generate_routes_json;
+  } else if(path_is(name, "stats.json")) {
+    return generate_stats;
+  } else if(path_is(name, "") || path_is(name, "index.html")) {
+    return generate_routes;
+  }
+  return NULL;
 }
 
 #endif /* WEBSERVER */
@@ -358,11 +705,13 @@ print_local_addresses(void* data)
   int i;
   uint8_t state;
 
+  slip_debug_set_level(SLIP_DEBUG_INFO);
   PRINTA("Server IPv6 addresses:\n");
   for(i = 0; i < UIP_DS6_ADDR_NB; i++) {
     state = uip_ds6_if.addr_list[i].state;
     if(uip_ds6_if.addr_list[i].isused &&
        (state == ADDR_TENTATIVE || state == ADDR_PREFERRED)) {
+      slip_debug_set_level(SLIP_DEBUG_INFO);
       PRINTA(" ");
       uip_debug_ipaddr_print(&uip_ds6_if.addr_list[i].ipaddr);
       PRINTA("\n");
@@ -395,7 +744,7 @@ set_prefix_64(uip_ipaddr_t *prefix_64)
   dag = rpl_set_root(RPL_DEFAULT_INSTANCE, &ipaddr);
   if(dag != NULL) {
     rpl_set_prefix(dag, &prefix, 64);
-    PRINTF("created a new RPL dag\n");
+    SLIP_DEBUG_PRINTF(SLIP_DEBUG_INFO, "created a new RPL dag\n");
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -416,8 +765,9 @@ PROCESS_THREAD(border_router_process, ev, data)
   PROCESS_PAUSE();
 
   SENSORS_ACTIVATE(button_sensor);
+  br_stats_init();
 
-  PRINTF("RPL-Border router started\n");
+  SLIP_DEBUG_PRINTF(SLIP_DEBUG_INFO, "RPL-Border router started\n");
 #if 0
    /* The border router runs with a 100% duty cycle in order to ensure high
      packet reception rates.
@@ -432,10 +782,19 @@ PROCESS_THREAD(border_router_process, ev, data)
     request_prefix();
     PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
   }
+#if WITH_TSCH
+  /* Start the TSCH network as coordinator; the root listens on every
+   * uplink cell so collectors can keep their radios off elsewhere.
+   */
+  tsch_set_coordinator(1);
+  apc_tsch_schedule_init(1);
+  NETSTACK_MAC.on();
+#else
   /* Now turn the radio on, but disable radio duty cycling.
    * Since we are the DAG root, reception delays would constrain mesh throughbut.
    */
   NETSTACK_MAC.off(1);
+#endif /* WITH_TSCH */
 
 #if DEBUG || 1
   print_local_addresses(NULL);
@@ -444,7 +803,7 @@ PROCESS_THREAD(border_router_process, ev, data)
   while(1) {
     PROCESS_YIELD();
     if (ev == sensors_event && data == &button_sensor) {
-      PRINTF("Initiating global repair\n");
+      SLIP_DEBUG_PRINTF(SLIP_DEBUG_INFO, "Initiating global repair\n");
       rpl_repair_root(RPL_DEFAULT_INSTANCE);
     }
   }
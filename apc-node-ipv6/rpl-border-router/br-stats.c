@@ -0,0 +1,241 @@
+/**
+ * \file
+ *         Forwarding and queue statistics of the border router
+ */
+
+#include "contiki.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-icmp6.h"
+#include "net/rpl/rpl-private.h"
+#include "net/packetbuf.h"
+#include "net/queuebuf.h"
+#include "net/mac/mac.h"
+#include "net/rime/rime.h"
+#include "dev/slip.h"
+#include "br-stats.h"
+
+#define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+#if QUEUEBUF_CONF_STATS
+/* kept by queuebuf.c */
+extern uint8_t queuebuf_len;
+#endif /* QUEUEBUF_CONF_STATS */
+
+static struct br_stats stats;
+/* '!S' frame, built apart from uip_buf: the IP stack may still hold a packet
+ * there when the timer fires */
+static uint8_t frame[BR_STATS_FRAME_LEN];
+static uint8_t last_neighbor;
+static uint8_t oldest_neighbor;
+static struct ctimer stats_timer;
+/*---------------------------------------------------------------------------*/
+static uint8_t
+size_bin(uint16_t len)
+{
+  uint8_t bin = 0;
+
+  len >>= 6;
+  while(len > 0 && bin < BR_STATS_SIZE_BINS - 1) {
+    len >>= 1;
+    bin++;
+  }
+  return bin;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+br_stats_queuebuf_len(void)
+{
+#if QUEUEBUF_CONF_STATS
+  return queuebuf_len;
+#else /* QUEUEBUF_CONF_STATS */
+  return QUEUEBUF_NUM - queuebuf_numfree();
+#endif /* QUEUEBUF_CONF_STATS */
+}
+/*---------------------------------------------------------------------------*/
+void
+br_stats_slip_in(uint16_t len)
+{
+  uint8_t used = br_stats_queuebuf_len();
+
+  stats.slip_in_frames++;
+  stats.slip_in_bytes += len;
+  stats.slip_in_size[size_bin(len)]++;
+  stats.queue_depth[used == 0 ? 0 : 1 + (used - 1) * (BR_STATS_QUEUE_BINS - 1) / QUEUEBUF_NUM]++;
+  if(used > stats.queuebuf_max) {
+    stats.queuebuf_max = used;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+br_stats_slip_out(uint16_t len)
+{
+  stats.slip_out_frames++;
+  stats.slip_out_bytes += len;
+  stats.slip_out_size[size_bin(len)]++;
+}
+/*---------------------------------------------------------------------------*/
+void
+br_stats_bounce_drop(void)
+{
+  stats.bounce_drops++;
+}
+/*---------------------------------------------------------------------------*/
+/* Consecutive packets mostly go to the same neighbor, look there first */
+static struct br_stats_neighbor *
+neighbor_get(const linkaddr_t *addr)
+{
+  struct br_stats_neighbor *n = &stats.neighbors[last_neighbor];
+  uint8_t i;
+
+  if(linkaddr_cmp(&n->addr, addr)) {
+    return n;
+  }
+  for(i = 0; i < BR_STATS_NEIGHBORS; i++) {
+    if(linkaddr_cmp(&stats.neighbors[i].addr, addr)) {
+      last_neighbor = i;
+      return &stats.neighbors[i];
+    }
+  }
+  last_neighbor = oldest_neighbor;
+  oldest_neighbor = (oldest_neighbor + 1) % BR_STATS_NEIGHBORS;
+  n = &stats.neighbors[last_neighbor];
+  linkaddr_copy(&n->addr, addr);
+  n->tx_ok = 0;
+  n->tx_fail = 0;
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+/* RPL DAO in uip_buf, behind any extension headers */
+static int
+is_dao(void)
+{
+  uint8_t *hdr = &uip_buf[UIP_LLH_LEN + UIP_IPH_LEN];
+  uint8_t *end = &uip_buf[UIP_LLH_LEN + uip_len];
+  uint8_t next = UIP_IP_BUF->proto;
+  uint8_t i;
+
+  for(i = 0; i < 4 && (next == UIP_PROTO_HBHO || next == UIP_PROTO_ROUTING ||
+                       next == UIP_PROTO_DESTO); i++) {
+    if(hdr + 2 > end) {
+      return 0;
+    }
+    next = hdr[0];
+    hdr += (hdr[1] + 1) * 8;
+  }
+  return next == UIP_PROTO_ICMP6 && hdr + 2 <= end &&
+    hdr[0] == ICMP6_RPL && hdr[1] == RPL_CODE_DAO;
+}
+/*---------------------------------------------------------------------------*/
+/* IP packet from the radio, called by sicslowpan before it is delivered */
+static void
+radio_input(void)
+{
+  stats.radio_in++;
+  if(is_dao()) {
+    stats.dao_in++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Outcome of a unicast or broadcast frame, after MAC retries */
+static void
+radio_output(int mac_status)
+{
+  const linkaddr_t *dest = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+  struct br_stats_neighbor *n = NULL;
+
+  if(!linkaddr_cmp(dest, &linkaddr_null)) {
+    n = neighbor_get(dest);
+  }
+  switch(mac_status) {
+  case MAC_TX_OK:
+    stats.tx_ok++;
+    break;
+  case MAC_TX_NOACK:
+    stats.tx_noack++;
+    break;
+  case MAC_TX_COLLISION:
+    stats.tx_collision++;
+    break;
+  default:
+    stats.tx_err++;
+    break;
+  }
+  if(n != NULL) {
+    if(mac_status == MAC_TX_OK) {
+      n->tx_ok++;
+    } else {
+      n->tx_fail++;
+    }
+  }
+}
+RIME_SNIFFER(stats_sniffer, radio_input, radio_output);
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put16(uint8_t *p, uint16_t v)
+{
+  *p++ = v & 0xff;
+  *p++ = v >> 8;
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put32(uint8_t *p, uint32_t v)
+{
+  p = put16(p, v & 0xffff);
+  return put16(p, v >> 16);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+put16_array(uint8_t *p, const uint16_t *v, uint8_t n)
+{
+  while(n-- > 0) {
+    p = put16(p, *v++);
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+/* '!S' frame to the host, see br-stats.h for the layout */
+static void
+send_stats(void *ptr)
+{
+  uint8_t *p = frame;
+
+  *p++ = '!';
+  *p++ = 'S';
+  *p++ = BR_STATS_FRAME_VERSION;
+  p = put32(p, stats.slip_in_frames);
+  p = put32(p, stats.slip_in_bytes);
+  p = put32(p, stats.slip_out_frames);
+  p = put32(p, stats.slip_out_bytes);
+  p = put16(p, stats.bounce_drops);
+  p = put16(p, stats.radio_in);
+  p = put16(p, stats.dao_in);
+  p = put16(p, stats.tx_ok);
+  p = put16(p, stats.tx_noack);
+  p = put16(p, stats.tx_collision);
+  p = put16(p, stats.tx_err);
+  *p++ = br_stats_queuebuf_len();
+  *p++ = stats.queuebuf_max;
+  *p++ = QUEUEBUF_NUM;
+  p = put16_array(p, stats.slip_in_size, BR_STATS_SIZE_BINS);
+  p = put16_array(p, stats.slip_out_size, BR_STATS_SIZE_BINS);
+  p = put16_array(p, stats.queue_depth, BR_STATS_QUEUE_BINS);
+  slip_write(frame, p - frame);
+  ctimer_reset(&stats_timer);
+}
+/*---------------------------------------------------------------------------*/
+const struct br_stats *
+br_stats_get(void)
+{
+  return &stats;
+}
+/*---------------------------------------------------------------------------*/
+void
+br_stats_init(void)
+{
+  rime_sniffer_add(&stats_sniffer);
+  if(BR_STATS_INTERVAL > 0) {
+    ctimer_set(&stats_timer, BR_STATS_INTERVAL, send_stats, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
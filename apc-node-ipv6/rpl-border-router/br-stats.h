@@ -0,0 +1,77 @@
+#ifndef BR_STATS_H_
+#define BR_STATS_H_
+/*---------------------------------------------------------------------------*/
+/* Forwarding and queue statistics of the border router, served as /stats
+ * by the web server and sent periodically to the host as '!S' SLIP frames.
+ * The SLIP hooks are O(1) per packet. The TX outcome hook looks up the
+ * neighbor in a small fixed array: the last neighbor found is checked first,
+ * any other costs a linear scan of BR_STATS_NEIGHBORS entries.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/linkaddr.h"
+/*---------------------------------------------------------------------------*/
+/* '!S' frame interval, 0 to send none */
+#ifdef BR_STATS_CONF_INTERVAL
+#define BR_STATS_INTERVAL BR_STATS_CONF_INTERVAL
+#else
+#define BR_STATS_INTERVAL (60 * CLOCK_SECOND)
+#endif
+/* Neighbors with their own TX counters, the oldest entry makes room */
+#ifdef BR_STATS_CONF_NEIGHBORS
+#define BR_STATS_NEIGHBORS BR_STATS_CONF_NEIGHBORS
+#else
+#define BR_STATS_NEIGHBORS 16
+#endif
+/* Packet sizes 0-63, 64-127, 128-255, 256-511, 512+ */
+#define BR_STATS_SIZE_BINS  5
+/* Queue buffers in use: none, then quarters of QUEUEBUF_NUM */
+#define BR_STATS_QUEUE_BINS 5
+/*---------------------------------------------------------------------------*/
+struct br_stats_neighbor {
+  linkaddr_t addr;
+  uint16_t tx_ok;
+  uint16_t tx_fail;             /* no ACK, collision or error after retries */
+};
+/*---------------------------------------------------------------------------*/
+struct br_stats {
+  /* IP packets over SLIP, configuration frames not included */
+  uint32_t slip_in_frames;
+  uint32_t slip_in_bytes;
+  uint32_t slip_out_frames;
+  uint32_t slip_out_bytes;
+  uint16_t bounce_drops;        /* no route, would go back out over SLIP */
+  uint16_t radio_in;            /* IP packets from the radio, reassembled */
+  uint16_t dao_in;              /* RPL DAOs received */
+  uint16_t tx_ok;
+  uint16_t tx_noack;
+  uint16_t tx_collision;
+  uint16_t tx_err;
+  uint8_t queuebuf_max;         /* queue buffers in use, high-water mark */
+  uint16_t slip_in_size[BR_STATS_SIZE_BINS];
+  uint16_t slip_out_size[BR_STATS_SIZE_BINS];
+  uint16_t queue_depth[BR_STATS_QUEUE_BINS];  /* at every packet from SLIP */
+  struct br_stats_neighbor neighbors[BR_STATS_NEIGHBORS];
+};
+/*---------------------------------------------------------------------------*/
+/* '!S' frame, little endian:
+ * '!' 'S' version(1) slip_in_frames(4) slip_in_bytes(4) slip_out_frames(4)
+ * slip_out_bytes(4) bounce_drops(2) radio_in(2) dao_in(2) tx_ok(2)
+ * tx_noack(2) tx_collision(2) tx_err(2) queuebuf_len(1) queuebuf_max(1)
+ * queuebuf_num(1) slip_in_size(2 x 5) slip_out_size(2 x 5) queue_depth(2 x 5)
+ */
+#define BR_STATS_FRAME_VERSION 1
+#define BR_STATS_FRAME_LEN \
+  (3 + 4 * 4 + 7 * 2 + 3 + 2 * (2 * BR_STATS_SIZE_BINS + BR_STATS_QUEUE_BINS))
+/*---------------------------------------------------------------------------*/
+void br_stats_init(void);
+const struct br_stats *br_stats_get(void);
+/* Queue buffers in use now */
+uint8_t br_stats_queuebuf_len(void);
+/*---------------------------------------------------------------------------*/
+/* Hooks of the SLIP bridge, len is the IP packet length */
+void br_stats_slip_in(uint16_t len);
+void br_stats_slip_out(uint16_t len);
+void br_stats_bounce_drop(void);
+/*---------------------------------------------------------------------------*/
+#endif /* BR_STATS_H_ */
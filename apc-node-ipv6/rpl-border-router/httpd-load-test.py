@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+""" Load test for the border router web server (httpd-simple.c).
+
+Runs parallel HTTP clients against the routes page (or one of the JSON
+tables, /neighbors.json and /routes.json) and checks that every response is
+a complete, well-formed page: segments from concurrent connections or
+retransmissions must never be interleaved or repeated.
+Connections refused because all server connection slots are busy
+(WEBSERVER_CONF_CFS_CONNS) are counted separately and are not errors.
+
+    python3 httpd-load-test.py http://[fd00::1]/ --clients 4 --requests 50
+"""
+import argparse
+import json
+import re
+import socket
+import threading
+import time
+from urllib.parse import urlsplit
+
+TOP = '<html><head><title>ContikiRPL</title></head><body>\n'
+BOTTOM = '</body></html>\n'
+PAGE_RE = re.compile(
+    r'^Neighbors<pre>(?P<neighbors>[^<]*)</pre>'
+    r'Routes<pre>\n(?P<routes>[^<]*)</pre>'
+    r'(?:Links<pre>\n(?P<links>[^<]*)</pre>)?'
+    r'(?: <i>\(\d+\.\d\d sec\)</i>)?$')
+ADDR = r'[0-9a-f:]+'
+NEIGHBOR_RE = re.compile(r'^{}( +(INCOMPLETE|REACHABLE|STALE|DELAY|NBR_PROBE))?$'.format(ADDR))
+ROUTE_RE = re.compile(r'^{0}/\d+ \(via {0}\) \d+s$'.format(ADDR))
+LINK_RE = re.compile(r'^{0} \(parent: {0}\) \d+s$'.format(ADDR))
+
+
+def check_json(head: str, body: str):
+    """ :return: None if body is a well-formed JSON table, else the reason """
+    if 'Content-type: application/json' not in head:
+        return 'not served as json'
+    try:
+        table = json.loads(body)
+    except ValueError:
+        return 'garbled json'
+    names = [name for name in table if name != 'next']
+    if len(names) != 1 or not isinstance(table[names[0]], list) or 'next' not in table:
+        return 'unexpected json layout'
+    for entry in table[names[0]]:
+        if not isinstance(entry, dict):
+            return 'garbled {} entry: {!r}'.format(names[0], entry)
+    return None
+
+
+def check_page(response: bytes, is_json: bool = False):
+    """ :return: None if the response is a well-formed routes page, else the reason """
+    try:
+        text = response.decode('ascii')
+    except UnicodeDecodeError:
+        return 'not ascii'
+    head, sep, body = text.partition('\r\n\r\n')
+    if not sep:
+        return 'no header terminator'
+    if not head.startswith('HTTP/1.0 200'):
+        return 'status: ' + head.split('\r\n', 1)[0]
+    if is_json:
+        return check_json(head, body)
+    if not body.startswith(TOP) or not body.endswith(BOTTOM):
+        return 'truncated page'
+    match = PAGE_RE.match(body[len(TOP):-len(BOTTOM)])
+    if match is None:
+        return 'garbled page structure'
+    for section, line_re in (('neighbors', NEIGHBOR_RE), ('routes', ROUTE_RE), ('links', LINK_RE)):
+        for line in (match.group(section) or '').splitlines():
+            if not line_re.match(line):
+                return 'garbled {} line: {!r}'.format(section, line)
+    return None
+
+
+def fetch(host: str, port: int, path: str, timeout: float):
+    family = socket.AF_INET6 if ':' in host else socket.AF_INET
+    with socket.socket(family, socket.SOCK_STREAM) as sock:
+        sock.settimeout(timeout)
+        sock.connect((host, port))
+        sock.sendall('GET {} HTTP/1.0\r\n\r\n'.format(path).encode('ascii'))
+        chunks = []
+        while True:
+            chunk = sock.recv(4096)
+            if not chunk:
+                break
+            chunks.append(chunk)
+    return b''.join(chunks)
+
+
+class LoadTest:
+    def __init__(self, url: str, clients: int, requests: int, timeout: float):
+        parts = urlsplit(url)
+        self.host = parts.hostname
+        self.port = parts.port or 80
+        self.path = parts.path or '/'
+        self.is_json = self.path.endswith('.json')
+        if parts.query:
+            self.path += '?' + parts.query
+        self.clients = clients
+        self.requests = requests
+        self.timeout = timeout
+        self.lock = threading.Lock()
+        self.latencies = []
+        self.refused = 0
+        self.errors = []
+
+    def client(self):
+        for _ in range(self.requests):
+            start = time.monotonic()
+            try:
+                response = fetch(self.host, self.port, self.path, self.timeout)
+            except (ConnectionRefusedError, ConnectionResetError):
+                with self.lock:
+                    self.refused += 1
+                continue
+            except OSError as e:
+                with self.lock:
+                    self.errors.append('socket: {}'.format(e))
+                continue
+            elapsed = time.monotonic() - start
+            if not response:
+                # reset before any data: no free connection slot on the server
+                with self.lock:
+                    self.refused += 1
+                continue
+            reason = check_page(response, self.is_json)
+            with self.lock:
+                if reason is None:
+                    self.latencies.append(elapsed)
+                else:
+                    self.errors.append(reason)
+
+    def run(self):
+        threads = [threading.Thread(target=self.client) for _ in range(self.clients)]
+        start = time.monotonic()
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        return time.monotonic() - start
+
+    def report(self, duration: float):
+        print('{} clients x {} requests in {:.1f} s'.format(self.clients, self.requests, duration))
+        print('ok {}, refused {}, corrupt/failed {}'.format(len(self.latencies), self.refused, len(self.errors)))
+        if self.latencies:
+            latencies = sorted(self.latencies)
+            pick = lambda q: latencies[min(len(latencies) - 1, int(q * len(latencies)))] * 1000
+            print('latency ms: p50 {:.0f}, p95 {:.0f}, max {:.0f}; {:.2f} pages/s'.format(
+                pick(0.5), pick(0.95), latencies[-1] * 1000, len(latencies) / duration))
+        for reason in sorted(set(self.errors)):
+            print('  {} x {}'.format(self.errors.count(reason), reason))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Parallel HTTP load test for the border router web server')
+    parser.add_argument('url', help='page to fetch, e.g. http://[fd00::1]/ or http://[fd00::1]/routes.json')
+    parser.add_argument('--clients', type=int, default=4, help='parallel clients (default 4)')
+    parser.add_argument('--requests', type=int, default=25, help='requests per client (default 25)')
+    parser.add_argument('--timeout', type=float, default=30.0, help='per request timeout in seconds')
+    args = parser.parse_args()
+
+    test = LoadTest(args.url, args.clients, args.requests, args.timeout)
+    test.report(test.run())
+    return 1 if test.errors or not test.latencies else 0
+
+
+if __name__ == '__main__':
+    exit(main())
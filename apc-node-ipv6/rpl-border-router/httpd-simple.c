@@ -89,6 +89,20 @@ PT_THREAD(send_string(struct httpd_state *s, const char *str))
 }
 /*---------------------------------------------------------------------------*/
 const char http_content_type_html[] = "Content-type: text/html\r\n\r\n";
+const char http_content_type_json[] = "Content-type: application/json\r\n\r\n";
+const char http_json[] = ".json";
+static const char *
+content_type(const char *filename)
+{
+  const char *ptr = strchr(filename, '?');
+  size_t len = ptr != NULL ? ptr - filename : strlen(filename);
+  size_t ext = sizeof(http_json) - 1;
+
+  if(len >= ext && strncmp(filename + len - ext, http_json, ext) == 0) {
+    return http_content_type_json;
+  }
+  return http_content_type_html;
+}
 static
 PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr))
 {
@@ -115,7 +129,7 @@ PT_THREAD(send_headers(struct httpd_state *s, const char *statushdr))
   /*   s->ptr = http_content_type_binary; */
   /* } */
   /* SEND_STRING(&s->sout, s->ptr); */
-  SEND_STRING(&s->sout, http_content_type_html);
+  SEND_STRING(&s->sout, content_type(s->filename));
   PSOCK_END(&s->sout);
 }
 /*---------------------------------------------------------------------------*/
@@ -176,6 +190,7 @@ PT_THREAD(handle_input(struct httpd_state *s))
     s->inputbuf[PSOCK_DATALEN(&s->sin) - 1] = 0;
     strncpy(s->filename, s->inputbuf, sizeof(s->filename));
   }
+  s->filename[sizeof(s->filename) - 1] = 0;
 #endif /* URLCONV */
 
   webserver_log_file(&uip_conn->ripaddr, s->filename);
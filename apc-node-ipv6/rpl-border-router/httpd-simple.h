@@ -42,8 +42,8 @@
 
 #include "contiki-net.h"
 
-/* The current internal border router webserver ignores the requested file name */
-/* and needs no per-connection output buffer, so save some RAM */
+/* The border router webserver needs no per-connection output buffer; the */
+/* path, query string included, selects the page (see project-conf.h) */
 #ifndef WEBSERVER_CONF_CFS_PATHLEN
 #define HTTPD_PATHLEN 2
 #else /* WEBSERVER_CONF_CFS_CONNS */
@@ -53,6 +53,13 @@
 struct httpd_state;
 typedef char (* httpd_simple_script_t)(struct httpd_state *s);
 
+/* Position of a script in the page it generates */
+struct httpd_cursor {
+  uint8_t section;
+  uint16_t index;
+  uint16_t count;   /* items written in the section so far */
+};
+
 struct httpd_state {
   struct timer timer;
   struct psock sin, sout;
@@ -62,6 +69,13 @@ struct httpd_state {
   char filename[HTTPD_PATHLEN];
   httpd_simple_script_t script;
   char state;
+  /* Scripts generate one segment at a time with PSOCK_GENERATOR_SEND:
+   * cursor is where the unacked segment starts, next where it ends.
+   */
+  struct httpd_cursor cursor, next;
+  clock_time_t start;
+  /* ?since= and ?limit= of the request */
+  uint16_t since, limit;
 };
 
 void httpd_init(void);
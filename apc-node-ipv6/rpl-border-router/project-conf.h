@@ -41,22 +41,47 @@
 #endif /* WITH_NON_STORING */
 
 #if WITH_NON_STORING
-#undef RPL_NS_CONF_LINK_NUM
-#define RPL_NS_CONF_LINK_NUM 40 /* Number of links maintained at the root */
+#ifndef RPL_NS_CONF_LINK_NUM
+#define RPL_NS_CONF_LINK_NUM 40 /* Number of links maintained at the root (make NS_LINK_NUM=<n>) */
+#endif
 #undef UIP_CONF_MAX_ROUTES
 #define UIP_CONF_MAX_ROUTES 0 /* No need for routes */
 #undef RPL_CONF_MOP
 #define RPL_CONF_MOP RPL_MOP_NON_STORING /* Mode of operation*/
 #endif /* WITH_NON_STORING */
 
+#ifndef WITH_TSCH
+#define WITH_TSCH 0 /* Set this to run over TSCH (make MAKE_WITH_TSCH=1) */
+#endif /* WITH_TSCH */
+
+#if WITH_TSCH
+#include "../apc-tsch-conf.h"
+#endif /* WITH_TSCH */
+
 #ifndef UIP_FALLBACK_INTERFACE
 #define UIP_FALLBACK_INTERFACE rpl_interface
 #endif
 
+/* SLIP link to tunslip6 (make SLIP_BAUDRATE=460800), tunslip6 -B must match.
+ * On the Zoul the baud rate of UART0 is fixed at build time. Cooja ignores it,
+ * its serial socket runs as fast as the simulation.
+ */
+#ifndef SLIP_BRIDGE_CONF_BAUDRATE
+#define SLIP_BRIDGE_CONF_BAUDRATE 115200
+#endif
+#ifndef UART0_CONF_BAUD_RATE
+#define UART0_CONF_BAUD_RATE SLIP_BRIDGE_CONF_BAUDRATE
+#endif
+
 #ifndef QUEUEBUF_CONF_NUM
 #define QUEUEBUF_CONF_NUM       24
 #endif
 
+/* Queue buffers in use, for the /stats page */
+#ifndef QUEUEBUF_CONF_STATS
+#define QUEUEBUF_CONF_STATS     1
+#endif
+
 #ifndef UIP_CONF_BUFFER_SIZE
 #define UIP_CONF_BUFFER_SIZE    500
 #endif
@@ -69,4 +94,9 @@
 #define WEBSERVER_CONF_CFS_CONNS 2
 #endif
 
+/* Room for "/neighbors.json?since=65535&limit=65535" */
+#ifndef WEBSERVER_CONF_CFS_PATHLEN
+#define WEBSERVER_CONF_CFS_PATHLEN 40
+#endif
+
 #endif /* PROJECT_ROUTER_CONF_H_ */
@@ -0,0 +1,342 @@
+#!/usr/bin/env python3
+""" SLIP link benchmark for the border router (slip-bridge.c).
+
+Stands in for tunslip6 on the host end of the SLIP link: sends ICMPv6 echo
+requests over SLIP and times the echo replies, reporting packets/s, loss and
+round trip latency. Stop tunslip6 before running it against the mote:
+
+    python3 slip-bench.py /dev/ttyUSB0 --baud 460800 --target fd00::212:4b00:615:a5f2
+
+With --emulate the mote is replaced by a model on a pty: a UART at each baud
+rate, a packet queue of each QUEUEBUF_CONF_NUM size and a radio hop to a
+neighbor and back, to see where the link stops being the bottleneck:
+
+    python3 slip-bench.py --emulate --baud 115200 460800 921600 --queuebuf 8 24
+"""
+import argparse
+import collections
+import ipaddress
+import os
+import select
+import struct
+import termios
+import threading
+import time
+import tty
+
+SLIP_END = 0o300
+SLIP_ESC = 0o333
+SLIP_ESC_END = 0o334
+SLIP_ESC_ESC = 0o335
+ICMP6_ECHO_REQUEST = 128
+ICMP6_ECHO_REPLY = 129
+ECHO_IDENT = 0x5b1e
+# '!S' statistics frame of the border router (br-stats.h), version 1
+STATS_FORMAT = struct.Struct('<B4I7H3B5H5H5H')
+STATS_FIELDS = ('version', 'slip_in_frames', 'slip_in_bytes', 'slip_out_frames', 'slip_out_bytes',
+                'bounce_drops', 'radio_in', 'dao_in', 'tx_ok', 'tx_noack', 'tx_collision', 'tx_err',
+                'queuebuf_len', 'queuebuf_max', 'queuebuf_num')
+
+
+def slip_encode(packet: bytes):
+    out = bytearray([SLIP_END])
+    for b in packet:
+        if b == SLIP_END:
+            out += bytes([SLIP_ESC, SLIP_ESC_END])
+        elif b == SLIP_ESC:
+            out += bytes([SLIP_ESC, SLIP_ESC_ESC])
+        else:
+            out.append(b)
+    out.append(SLIP_END)
+    return bytes(out)
+
+
+class SlipDecoder:
+    def __init__(self):
+        self.frame = bytearray()
+        self.escaped = False
+
+    def feed(self, data: bytes):
+        """ :return: the frames completed by data """
+        frames = []
+        for b in data:
+            if b == SLIP_END:
+                if self.frame:
+                    frames.append(bytes(self.frame))
+                self.frame = bytearray()
+            elif self.escaped:
+                self.frame.append({SLIP_ESC_END: SLIP_END, SLIP_ESC_ESC: SLIP_ESC}.get(b, b))
+                self.escaped = False
+            elif b == SLIP_ESC:
+                self.escaped = True
+            else:
+                self.frame.append(b)
+        return frames
+
+
+def icmp6_echo(src: bytes, dst: bytes, icmp_type: int, seq: int, payload: bytes):
+    """ :return: IPv6 packet carrying an ICMPv6 echo request/reply """
+    icmp = struct.pack('!BBHHH', icmp_type, 0, 0, ECHO_IDENT, seq) + payload
+    pseudo = src + dst + struct.pack('!I3xB', len(icmp), 58) + icmp
+    if len(pseudo) % 2:
+        pseudo += b'\0'
+    total = sum(struct.unpack('!{}H'.format(len(pseudo) // 2), pseudo))
+    while total >> 16:
+        total = (total & 0xffff) + (total >> 16)
+    icmp = icmp[:2] + struct.pack('!H', ~total & 0xffff) + icmp[4:]
+    return struct.pack('!IHBB', 6 << 28, len(icmp), 58, 64) + src + dst + icmp
+
+
+def parse_echo(packet: bytes):
+    """ :return: (type, seq, src, dst) of an ICMPv6 echo packet, else None """
+    if len(packet) < 48 or packet[0] >> 4 != 6 or packet[6] != 58:
+        return None
+    icmp_type, _, _, ident, seq = struct.unpack('!BBHHH', packet[40:48])
+    if icmp_type not in (ICMP6_ECHO_REQUEST, ICMP6_ECHO_REPLY) or ident != ECHO_IDENT:
+        return None
+    return icmp_type, seq, packet[8:24], packet[24:40]
+
+
+def parse_stats(frame: bytes):
+    """ :return: dict of a '!S' statistics frame, None if it is not one """
+    if frame[:2] != b'!S' or len(frame) != 2 + STATS_FORMAT.size or frame[2] != 1:
+        return None
+    values = STATS_FORMAT.unpack(frame[2:])
+    stats = dict(zip(STATS_FIELDS, values))
+    bins = values[len(STATS_FIELDS):]
+    stats['slip_in_size'], stats['slip_out_size'], stats['queue_depth'] = bins[:5], bins[5:10], bins[10:]
+    return stats
+
+
+class Link:
+    """ One end of the serial line. When paced, writes take as long as the
+    bytes would on a UART at baud (8N1), as a pty has no baud rate.
+    """
+    def __init__(self, fd: int, baud: int, paced: bool):
+        self.fd = fd
+        self.byte_time = 10.0 / baud
+        self.paced = paced
+        self.line_free = 0.0
+        self.lock = threading.Lock()
+
+    def write(self, data: bytes):
+        with self.lock:
+            if self.paced:
+                # the far end gets the frame once it is all on the line
+                self.line_free = max(time.monotonic(), self.line_free) + len(data) * self.byte_time
+                delay = self.line_free - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+            view = memoryview(data)
+            while view:
+                view = view[os.write(self.fd, view):]
+
+
+def open_serial(path: str, baud: int):
+    speed = getattr(termios, 'B{}'.format(baud), None)
+    if speed is None:
+        raise SystemExit('baud rate {} not supported by this host'.format(baud))
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    attrs[4] = attrs[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+class EmulatedRouter:
+    """ Border router end of the link: frames from the host wait in a queue of
+    queuebuf packets (QUEUEBUF_CONF_NUM) for the radio, which takes them to a
+    neighbor and back at radio_kbps before the reply goes out over SLIP.
+    """
+    def __init__(self, fd: int, baud: int, queuebuf: int, radio_kbps: float):
+        self.fd = fd
+        self.link = Link(fd, baud, paced=True)
+        self.queuebuf = queuebuf
+        self.radio_bps = radio_kbps * 1000
+        self.queue = collections.deque()
+        self.ready = threading.Condition()
+        self.stopped = threading.Event()
+        self.drops = 0
+        self.high_water = 0
+        self.threads = []
+
+    def start(self):
+        self.threads = [threading.Thread(target=target) for target in (self.receive, self.radio)]
+        for thread in self.threads:
+            thread.start()
+
+    def stop(self):
+        self.stopped.set()
+        with self.ready:
+            self.ready.notify()
+        for thread in self.threads:
+            thread.join()
+
+    def receive(self):
+        decoder = SlipDecoder()
+        while not self.stopped.is_set():
+            if not select.select([self.fd], [], [], 0.05)[0]:
+                continue
+            for frame in decoder.feed(os.read(self.fd, 4096)):
+                if parse_echo(frame) is None:
+                    continue
+                with self.ready:
+                    if len(self.queue) >= self.queuebuf:
+                        self.drops += 1
+                        continue
+                    self.queue.append(frame)
+                    self.high_water = max(self.high_water, len(self.queue))
+                    self.ready.notify()
+
+    def radio(self):
+        while not self.stopped.is_set():
+            with self.ready:
+                while not self.queue and not self.stopped.is_set():
+                    self.ready.wait()
+                if self.stopped.is_set():
+                    return
+                frame = self.queue[0]
+            if self.radio_bps > 0:
+                # there and back, the buffer is only freed once the frame is sent
+                time.sleep(2 * len(frame) * 8 / self.radio_bps)
+            with self.ready:
+                self.queue.popleft()
+            _, seq, src, dst = parse_echo(frame)
+            self.link.write(slip_encode(icmp6_echo(dst, src, ICMP6_ECHO_REPLY, seq, frame[48:])))
+
+
+class Bench:
+    def __init__(self, link: Link, source: str, target: str, prefix: str, verbose: bool):
+        self.link = link
+        self.source = ipaddress.IPv6Address(source).packed
+        self.target = ipaddress.IPv6Address(target).packed
+        self.prefix = ipaddress.IPv6Network(prefix).network_address.packed[:8]
+        self.verbose = verbose
+        self.sent = {}
+        self.rtts = []
+        self.last_reply = None
+        self.lock = threading.Lock()
+        self.stopped = threading.Event()
+
+    def receive(self):
+        decoder = SlipDecoder()
+        while not self.stopped.is_set():
+            if not select.select([self.link.fd], [], [], 0.05)[0]:
+                continue
+            now = time.monotonic()
+            for frame in decoder.feed(os.read(self.link.fd, 4096)):
+                if frame[:2] == b'?P':
+                    # prefix request, answered like tunslip6 does
+                    self.link.write(slip_encode(b'!P' + self.prefix))
+                    continue
+                if frame[:2] == b'!S':
+                    if self.verbose:
+                        print('router stats:', parse_stats(frame))
+                    continue
+                if frame[:1] == b'\r':
+                    if self.verbose:
+                        print('router:', frame[1:].decode('ascii', 'replace').rstrip())
+                    continue
+                echo = parse_echo(frame)
+                if echo is None or echo[0] != ICMP6_ECHO_REPLY:
+                    continue
+                with self.lock:
+                    start = self.sent.pop(echo[1], None)
+                    if start is not None:
+                        self.rtts.append(now - start)
+                        self.last_reply = now
+
+    def run(self, count: int, size: int, rate: float, timeout: float):
+        """ :return: seconds from the first request to the last reply """
+        receiver = threading.Thread(target=self.receive)
+        receiver.start()
+        payload = bytes(i & 0xff for i in range(size))
+        start = time.monotonic()
+        for seq in range(count):
+            packet = slip_encode(icmp6_echo(self.source, self.target, ICMP6_ECHO_REQUEST, seq, payload))
+            if rate > 0:
+                delay = start + seq / rate - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+            with self.lock:
+                self.sent[seq] = time.monotonic()
+            self.link.write(packet)
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            with self.lock:
+                if not self.sent:
+                    break
+            time.sleep(0.01)
+        self.stopped.set()
+        receiver.join()
+        return (self.last_reply or time.monotonic()) - start
+
+
+def report_row(baud, queuebuf, count: int, rtts: list, duration: float, extra: str = ''):
+    rtts = sorted(rtts)
+    pick = lambda q: rtts[min(len(rtts) - 1, int(q * len(rtts)))] * 1000 if rtts else float('nan')
+    loss = 100.0 * (count - len(rtts)) / count
+    print('{:>7} {:>8} {:>6} {:>6} {:>6.1f} {:>8.1f} {:>8.1f} {:>8.1f} {}'.format(
+        baud, queuebuf, count, len(rtts), loss, len(rtts) / duration if duration > 0 else 0,
+        pick(0.5), pick(0.95), extra))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='SLIP link throughput and latency benchmark')
+    parser.add_argument('device', nargs='?', help='serial port of the border router')
+    parser.add_argument('--emulate', action='store_true', help='emulated border router on a pty')
+    parser.add_argument('--baud', type=int, nargs='+', default=[115200],
+                        help='baud rate(s), one per run unless --emulate (default 115200)')
+    parser.add_argument('--queuebuf', type=int, nargs='+', default=[24],
+                        help='emulated QUEUEBUF_CONF_NUM size(s) (default 24)')
+    parser.add_argument('--radio-kbps', type=float, default=50.0,
+                        help='emulated effective radio rate, 0 to ping the router itself (default 50 kbps)')
+    parser.add_argument('--count', type=int, default=200, help='echo requests per run (default 200)')
+    parser.add_argument('--size', type=int, default=64, help='echo payload bytes (default 64)')
+    parser.add_argument('--rate', type=float, default=0, help='requests/s, 0 for back to back (default)')
+    parser.add_argument('--timeout', type=float, default=5.0, help='wait for replies after the last request')
+    parser.add_argument('--source', default='fd00::1', help='host address (default fd00::1, as tunslip6)')
+    parser.add_argument('--target', default='fd00::2', help='address to ping (the router or a mote)')
+    parser.add_argument('--prefix', default='fd00::/64', help='prefix given to the router if it asks')
+    parser.add_argument('--verbose', action='store_true', help='print router debug lines and statistics')
+    args = parser.parse_args()
+    if args.emulate == (args.device is not None):
+        parser.error('give either a device or --emulate')
+
+    print('{:>7} {:>8} {:>6} {:>6} {:>6} {:>8} {:>8} {:>8}'.format(
+        'baud', 'queuebuf', 'sent', 'recv', 'loss%', 'pkt/s', 'p50 ms', 'p95 ms'))
+    if not args.emulate:
+        if len(args.baud) != 1:
+            parser.error('the router runs at one baud rate, rebuild it with SLIP_BAUDRATE for another')
+        fd = open_serial(args.device, args.baud[0])
+        try:
+            bench = Bench(Link(fd, args.baud[0], paced=False), args.source, args.target, args.prefix, args.verbose)
+            duration = bench.run(args.count, args.size, args.rate, args.timeout)
+            report_row(args.baud[0], 'build', args.count, bench.rtts, duration)
+        finally:
+            os.close(fd)
+        return 0
+
+    for baud in args.baud:
+        for queuebuf in args.queuebuf:
+            host_fd, router_fd = os.openpty()
+            tty.setraw(host_fd)
+            tty.setraw(router_fd)
+            router = EmulatedRouter(router_fd, baud, queuebuf, args.radio_kbps)
+            router.start()
+            try:
+                bench = Bench(Link(host_fd, baud, paced=True), args.source, args.target, args.prefix, False)
+                duration = bench.run(args.count, args.size, args.rate, args.timeout)
+            finally:
+                router.stop()
+                os.close(host_fd)
+                os.close(router_fd)
+            report_row(baud, queuebuf, args.count, bench.rtts, duration,
+                       'drops {} high-water {}'.format(router.drops, router.high_water))
+    return 0
+
+
+if __name__ == '__main__':
+    exit(main())
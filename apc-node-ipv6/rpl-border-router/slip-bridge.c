@@ -42,6 +42,9 @@
 #include "net/ipv6/uip-ds6.h"
 #include "dev/slip.h"
 #include "dev/uart1.h"
+#include "slip-debug.h"
+#include "br-stats.h"
+#include <stdio.h>
 #include <string.h>
 
 #define UIP_IP_BUF        ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
@@ -49,6 +52,12 @@
 #define DEBUG DEBUG_PRINT
 #include "net/ip/uip-debug.h"
 
+#ifdef SLIP_BRIDGE_CONF_BAUDRATE
+#define SLIP_BRIDGE_BAUDRATE SLIP_BRIDGE_CONF_BAUDRATE
+#else
+#define SLIP_BRIDGE_BAUDRATE 115200
+#endif
+
 void set_prefix_64(uip_ipaddr_t *);
 
 static uip_ipaddr_t last_sender;
@@ -86,18 +95,27 @@ slip_input_callback(void)
       
     }
     uip_clear_buf();
+  } else {
+    br_stats_slip_in(uip_len);
   }
   /* Save the last sender received over SLIP to avoid bouncing the
      packet back if no route is found */
   uip_ipaddr_copy(&last_sender, &UIP_IP_BUF->srcipaddr);
 }
 /*---------------------------------------------------------------------------*/
+#if !SLIP_BRIDGE_CONF_NO_PUTCHAR
+PROCESS(slip_debug_process, "SLIP debug");
+#endif
+/*---------------------------------------------------------------------------*/
 static void
 init(void)
 {
-  slip_arch_init(BAUD2UBR(115200));
+  slip_arch_init(BAUD2UBR(SLIP_BRIDGE_BAUDRATE));
   process_start(&slip_process, NULL);
   slip_set_input_callback(slip_input_callback);
+#if !SLIP_BRIDGE_CONF_NO_PUTCHAR
+  process_start(&slip_debug_process, NULL);
+#endif
 }
 /*---------------------------------------------------------------------------*/
 static int
@@ -106,6 +124,7 @@ output(void)
   if(uip_ipaddr_cmp(&last_sender, &UIP_IP_BUF->srcipaddr)) {
     /* Do not bounce packets back over SLIP if the packet was received
        over SLIP */
+    br_stats_bounce_drop();
     PRINTF("slip-bridge: Destination off-link but no route src=");
     PRINT6ADDR(&UIP_IP_BUF->srcipaddr);
     PRINTF(" dst=");
@@ -113,6 +132,7 @@ output(void)
     PRINTF("\n");
   } else {
  //   PRINTF("SUT: %u\n", uip_len);
+    br_stats_slip_out(uip_len);
     slip_send();
   }
   return 0;
@@ -120,34 +140,222 @@ output(void)
 
 /*---------------------------------------------------------------------------*/
 #if !SLIP_BRIDGE_CONF_NO_PUTCHAR
+#define SLIP_END     0300
+enum { LINE_START, LINE_KEEP, LINE_DROP };
+struct token_bucket {
+  uint32_t tokens;              /* in 1/CLOCK_SECOND lines */
+  clock_time_t last;
+  uint8_t started;              /* starts full */
+};
+static const uint8_t rates[SLIP_DEBUG_LEVELS] = SLIP_DEBUG_RATES;
+static const uint8_t bursts[SLIP_DEBUG_LEVELS] = SLIP_DEBUG_BURSTS;
+static struct token_bucket buckets[SLIP_DEBUG_LEVELS];
+static struct slip_debug_stats debug_stats;
+/* One slot always stays free, so put == get means empty */
+static char debug_buf[SLIP_DEBUG_BUFSIZE];
+static uint16_t debug_put, debug_get;
+static uint16_t lines_ready;
+static uint8_t line_level = SLIP_DEBUG_TRACE;
+static uint8_t line_state = LINE_START;
+static uint16_t drops_reported;
+static struct timer report_timer;
+/*---------------------------------------------------------------------------*/
+static uint16_t
+debug_free(void)
+{
+  return SLIP_DEBUG_BUFSIZE - 1 -
+    (debug_put + SLIP_DEBUG_BUFSIZE - debug_get) % SLIP_DEBUG_BUFSIZE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+debug_buf_put(char c)
+{
+  debug_buf[debug_put] = c;
+  debug_put = (debug_put + 1) % SLIP_DEBUG_BUFSIZE;
+}
+/*---------------------------------------------------------------------------*/
+static int
+take_token(uint8_t level)
+{
+  struct token_bucket *b = &buckets[level];
+  uint32_t max = (uint32_t)bursts[level] * CLOCK_SECOND;
+  clock_time_t elapsed;
+
+  if(rates[level] == 0) {
+    return 1;
+  }
+  if(!b->started) {
+    b->started = 1;
+    b->tokens = max;
+    b->last = clock_time();
+  }
+  elapsed = clock_time() - b->last;
+  b->last += elapsed;
+  if(elapsed > max) {
+    elapsed = max; //full again, and no overflow below
+  }
+  b->tokens += (uint32_t)elapsed * rates[level];
+  if(b->tokens > max) {
+    b->tokens = max;
+  }
+  if(b->tokens < CLOCK_SECOND) {
+    return 0;
+  }
+  b->tokens -= CLOCK_SECOND;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+slip_debug_set_level(uint8_t level)
+{
+  if(level < SLIP_DEBUG_LEVELS) {
+    line_level = level;
+  }
+}
+/*---------------------------------------------------------------------------*/
+const struct slip_debug_stats *
+slip_debug_get_stats(void)
+{
+  return &debug_stats;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+drops_total(void)
+{
+  uint16_t total = 0;
+  int i;
+
+  for(i = 0; i < SLIP_DEBUG_LEVELS; i++) {
+    total += debug_stats.rate_drops[i] + debug_stats.full_drops[i];
+  }
+  return total;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_debug_frame(const char *line, uint16_t len)
+{
+  slip_arch_writeb(SLIP_END);
+  slip_arch_writeb('\r');       /* Type debug line == '\r' */
+  while(len-- > 0) {
+    slip_arch_writeb(*line++);
+  }
+  slip_arch_writeb(SLIP_END);
+}
+/*---------------------------------------------------------------------------*/
+/* Send the oldest complete line, newline included */
+static void
+send_debug_line(void)
+{
+  char c;
+
+  slip_arch_writeb(SLIP_END);
+  slip_arch_writeb('\r');
+  do {
+    c = debug_buf[debug_get];
+    debug_get = (debug_get + 1) % SLIP_DEBUG_BUFSIZE;
+    slip_arch_writeb(c);
+  } while(c != '\n');
+  slip_arch_writeb(SLIP_END);
+  lines_ready--;
+  debug_stats.lines++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+report_drops(void)
+{
+  char line[80];
+  int len;
+
+  if(drops_total() == drops_reported || !timer_expired(&report_timer)) {
+    return;
+  }
+  drops_reported = drops_total();
+  timer_set(&report_timer, SLIP_DEBUG_REPORT_INTERVAL);
+  len = snprintf(line, sizeof(line),
+                 "slip-debug: dropped rate %u/%u/%u full %u/%u/%u (err/info/trace)\n",
+                 debug_stats.rate_drops[SLIP_DEBUG_ERROR], debug_stats.rate_drops[SLIP_DEBUG_INFO],
+                 debug_stats.rate_drops[SLIP_DEBUG_TRACE], debug_stats.full_drops[SLIP_DEBUG_ERROR],
+                 debug_stats.full_drops[SLIP_DEBUG_INFO], debug_stats.full_drops[SLIP_DEBUG_TRACE]);
+  send_debug_frame(line, len < (int)sizeof(line) ? len : sizeof(line) - 1);
+}
+/*---------------------------------------------------------------------------*/
+/* slip_send() writes a whole packet before returning, so the UART is free
+ * whenever this runs; PROCESS_PAUSE() lets queued packets go first between
+ * two lines.
+ */
+PROCESS_THREAD(slip_debug_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  timer_set(&report_timer, 0);
+  while(1) {
+    PROCESS_WAIT_UNTIL(lines_ready > 0);
+    send_debug_line();
+    if(lines_ready == 0) {
+      report_drops();
+    }
+    PROCESS_PAUSE();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
 #undef putchar
 int
 putchar(int c)
 {
-#define SLIP_END     0300
-  static char debug_frame = 0;
-
-  if(!debug_frame) {            /* Start of debug output */
-    slip_arch_writeb(SLIP_END);
-    slip_arch_writeb('\r');     /* Type debug line == '\r' */
-    debug_frame = 1;
+  if(line_state == LINE_START) {
+    if(!take_token(line_level)) {
+      debug_stats.rate_drops[line_level]++;
+      line_state = LINE_DROP;
+    } else if(debug_free() < 2) {
+      debug_stats.full_drops[line_level]++;
+      line_state = LINE_DROP;
+    } else {
+      line_state = LINE_KEEP;
+    }
   }
 
-  /* Need to also print '\n' because for example COOJA will not show
-     any output before line end */
-  slip_arch_writeb((char)c);
+  if(line_state == LINE_KEEP) {
+    if(c != '\n' && debug_free() < 2) {
+      /* cut the line short, the last free slot takes its newline */
+      debug_stats.full_drops[line_level]++;
+      debug_buf_put('\n');
+      lines_ready++;
+      line_state = LINE_DROP;
+    } else {
+      debug_buf_put((char)c);
+    }
+  }
 
   /*
    * Line buffered output, a newline marks the end of debug output and
-   * implicitly flushes debug output.
+   * wakes up the sender.
    */
   if(c == '\n') {
-    slip_arch_writeb(SLIP_END);
-    debug_frame = 0;
+    if(line_state == LINE_KEEP) {
+      lines_ready++;
+    }
+    process_poll(&slip_debug_process);
+    line_state = LINE_START;
+    line_level = SLIP_DEBUG_TRACE;
   }
   return c;
 }
-#endif
+#else /* !SLIP_BRIDGE_CONF_NO_PUTCHAR */
+void
+slip_debug_set_level(uint8_t level)
+{
+}
+/*---------------------------------------------------------------------------*/
+const struct slip_debug_stats *
+slip_debug_get_stats(void)
+{
+  static const struct slip_debug_stats none;
+
+  return &none;
+}
+#endif /* !SLIP_BRIDGE_CONF_NO_PUTCHAR */
 /*---------------------------------------------------------------------------*/
 const struct uip_fallback_interface rpl_interface = {
   init, output
@@ -0,0 +1,58 @@
+#ifndef SLIP_DEBUG_H_
+#define SLIP_DEBUG_H_
+/*---------------------------------------------------------------------------*/
+/* Debug output of the border router. putchar() (slip-bridge.c) only stores
+ * it in a ring buffer; complete lines are sent one SLIP frame at a time
+ * between IP packets. Every line has a level with its own rate limit, lines
+ * over the limit or that do not fit in the buffer are dropped and counted.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+/*---------------------------------------------------------------------------*/
+#define SLIP_DEBUG_ERROR             0
+#define SLIP_DEBUG_INFO              1
+#define SLIP_DEBUG_TRACE             2 /* lines printed without a level */
+#define SLIP_DEBUG_LEVELS            3
+/*---------------------------------------------------------------------------*/
+#ifdef SLIP_DEBUG_CONF_BUFSIZE
+#define SLIP_DEBUG_BUFSIZE SLIP_DEBUG_CONF_BUFSIZE
+#else
+#define SLIP_DEBUG_BUFSIZE 512
+#endif
+/* Lines per second and burst of each level, a rate of 0 is not limited */
+#ifdef SLIP_DEBUG_CONF_RATES
+#define SLIP_DEBUG_RATES SLIP_DEBUG_CONF_RATES
+#else
+#define SLIP_DEBUG_RATES { 0, 4, 2 }
+#endif
+#ifdef SLIP_DEBUG_CONF_BURSTS
+#define SLIP_DEBUG_BURSTS SLIP_DEBUG_CONF_BURSTS
+#else
+#define SLIP_DEBUG_BURSTS { 0, 16, 8 }
+#endif
+/* Least time between two "dropped lines" reports on the debug channel */
+#ifdef SLIP_DEBUG_CONF_REPORT_INTERVAL
+#define SLIP_DEBUG_REPORT_INTERVAL SLIP_DEBUG_CONF_REPORT_INTERVAL
+#else
+#define SLIP_DEBUG_REPORT_INTERVAL (10 * CLOCK_SECOND)
+#endif
+/*---------------------------------------------------------------------------*/
+struct slip_debug_stats {
+  uint16_t rate_drops[SLIP_DEBUG_LEVELS];   /* lines over the rate limit */
+  uint16_t full_drops[SLIP_DEBUG_LEVELS];   /* lines cut short, buffer full */
+  uint16_t lines;                           /* lines sent */
+};
+/*---------------------------------------------------------------------------*/
+/* Level of the line being printed, back to SLIP_DEBUG_TRACE after '\n' */
+void slip_debug_set_level(uint8_t level);
+const struct slip_debug_stats *slip_debug_get_stats(void);
+/*---------------------------------------------------------------------------*/
+/* PRINTF with a level, follows DEBUG of the including file (uip-debug.h) */
+#define SLIP_DEBUG_PRINTF(level, ...) do {                              \
+    if((DEBUG) & DEBUG_PRINT) {                                         \
+      slip_debug_set_level(level);                                      \
+      printf(__VA_ARGS__);                                              \
+    }                                                                   \
+  } while(0)
+/*---------------------------------------------------------------------------*/
+#endif /* SLIP_DEBUG_H_ */
@@ -1,11 +1,13 @@
+#ifndef APC_REQUEST_H_
+#define APC_REQUEST_H_
 //these are the types of data that can be communicated between sensor nodes and the sink node
 enum
 {
   //request/reply headers
-  NBR_ADV, //neighbor advertise
+  NBR_ADV, //neighbor advertise, sent on a Trickle timer
   DATA_REQUEST,
-  DATA_ACK, //acknowledge - data received
-  DATA_NACK, //not acknowledge - data not received
+  DATA_ACK, //acknowledge - data received, data[0] is the seq of the readings
+  DATA_NACK, //not acknowledge - data not received, data[0] is the seq of the readings
   
   //error headers
   SENSOR_FAILED, //failed to read sensor values
@@ -19,7 +21,18 @@ enum
   CO2_T, //unitless (ratio in milli scale), compute to ppm at processing server
   O3_T, //unitless (ratio in milli scale), compute to ppm at processing server
   WIND_SPEED_T, //unit in m/s
-  WIND_DRCTN_T //may be N, S, E, W and their combinations
+  WIND_DRCTN_T, //may be N, S, E, W and their combinations
+
+  //packed readings header (struct readings_message)
+  DATA_READINGS,
+
+  //reply slot of a sensor node in collection rounds, sent by the sink
+  SLOT_ASSIGN,
+
+  //multi-hop collection: flooded request (struct tree_request) and the
+  //readings of a subtree (struct aggregate_message)
+  TREE_REQUEST,
+  DATA_AGGREGATE
 };
 
 struct req_message {
@@ -30,4 +43,140 @@ struct req_message {
 struct sensor_reading {
   uint8_t type;
   char data[8];
-};
\ No newline at end of file
+};
+
+//sensor node advertisements (NBR_ADV): Imin in clock ticks, Imax as
+//doublings of Imin (4 s to about 17 min) and the redundancy constant, the
+//DATA_ACK and SLOT_ASSIGN frames a node must hear in an interval to skip it
+#define NBR_ADV_IMIN (4 * CLOCK_SECOND)
+#define NBR_ADV_IMAX 8
+#define NBR_ADV_REDUNDANCY 1
+
+//most nodes a DATA_REQUEST can re-poll
+#define DATA_REQUEST_MAX_NODES 32
+
+//slots after the assigned ones for nodes the sink has not assigned a slot yet
+#define DATA_REQUEST_SPARE_SLOTS 4
+
+//time sensor nodes have to read their sensors after a request, before the
+//first slot (ms)
+#define ROUND_GUARD 200
+
+//starts (or re-polls) a data collection round, broadcast by the sink
+//each polled node replies once, in its own slot of slotLength ms, counted
+//ROUND_GUARD ms after it heard the request: its SLOT_ASSIGN slot if count is
+//0, else its position in nodes
+struct data_request {
+  uint8_t type; //DATA_REQUEST
+  uint8_t round; //round id, never 0
+  uint16_t slotLength; //unit in ms
+  uint8_t slots; //assigned slots, followed by DATA_REQUEST_SPARE_SLOTS
+  uint8_t count; //nodes re-polled, 0 polls every node
+  uint8_t epoch; //picked by the sink at boot, never 0; a new one means it restarted
+  linkaddr_t nodes[DATA_REQUEST_MAX_NODES]; //only count are sent
+}; //fields are naturally aligned, no padding
+
+//size of a data_request re-polling count nodes
+#define DATA_REQUEST_SIZE(count) \
+  (sizeof(struct data_request) - (DATA_REQUEST_MAX_NODES - (count)) * sizeof(linkaddr_t))
+
+//times a sensor node sends its readings again when the sink does not
+//acknowledge them, within its reply slot
+#define DATA_MAX_RETRANSMISSIONS 2
+
+//bit of a sensor type in the valid field of struct readings_message
+#define READING_VALID(type) (1 << ((type) - TEMPERATURE_T))
+
+//wind direction bits, combined for NE, NW, SE and SW
+#define WIND_DRCTN_N 0x01
+#define WIND_DRCTN_E 0x02
+#define WIND_DRCTN_S 0x04
+#define WIND_DRCTN_W 0x08
+
+//all readings of a sensor node in one frame, the reply to DATA_REQUEST
+//a field is only meaningful if its READING_VALID bit is set in valid
+struct readings_message {
+  uint8_t type; //DATA_READINGS
+  uint8_t round; //round of the DATA_REQUEST answered
+  uint8_t seq; //sequence number of the readings, kept in retransmissions, never 0
+  uint8_t attempt; //0 for the first transmission in a poll, then 1 per retransmission
+  uint8_t valid;
+  int16_t temperature; //unit in 0.1 Deg. Celsius
+  uint16_t humidity; //unit in 0.1 %RH
+  uint16_t PM25; //unit in ug/m3
+  uint32_t CO; //Rs/Ro x 1000
+  uint32_t CO2; //Rs/Ro x 1000
+  uint32_t O3; //Rs/Ro x 1000
+  uint16_t windSpeed; //unit in 0.01 m/s
+  uint8_t windDir; //WIND_DRCTN_* bits
+} __attribute__((packed));
+
+//multi-hop collection (make MAKE_WITH_MULTIHOP=1, for the sink and every
+//node): the sink floods a TREE_REQUEST instead of the DATA_REQUEST, each node
+//takes the first node it hears it from as its parent, and the readings travel
+//up the tree, packed by every relay into DATA_AGGREGATE frames
+#ifdef APC_RIME_CONF_MULTIHOP
+#define APC_RIME_MULTIHOP APC_RIME_CONF_MULTIHOP
+#else
+#define APC_RIME_MULTIHOP 0
+#endif
+
+//longest random delay before a node forwards the TREE_REQUEST (ms)
+#define TREE_FORWARD_JITTER 20
+
+//frames a node sends its parent in a round, of AGGREGATE_MAX_ENTRIES
+//readings each; a relay drops the readings that do not fit, bounding its airtime
+#define AGGREGATE_MAX_FRAMES 2
+
+//room the lower layers take in a frame: the 802.15.4 header with short
+//addresses and a compressed PAN ID (9 bytes) and the Rime unicast header
+//(channel, receiver and sender, 6 bytes), with a margin
+#define APC_FRAME_HEADER_ROOM 20
+
+//longest payload of a frame: the headers share the packet buffer, and the
+//radio sends at most 127 bytes including the 2 byte FCS
+#define APC_FRAME_MAX_PAYLOAD \
+  ((PACKETBUF_SIZE < 127 - 2 ? PACKETBUF_SIZE : 127 - 2) - APC_FRAME_HEADER_ROOM)
+
+//starts a multi-hop collection round, flooded from the sink
+//a node at depth d sends upstream in phase maxDepth - d; phases are
+//phaseLength ms long and start floodGuard ms after the sink sent the request,
+//so the deepest nodes send first and every relay has its children's readings
+struct tree_request {
+  uint8_t type; //TREE_REQUEST
+  uint8_t round; //round id, never 0
+  uint8_t depth; //hops of the sender from the sink, 0 for the sink
+  uint8_t maxDepth; //deepest node that takes part, in hops
+  uint16_t phaseLength; //unit in ms
+  uint16_t floodGuard; //unit in ms
+  uint16_t elapsed; //ms since the sink sent the request, when the sender sent it
+}; //fields are naturally aligned, no padding
+
+//readings of one node in a DATA_AGGREGATE frame
+struct aggregate_entry {
+  linkaddr_t origin; //node that took the readings
+  uint8_t hops; //its depth in the tree
+  struct readings_message readings;
+} __attribute__((packed));
+
+//readings in one DATA_AGGREGATE frame, as many as fit after its 3 byte header
+//(3 with the default packet buffer: 3 + 3 x 29 = 90 bytes)
+#define AGGREGATE_MAX_ENTRIES ((APC_FRAME_MAX_PAYLOAD - 3) / sizeof(struct aggregate_entry))
+
+//readings of a subtree, sent by each node to its parent
+struct aggregate_message {
+  uint8_t type; //DATA_AGGREGATE
+  uint8_t round;
+  uint8_t count;
+  struct aggregate_entry entries[AGGREGATE_MAX_ENTRIES]; //only count are sent
+} __attribute__((packed));
+
+//size of an aggregate_message with count entries
+#define AGGREGATE_SIZE(count) \
+  (sizeof(struct aggregate_message) - (AGGREGATE_MAX_ENTRIES - (count)) * sizeof(struct aggregate_entry))
+
+//a full DATA_AGGREGATE must fit in one frame, or the header allocation fails
+//and the frame is lost
+typedef char aggregate_message_fits_frame[
+  AGGREGATE_MAX_ENTRIES >= 1 && sizeof(struct aggregate_message) <= APC_FRAME_MAX_PAYLOAD ? 1 : -1];
+#endif /* APC_REQUEST_H_ */
@@ -1,47 +1,122 @@
 #include "contiki.h"
-#include "dev/adc-zoul.h"
+#include "sys/rtimer.h"
+#if CONTIKI_TARGET_COOJA || CONTIKI_TARGET_NATIVE
+#include "sim-sensors.h"
+#else
 #include "dev/dht22.h"
 #include "dev/air-quality-sensor.h"
 #include "dev/anemometer-sensor.h"
 #include "dev/pm25-sensor.h"
-#include "../apc-request.h"
+#include "dev/adc128s022.h"
+#endif
 
-//define the number of sensors for this node (each data value is categorized as a sensor)
-#define SENSOR_COUNT 8
+//calls timed for each driver (make BENCH_ITERATIONS=<n>)
+#ifdef BENCH_CONF_ITERATIONS
+#define BENCH_ITERATIONS BENCH_CONF_ITERATIONS
+#else
+#define BENCH_ITERATIONS 100
+#endif
 
-//interval for sampling (in sec)
-#define SAMPLING_PERIOD 60
+//wait before the first call, the gas sensors report AQS_INITIALIZING before (sec)
+#if CONTIKI_TARGET_COOJA || CONTIKI_TARGET_NATIVE
+#define BENCH_START_DELAY (SIM_SENSORS_PREHEAT_SECONDS + 1)
+#else
+#define BENCH_START_DELAY 5
+#endif
 
 #define WAIT_BUSY_PERIOD 30
 
+//the DHT22 answers at most every 2 seconds
+#define BENCH_DHT22_INTERVAL (2 * CLOCK_SECOND)
+
+//external ADC channels of the sensors (project-conf.h), read one by one and
+//in one burst; only timed when the sensors are read through it (make
+//EXTERNAL_ADC=1), its CSN is otherwise the DHT22 pin. The simulated ADC has
+//no pins.
+#if ADC_SENSORS_CONF_USE_EXTERNAL_ADC || CONTIKI_TARGET_COOJA || CONTIKI_TARGET_NATIVE
+#define BENCH_EXTERNAL_ADC 1
+#else
+#define BENCH_EXTERNAL_ADC 0
+#endif
+#define BENCH_ADC_CHANNELS 6
+
 //return codes
 #define OPERATION_FAILED 0x00
 #define OPERATION_SUCCESS 0x01
 
-//function that reads from the specified sensor
-//returns nonzero if successful, zero otherwise
+//one timed driver call
+struct bench {
+  const char *name;
+  //returns OPERATION_SUCCESS if the driver returned a reading
+  int (*call)(void);
+  //calls timed together when one is shorter than an rtimer tick
+  uint8_t batch;
+  //wait between samples, 0 to only yield
+  clock_time_t interval;
+};
+
+//functions that call the driver once
 static int
-read_sensor
-(uint8_t sensorType, uint8_t nodeNumber);
+bench_dht22
+(void);
 
-//struct containing the sensor readings for this node
-struct sensor_node_readings {
-  struct sensor_reading sensor_node_reading[SENSOR_COUNT];
-};
+static int
+bench_pm25
+(void);
+
+static int
+bench_mq7
+(void);
+
+static int
+bench_mq131
+(void);
+
+static int
+bench_mq135
+(void);
+
+static int
+bench_wind_speed
+(void);
 
-static struct sensor_node_readings
-sn_readings;
+static int
+bench_wind_dir
+(void);
+
+#if BENCH_EXTERNAL_ADC
+static int
+bench_adc_single
+(void);
 
-static const uint8_t 
-SENSOR_TYPES[SENSOR_COUNT] =
+static int
+bench_adc_burst
+(void);
+#endif
+
+//function that prints the statistics of the samples of a benchmark
+static void
+report
+(const struct bench *b, uint16_t ok);
+
+static const struct bench
+BENCHES[] =
 {
-  TEMPERATURE_T, //unit in Deg. Celsius
-  HUMIDITY_T, //unit in %RH
-  PM25_T, //unit in ppm, compute to microgram per m3 at processing server
-  CO_T, //unitless (ratio in milli scale), compute to ppm at processing server
-  /*NO2_T, //unit in ppm, unused */
-  CO2_T, //unitless (ratio in milli scale), compute to ppm at processing server
-  O3_T, //unitless (ratio in milli scale), compute to ppm at processing server
-  WIND_SPEED_T, //unit in mm/s, compute to m/s at processing server
-  WIND_DRCTN_T //may be N, S, E, W and their combinations
+  { "dht22.value", bench_dht22, 1, BENCH_DHT22_INTERVAL },
+  { "pm25.value", bench_pm25, 1, 0 },
+  { "aqs_value.MQ7", bench_mq7, 1, 0 },
+  { "aqs_value.MQ131", bench_mq131, 1, 0 },
+  { "aqs_value.MQ135", bench_mq135, 1, 0 },
+  { "anem_sensor.value.speed", bench_wind_speed, 1, 0 },
+  { "anem_sensor.value.dir", bench_wind_dir, 1, 0 },
+#if BENCH_EXTERNAL_ADC
+  { "adc128s022.value.x6", bench_adc_single, 8, 0 },
+  { "adc128s022_read_burst.x6", bench_adc_burst, 8, 0 }
+#endif
 };
+
+#define BENCH_COUNT (sizeof(BENCHES) / sizeof(BENCHES[0]))
+
+//time of each sample in rtimer ticks, for the current benchmark
+static rtimer_clock_t
+samples[BENCH_ITERATIONS];
@@ -1,6 +1,24 @@
 #ifndef PROJECT_CONF_H_
 #define PROJECT_CONF_H_
 
+//read the analog sensors through the external ADC (ADC128S022), so the
+//benchmark also times the ADC on its own (make EXTERNAL_ADC=1); the on-chip
+//ADC pins below by default, as the sensors are wired on the Rime node
+#ifdef BENCH_CONF_EXTERNAL_ADC
+#define ADC_SENSORS_CONF_USE_EXTERNAL_ADC   BENCH_CONF_EXTERNAL_ADC
+#else
+#define ADC_SENSORS_CONF_USE_EXTERNAL_ADC   0
+#endif
+
+//ADC128S022 channels of the analog sensors (apc-sensor-node-test.c reads 0 to 5)
+#define MQ7_SENSOR_CONF_EXT_ADC_CHANNEL          0
+#define MQ135_SENSOR_CONF_EXT_ADC_CHANNEL        1
+#define MQ131_SENSOR_CONF_EXT_ADC_CHANNEL        2
+#define WIND_SPEED_SENSOR_CONF_EXT_ADC_CHANNEL   3
+#define WIND_DIR_SENSOR_CONF_EXT_ADC_CHANNEL     4
+#define PM25_SENSOR_OUT_CONF_EXT_ADC_CHANNEL     5
+
+#if !ADC_SENSORS_CONF_USE_EXTERNAL_ADC
 //enable the disabled ADC channels (ADC1 and ADC3 are enabled by default)
 //(refer to board layout for pin configuration)
 #define ADC_SENSORS_CONF_ADC2_PIN       4
@@ -10,13 +28,23 @@
 //disable the user button, enable ADC6 (the two are mutually exclusive)
 #define ADC_SENSORS_CONF_ADC6_PIN       3
 #define ADC_SENSORS_CONF_MAX            6
+#endif
 
 /* apc-sensor-node config */
+#if ADC_SENSORS_CONF_USE_EXTERNAL_ADC
+/* DHT22 (Temperature/Humidity)
+	A7 (ANALOG_IN/GPIO), as on the IPv6 node: D1 is the ADC128S022 CSN
+	(adc128s022.h) and the on-chip ADC pins are free
+*/
+#define DHT22_CONF_PIN                  7
+#define DHT22_CONF_PORT                 GPIO_A_NUM
+#else
 /* DHT22 (Temperature/Humidity)
 	D1 (Digital Input/Output) 
 */
 #define DHT22_CONF_PIN                  1
 #define DHT22_CONF_PORT                 GPIO_D_NUM
+#endif
 
 /* 
    GP2Y1014AUOF -> A5 (ADC Input) (ADC1)
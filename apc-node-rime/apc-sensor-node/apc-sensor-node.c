@@ -5,8 +5,10 @@
 #include <string.h>
 #include "dev/leds.h"
 #include "apc-sensor-node.h"
+#if !CONTIKI_TARGET_COOJA
 #include "dev/air-quality-sensor.h"
 #include "dev/anemometer-sensor.h"
+#endif
 //Include files end
 
 //debugging purposes
@@ -21,14 +23,13 @@
 
 static int
 read_sensor
-(uint8_t sensorType, uint8_t nodeNumber) {
+(uint8_t sensorType) {
 
 	int value1, value2;
 
 	switch(sensorType){
 		//HUMIDITY_T and TEMPERATURE_T are read at the same sensor
 	case HUMIDITY_T:
-		nodeNumber--; // humidity is one index above temperature in sensor reading
 	case TEMPERATURE_T:
 		//Assume it is busy
 		do{
@@ -37,14 +38,8 @@ read_sensor
 			PRINTF("Sensor is busy, retrying...\n");
 		} while (value1 == DHT22_BUSY);
 		if (dht22_read_all(&value1, &value2) != DHT22_ERROR) {
-			sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-			"%02d.%02d", 
-			value1 / 10, value2 % 10
-			);
-			sprintf(sn_readings.sensor_node_reading[nodeNumber + 1].data, 
-			"%02d.%02d", 
-			value2 / 10, value2 % 10
-			);
+			sn_readings.temperature = value1;
+			sn_readings.humidity = value2;
 			PRINTF("-----------------\n");
 			PRINTF("read_sensor: TEMPERATURE_T OR HUMIDITY_T \n");
 			PRINTF("Temperature %02d.%02d deg. C, ", value1 / 10, value1 % 10);
@@ -71,10 +66,7 @@ read_sensor
 			return OPERATION_FAILED;
 		}
 		else {
-			sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-			"%02d", 
-			value1
-			);
+			sn_readings.PM25 = value1;
 			PRINTF("-----------------\n");
 			PRINTF("read_sensor: PM25_T \n");
 			PRINTF("Dust Density: %d ug/m3\n", value1);
@@ -99,11 +91,7 @@ read_sensor
 			return OPERATION_FAILED;
 		}
 		else {
-			sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-			"%02d.%03d", 
-			value1 / 1000,
-			value1 % 1000
-			);
+			sn_readings.CO = value1;
 			PRINTF("-----------------\n");
 			PRINTF("read_sensor: CO_T \n");
 			PRINTF("Rs/Ro: %02d.%03d\n",
@@ -130,11 +118,7 @@ read_sensor
 			return OPERATION_FAILED;
 		}
 		else {
-			sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-			"%02d.%03d", 
-			value1 / 1000,
-			value1 % 1000
-			);
+			sn_readings.CO2 = value1;
 			PRINTF("-----------------\n");
 			PRINTF("read_sensor: CO2_T \n");
 			PRINTF("Rs/Ro: %02d.%03d\n", 
@@ -161,11 +145,7 @@ read_sensor
 			return OPERATION_FAILED;
 		}
 		else {
-			sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-			"%02d.%03d", 
-			value1 / 1000,
-			value1 % 1000
-			);
+			sn_readings.O3 = value1;
 			PRINTF("-----------------\n");
 			PRINTF("read_sensor: O3_T \n");
 			PRINTF("Rs/Ro: %02d.%03d\n", 
@@ -185,11 +165,7 @@ read_sensor
 			return OPERATION_FAILED;
 		}
 		else {
-			sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-			"%02d.%02d",
-			value1 / 100,
-			value1 % 100
-			);
+			sn_readings.windSpeed = value1;
 			PRINTF("-----------------\n");
 			PRINTF("read_sensor: WIND_SPEED_T \n");
 			PRINTF("WIND SPEED: %02d.%02d m/s\n", 
@@ -216,47 +192,40 @@ read_sensor
 			switch (value1){
 				case WIND_DIR_NORTH:
 					PRINTF("WIND DRCTN (Actual): NORTH\n");
-					sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-						"N");
+					sn_readings.windDir = WIND_DRCTN_N;
 					break;
 				case WIND_DIR_EAST:
 					PRINTF("WIND DRCTN (Actual): EAST\n");
-					sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-						"E");
+					sn_readings.windDir = WIND_DRCTN_E;
 					break;
 				case WIND_DIR_SOUTH:
 					PRINTF("WIND DRCTN (Actual): SOUTH\n");
-					sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-						"S");
+					sn_readings.windDir = WIND_DRCTN_S;
 					break;
 				case WIND_DIR_WEST:
 					PRINTF("WIND DRCTN (Actual): WEST\n");
-					sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-						"W");
+					sn_readings.windDir = WIND_DRCTN_W;
 					break;
 				case WIND_DIR_NORTH | WIND_DIR_EAST:
 					PRINTF("WIND DRCTN (Actual): NORTHEAST\n");
-					sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-						"NE");
+					sn_readings.windDir = WIND_DRCTN_N | WIND_DRCTN_E;
 					break;
 				case WIND_DIR_NORTH | WIND_DIR_WEST:
 					PRINTF("WIND DRCTN (Actual): NORTHWEST\n");
-					sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-						"NW");
+					sn_readings.windDir = WIND_DRCTN_N | WIND_DRCTN_W;
 					break;
 				case WIND_DIR_SOUTH | WIND_DIR_EAST:
 					PRINTF("WIND DRCTN (Actual): SOUTHEAST\n");
-					sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-						"SE");
+					sn_readings.windDir = WIND_DRCTN_S | WIND_DRCTN_E;
 					break;
 				case WIND_DIR_SOUTH | WIND_DIR_WEST:
 					PRINTF("WIND DRCTN (Actual): SOUTHWEST\n");
-					sprintf(sn_readings.sensor_node_reading[nodeNumber].data, 
-						"SW");
+					sn_readings.windDir = WIND_DRCTN_S | WIND_DRCTN_W;
 					break;
 				default:
 					PRINTF("ERROR: Unexpected value.");
-					break;
+					PRINTF("-----------------\n");
+					return OPERATION_FAILED;
 			}
 			PRINTF("-----------------\n");
 			return OPERATION_SUCCESS;
@@ -267,68 +236,181 @@ read_sensor
 	}
 }
 
+static void
+send_nbr_adv
+(void *ptr, uint8_t suppress)
+{
+	static struct req_message msg;
+
+	//the sink has acknowledged this node in the interval, it knows it
+	if (suppress == TRICKLE_TIMER_TX_SUPPRESS) {
+		PRINTF("ADVERTISE - suppressed, the sink knows this node\n");
+		return;
+	}
+	msg.type = NBR_ADV;
+	packetbuf_copyfrom(&msg, sizeof( struct req_message ));
+
+	unicast_send(&uc, &sinkAddr);
+	PRINTF("ADVERTISE - header type %d and value %s - sent to server address %d.%d\n", 
+	msg.type, msg.data,
+	sinkAddr.u8[0], sinkAddr.u8[1]
+	);
+}
+
+static void
+check_epoch
+(uint8_t epoch)
+{
+	if (epoch == sinkEpoch) {
+		return;
+	}
+	//the slot belonged to the sink before its restart
+	if (sinkEpoch != 0) {
+		PRINTF("--sink restarted (epoch %d, was %d), advertising again\n", epoch, sinkEpoch);
+		assignedSlot = NO_SLOT;
+		//its round ids start over, the readings of a round with the same id
+		//are not the ones it asks for
+		sn_readings.round = 0;
+		acked = 0;
+		ctimer_stop(&reply_timer);
+	}
+	sinkEpoch = epoch;
+	//back to the shortest interval
+	trickle_timer_reset_event(&adv_timer);
+}
+
+static void
+take_readings
+(uint8_t round)
+{
+	int i;
+
+	//failed sensors are left out of the valid bitmap
+	if (round == sn_readings.round) {
+		return;
+	}
+	sn_readings.type = DATA_READINGS;
+	sn_readings.round = round;
+	seq = seq == 0xFF ? 1 : seq + 1;
+	sn_readings.seq = seq;
+	acked = 0;
+	sn_readings.valid = 0;
+	for (i = 0; i < SENSOR_COUNT; i++) {
+		//humidity is read together with the temperature
+		if (SENSOR_TYPES[i] == HUMIDITY_T)
+			continue;
+
+		if (!read_sensor(SENSOR_TYPES[i])) {
+			PRINTF("SENSOR_FAIL - faulting sensor type: %d\n", SENSOR_TYPES[i]);
+			continue;
+		}
+		sn_readings.valid |= READING_VALID(SENSOR_TYPES[i]);
+		if (SENSOR_TYPES[i] == TEMPERATURE_T)
+			sn_readings.valid |= READING_VALID(HUMIDITY_T);
+	}
+}
+
+static void
+send_readings
+(void *ptr)
+{
+	int bytesCopied;
+
+	bytesCopied = packetbuf_copyfrom(&sn_readings, sizeof( struct readings_message ));
+	PRINTF("%d bytes copied to packet buffer\n", bytesCopied);
+
+	unicast_send(&uc, &sinkAddr);
+	PRINTF("DATA_READINGS - round %d, seq %d, attempt %d and valid 0x%02x - sent to server address %d.%d\n", 
+	sn_readings.round, sn_readings.seq, sn_readings.attempt, sn_readings.valid,
+	sinkAddr.u8[0], sinkAddr.u8[1]
+	);
+
+	//send again if no DATA_ACK arrives in time, the last try is left unanswered
+	if (sn_readings.attempt < DATA_MAX_RETRANSMISSIONS) {
+		sn_readings.attempt++;
+		ctimer_set(&reply_timer, ackTimeout, send_readings, NULL);
+	}
+}
+
 static void
 recv_bc
 (struct broadcast_conn *c, const linkaddr_t *from)
 {
-	static struct req_message *msg;
-	static struct req_message reply;
+	static struct data_request req;
 	static int i;
+	uint8_t slot;
+	clock_time_t heard, slotStart, elapsed;
 
+	//the reply slot is counted from here, the readings below take part of it
+	heard = clock_time();
 	PRINTF("broadcast message received from %d.%d\n",
 	from->u8[0], from->u8[1]);
+#if APC_RIME_MULTIHOP
+	//the request comes from the sink or from any node closer to it
+	if (((struct req_message *)packetbuf_dataptr())->type == TREE_REQUEST) {
+		recv_tree_request(from);
+	}
+	return;
+#endif
 	leds_toggle(LEDS_GREEN);
 	//verify that broadcast is from server
 	if (linkaddr_cmp(from, &sinkAddr)) {
 		PRINTF("--server match\n");
 		//restructure that packet data
-		msg = packetbuf_dataptr();
+		memset(&req, 0, sizeof(req));
+		memcpy(&req, packetbuf_dataptr(),
+			MIN(packetbuf_datalen(), sizeof(struct data_request)));
 
 		//verify that it is requesting data
-		if (msg->type == DATA_REQUEST) {
-			PRINTF("--DATA_REQUEST verified, proceeding to sensor reading\n");
-			//read data now
-			for (i = 0; i < SENSOR_COUNT; i++) {
-				int bytesCopied;
-
-				if (!read_sensor(sn_readings.sensor_node_reading[i].type, i)) {
-					//failed to read sensor
-					reply.type = SENSOR_FAILED;
-
-					//convert uint8_t to char array (base 10 formatting)
-					itoa(sn_readings.sensor_node_reading[i].type,
-					reply.data,
-					10
-					);
-
-					bytesCopied = packetbuf_copyfrom(&reply, sizeof( struct req_message ));
-					PRINTF("%d bytes copied to packet buffer\n", bytesCopied);
-
-					//get the data packet again for debugging purposes
-					msg = packetbuf_dataptr();
-
-					unicast_send(&uc, &sinkAddr);
-					PRINTF("SENSOR_FAIL - faulting sensor type: %s\n", msg->data);
-					PRINTF("SENSOR_FAIL - header type %d and value %s - sent to server address %d.%d\n", 
-					msg->type, msg->data,
-					sinkAddr.u8[0], sinkAddr.u8[1]
-					);
-				}        
-				else {
-					//successfully read sensor
-					bytesCopied = packetbuf_copyfrom(&sn_readings.sensor_node_reading[i], sizeof( struct sensor_reading ));
-
-					msg = packetbuf_dataptr();
-
-					PRINTF("%d bytes copied to packet buffer\n", bytesCopied);
-
-					unicast_send(&uc, &sinkAddr);
-					PRINTF("SENSOR_READ - header type %d and value %s - sent to server address %d.%d\n", 
-					msg->type, msg->data,
-					sinkAddr.u8[0], sinkAddr.u8[1]
-					);
+		if (req.type == DATA_REQUEST && req.count <= DATA_REQUEST_MAX_NODES) {
+			PRINTF("--DATA_REQUEST verified (round %d, %d nodes re-polled, epoch %d)\n",
+			req.round, req.count, req.epoch);
+			check_epoch(req.epoch);
+
+			//pick the reply slot: position in a re-poll, else assigned or from the address
+			if (req.count > 0) {
+				for (i = 0; i < req.count && !linkaddr_cmp(&req.nodes[i], &linkaddr_node_addr); i++);
+				if (i == req.count) {
+					PRINTF("--not re-polled, ignored\n");
+					leds_toggle(LEDS_GREEN);
+					return;
 				}
+				slot = i;
+			}
+			else if (assignedSlot != NO_SLOT) {
+				slot = assignedSlot;
+			}
+			else {
+				slot = req.slots +
+					(linkaddr_node_addr.u8[0] ^ linkaddr_node_addr.u8[1]) % DATA_REQUEST_SPARE_SLOTS;
+			}
+
+			//read data now, once per round
+			take_readings(req.round);
+
+			//the sink already has them, its DATA_REQUEST crossed the DATA_ACK
+			if (acked) {
+				PRINTF("--readings of round %d already acknowledged\n", req.round);
+				leds_toggle(LEDS_GREEN);
+				return;
+			}
+
+			//send all readings in a single frame, in the reply slot; every
+			//retransmission waits for the DATA_ACK so all of them fit in the slot
+			slotStart = (clock_time_t)(((uint32_t)ROUND_GUARD + (uint32_t)slot * req.slotLength) *
+				CLOCK_SECOND / 1000);
+			elapsed = clock_time() - heard;
+			if (elapsed >= slotStart + (clock_time_t)((uint32_t)req.slotLength * CLOCK_SECOND / 1000)) {
+				PRINTF("--readings took %lu ms, slot %d missed\n",
+				(unsigned long)(elapsed * 1000 / CLOCK_SECOND), slot);
+				leds_toggle(LEDS_GREEN);
+				return;
 			}
+			PRINTF("--replying in slot %d\n", slot);
+			sn_readings.attempt = 0;
+			ackTimeout = (clock_time_t)((uint32_t)req.slotLength * CLOCK_SECOND /
+				(1000 * (DATA_MAX_RETRANSMISSIONS + 1)));
+			ctimer_set(&reply_timer, elapsed < slotStart ? slotStart - elapsed : 0, send_readings, NULL);
 		}
 		//if not, do nothing
 	}
@@ -338,8 +420,176 @@ recv_bc
 static void 
 recv_uc
 (struct unicast_conn *c, const linkaddr_t *from) {
-	PRINTF("unicast message received from %d.%d: %s\n", from->u8[0], from->u8[1], (char *)packetbuf_dataptr());
+	struct req_message *msg = packetbuf_dataptr();
+
+	PRINTF("unicast message received from %d.%d with header type: %d\n", from->u8[0], from->u8[1], msg->type);
+#if APC_RIME_MULTIHOP
+	if (msg->type == DATA_AGGREGATE) {
+		recv_aggregate(from);
+		return;
+	}
+#endif
+	if (!linkaddr_cmp(from, &sinkAddr)) {
+		return;
+	}
+	switch (msg->type) {
+	//the sink assigns the reply slot for collection rounds
+	case SLOT_ASSIGN:
+		assignedSlot = (uint8_t)msg->data[0];
+		PRINTF("--SLOT_ASSIGN: replying in slot %d\n", assignedSlot);
+		trickle_timer_consistency(&adv_timer);
+		break;
+	//the sink has the readings, stop retransmitting
+	case DATA_ACK:
+		trickle_timer_consistency(&adv_timer);
+		if ((uint8_t)msg->data[0] == sn_readings.seq) {
+			acked = 1;
+			ctimer_stop(&reply_timer);
+			PRINTF("--DATA_ACK: seq %d delivered\n", sn_readings.seq);
+		}
+		break;
+	//the sink got a damaged frame, retransmit now if any retransmission is left
+	case DATA_NACK:
+		if ((uint8_t)msg->data[0] == sn_readings.seq && !acked &&
+			!ctimer_expired(&reply_timer)) {
+			PRINTF("--DATA_NACK: seq %d sent again\n", sn_readings.seq);
+			ctimer_stop(&reply_timer);
+			send_readings(NULL);
+		}
+		break;
+	}
+}
+
+#if APC_RIME_MULTIHOP
+static void
+recv_tree_request
+(const linkaddr_t *from)
+{
+	struct tree_request req;
+	uint32_t sendAt;
+
+	memset(&req, 0, sizeof(req));
+	memcpy(&req, packetbuf_dataptr(), MIN(packetbuf_datalen(), sizeof(struct tree_request)));
+	//join the tree once per round, through the first node heard
+	if (req.round == 0 || req.round == treeRound || req.depth >= req.maxDepth) {
+		return;
+	}
+	requestHeard = clock_time();
+	treeRound = req.round;
+	depth = req.depth + 1;
+	linkaddr_copy(&parent, from);
+	PRINTF("--TREE_REQUEST: round %d, depth %d through %d.%d\n",
+	treeRound, depth, parent.u8[0], parent.u8[1]);
+
+	//this node's own readings go first, children's join them until the send
+	take_readings(req.round);
+	memcpy(&pending[0].origin, &linkaddr_node_addr, sizeof(linkaddr_t));
+	pending[0].hops = depth;
+	memcpy(&pending[0].readings, &sn_readings, sizeof(struct readings_message));
+	pendingCount = 1;
+	pendingSent = 0;
+	sentUpstream = 0;
+
+	//forward after a random delay, so that nodes of the same depth do not collide
+	if (depth < req.maxDepth) {
+		memcpy(&treeRequest, &req, sizeof(struct tree_request));
+		ctimer_set(&forward_timer,
+			(clock_time_t)(random_rand() % (TREE_FORWARD_JITTER * CLOCK_SECOND / 1000 + 1)),
+			forward_tree_request, NULL);
+	}
+
+	//send upstream at a random point in the first half of this depth's phase
+	sendAt = req.floodGuard + (uint32_t)(req.maxDepth - depth) * req.phaseLength +
+		random_rand() % (req.phaseLength / 2 + 1);
+	//less the time since the request was sent, including the readings above
+	req.elapsed += (clock_time() - requestHeard) * 1000 / CLOCK_SECOND;
+	sendAt = sendAt > req.elapsed ? sendAt - req.elapsed : 0;
+	ctimer_set(&reply_timer, (clock_time_t)(sendAt * CLOCK_SECOND / 1000), send_aggregate, NULL);
+}
+
+static void
+forward_tree_request
+(void *ptr)
+{
+	treeRequest.depth = depth;
+	treeRequest.elapsed += (clock_time() - requestHeard) * 1000 / CLOCK_SECOND;
+	packetbuf_copyfrom(&treeRequest, sizeof(struct tree_request));
+	broadcast_send(&bc);
+	PRINTF("TREE_REQUEST - round %d forwarded at depth %d\n", treeRequest.round, depth);
+}
+
+static void
+recv_aggregate
+(const linkaddr_t *from)
+{
+	static struct aggregate_message msg;
+	uint8_t count;
+
+	memset(&msg, 0, sizeof(msg));
+	memcpy(&msg, packetbuf_dataptr(), MIN(packetbuf_datalen(), sizeof(struct aggregate_message)));
+	if (msg.round != treeRound || msg.count > AGGREGATE_MAX_ENTRIES ||
+		packetbuf_datalen() < AGGREGATE_SIZE(msg.count)) {
+		PRINTF("--DATA_AGGREGATE from %d.%d not for this round, dropped\n", from->u8[0], from->u8[1]);
+		return;
+	}
+	if (sentUpstream) {
+		droppedLate += msg.count;
+		PRINTF("--DATA_AGGREGATE from %d.%d after the upstream send, %d readings dropped\n",
+		from->u8[0], from->u8[1], msg.count);
+		return;
+	}
+	count = MIN(msg.count, AGGREGATE_MAX_ENTRIES * AGGREGATE_MAX_FRAMES - pendingCount);
+	memcpy(&pending[pendingCount], msg.entries, count * sizeof(struct aggregate_entry));
+	pendingCount += count;
+	droppedFull += msg.count - count;
+	PRINTF("--DATA_AGGREGATE: %d readings from %d.%d, %d pending\n",
+	count, from->u8[0], from->u8[1], pendingCount);
+}
+
+static void
+send_aggregate
+(void *ptr)
+{
+	sentUpstream = 1;
+	pendingSent = 0;
+	send_aggregate_frame();
+}
+
+static void
+send_aggregate_frame
+(void)
+{
+	static struct aggregate_message msg;
+	uint8_t count;
+
+	if (pendingSent >= pendingCount) {
+		return;
+	}
+	//one frame at a time: copying the next one would overwrite the packet
+	//buffer while the MAC may still hold this one
+	count = MIN(pendingCount - pendingSent, AGGREGATE_MAX_ENTRIES);
+	msg.type = DATA_AGGREGATE;
+	msg.round = treeRound;
+	msg.count = count;
+	memcpy(msg.entries, &pending[pendingSent], count * sizeof(struct aggregate_entry));
+	packetbuf_copyfrom(&msg, AGGREGATE_SIZE(count));
+	unicast_send(&uc, &parent);
+	pendingSent += count;
+	if (pendingSent < pendingCount) {
+		return;
+	}
+	PRINTF("DATA_AGGREGATE - round %d, %d readings sent to parent %d.%d (%lu dropped full, %lu late)\n",
+	treeRound, pendingCount, parent.u8[0], parent.u8[1], droppedFull, droppedLate);
+
+	//radio and CPU time so far, for the energy per delivered reading
+	energest_flush();
+	PRINTF("ENERGY %lu %lu %lu %lu\n",
+	(unsigned long)((uint64_t)energest_type_time(ENERGEST_TYPE_CPU) * 1000 / RTIMER_SECOND),
+	(unsigned long)((uint64_t)energest_type_time(ENERGEST_TYPE_LPM) * 1000 / RTIMER_SECOND),
+	(unsigned long)((uint64_t)energest_type_time(ENERGEST_TYPE_TRANSMIT) * 1000 / RTIMER_SECOND),
+	(unsigned long)((uint64_t)energest_type_time(ENERGEST_TYPE_LISTEN) * 1000 / RTIMER_SECOND));
 }
+#endif
 
 static void
 sent_uc
@@ -352,6 +602,12 @@ sent_uc
 	}
 
 	PRINTF("unicast message sent to %d.%d: status %d num_tx %d\n", dest->u8[0], dest->u8[1], status, num_tx);
+#if APC_RIME_MULTIHOP
+	//the packet buffer is free again, send the rest of the readings
+	if (sentUpstream && linkaddr_cmp(dest, &parent)) {
+		send_aggregate_frame();
+	}
+#endif
 }
 
 //function definition end
@@ -366,8 +622,6 @@ AUTOSTART_PROCESSES(&apc_sensor_node_unicast_process, &apc_sensor_node_broadcast
 PROCESS_THREAD(apc_sensor_node_unicast_process, ev, data)
 {
 	//initialization
-	static struct req_message msg;
-	msg.type = NBR_ADV;
 
 	//pass the event handler for process exit
 	PROCESS_EXITHANDLER(unicast_close(&uc));
@@ -385,20 +639,15 @@ PROCESS_THREAD(apc_sensor_node_unicast_process, ev, data)
 	sinkAddr.u8[0] = SINK_ADDR0; //sets the server address[0]
 	sinkAddr.u8[1] = SINK_ADDR1; //sets the server address[1]
 
-	//initialize sensor node readings
-	int i;
-	for (i = 0; i < SENSOR_COUNT; i++) {
-		sn_readings.sensor_node_reading[i].type = SENSOR_TYPES[i];
-	}
-
-	//advertise this node to the server
-	packetbuf_copyfrom(&msg, sizeof( struct req_message ));
-
-	unicast_send(&uc, &sinkAddr);
-	PRINTF("ADVERTISE - header type %d and value %s - sent to server address %d.%d\n", 
-	msg.type, msg.data,
-	sinkAddr.u8[0], sinkAddr.u8[1]
-	);
+#if !APC_RIME_MULTIHOP
+	//advertise this node to the server, first within NBR_ADV_IMIN
+	trickle_timer_config(&adv_timer, NBR_ADV_IMIN, NBR_ADV_IMAX, NBR_ADV_REDUNDANCY);
+	trickle_timer_set(&adv_timer, send_nbr_adv, NULL);
+#else
+	//the sink learns the nodes of the tree from their readings, most are
+	//out of its range
+	send_nbr_adv(NULL, TRICKLE_TIMER_TX_OK);
+#endif
 	leds_blink();
 	leds_off(LEDS_ALL);
 
@@ -1,10 +1,17 @@
 #include "contiki.h"
+#if CONTIKI_TARGET_COOJA
+#include "sim-sensors.h"
+#else
 #include "dev/dht22.h"
 #include "dev/adc-zoul.h"
 #include "dev/zoul-sensors.h"
 #include "dev/pm25-sensor.h"
 #include "dev/gpio.h"
+#endif
 #include "net/rime/rime.h"
+#include "lib/random.h"
+#include "lib/trickle-timer.h"
+#include "sys/energest.h"
 
 #include "../apc-request.h"
 
@@ -17,13 +24,109 @@
 
 //global variables start
 static linkaddr_t sinkAddr;
+
+//reply slot assigned by the sink, NO_SLOT until a SLOT_ASSIGN arrives
+#define NO_SLOT 0xFF
+static uint8_t assignedSlot = NO_SLOT;
+
+//sends the readings at the start of the reply slot, then again until the
+//sink acknowledges them or the retransmissions run out
+static struct ctimer reply_timer;
+
+//time to wait for the DATA_ACK of the readings, set by the slot length
+static clock_time_t ackTimeout;
+
+//sequence number of the current readings and whether the sink has them
+static uint8_t seq;
+static uint8_t acked;
+
+//advertises this node to the sink, fast after a boot or a restart of the
+//sink and exponentially sparser while the sink keeps acknowledging it
+static struct trickle_timer adv_timer;
+
+//epoch of the sink from its last DATA_REQUEST, 0 until one arrives
+static uint8_t sinkEpoch;
+
+#if APC_RIME_MULTIHOP
+//parent and depth of this node in the tree of the current round
+static linkaddr_t parent;
+static uint8_t depth;
+static uint8_t treeRound;
+
+//the TREE_REQUEST to forward and when it was heard
+static struct tree_request treeRequest;
+static clock_time_t requestHeard;
+static struct ctimer forward_timer;
+
+//readings of this node and its subtree waiting to go upstream
+static struct aggregate_entry pending[AGGREGATE_MAX_ENTRIES * AGGREGATE_MAX_FRAMES];
+static uint8_t pendingCount;
+static uint8_t sentUpstream;
+
+//pending readings already handed to the MAC, the next frame goes out once
+//the previous one is sent
+static uint8_t pendingSent;
+
+//children's readings dropped: no room left, or arrived after this node sent
+static unsigned long droppedFull;
+static unsigned long droppedLate;
+#endif
 //global variables end
 
+//function that sends the NBR_ADV, unless the Trickle timer suppresses it
+static void
+send_nbr_adv
+(void *ptr, uint8_t suppress);
+
+//function that checks the epoch of a DATA_REQUEST, a new one means the sink
+//has restarted and forgotten this node
+static void
+check_epoch
+(uint8_t epoch);
+
 //function that reads from the specified sensor
 //returns nonzero if successful, zero otherwise
 static int
 read_sensor
-(uint8_t sensorType, uint8_t nodeNumber);
+(uint8_t sensorType);
+
+//function that reads every sensor for the given round, once per round
+static void
+take_readings
+(uint8_t round);
+
+//function that sends the readings of the current round to the sink and
+//schedules their retransmission
+static void
+send_readings
+(void *ptr);
+
+#if APC_RIME_MULTIHOP
+//function called when a TREE_REQUEST is received, joins the tree of its round
+static void
+recv_tree_request
+(const linkaddr_t *from);
+
+//function that forwards the TREE_REQUEST one hop further
+static void
+forward_tree_request
+(void *ptr);
+
+//function called when a child sends the readings of its subtree
+static void
+recv_aggregate
+(const linkaddr_t *from);
+
+//function that sends the readings of this node and its subtree to the parent
+static void
+send_aggregate
+(void *ptr);
+
+//function that sends the next DATA_AGGREGATE frame of the pending readings
+static void
+send_aggregate_frame
+(void);
+#endif
 
 //function called when a broadcast message is received
 static void
@@ -56,12 +159,8 @@ bc;
 static struct unicast_conn
 uc;
 
-//struct containing the sensor readings for this node
-struct sensor_node_readings {
-  struct sensor_reading sensor_node_reading[SENSOR_COUNT];
-};
-
-static struct sensor_node_readings
+//the sensor readings for this node, sent to the sink as one frame
+static struct readings_message
 sn_readings;
 
 /*index is node number
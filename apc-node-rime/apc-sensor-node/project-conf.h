@@ -4,8 +4,19 @@
 //networking config
 #define SENSORNETWORKCHANNEL_UC         146
 #define SENSORNETWORKCHANNEL_BC         147
+#if CONTIKI_TARGET_COOJA
+//Cooja gives mote 1 (the sink) the Rime address 1.0
+#define SINK_ADDR0                      0x01
+#define SINK_ADDR1                      0x00
+#else
 #define SINK_ADDR0                      0x51
 #define SINK_ADDR1                      0x74
+#endif
+
+//keep the radio on: the reply slots (SLOT_LENGTH) and the DATA_ACK wait, a
+//third of a slot, are far shorter than a ContikiMAC channel check (125 ms at
+//the default 8 Hz), whose strobes would outlast every retransmission
+#define NETSTACK_CONF_RDC               nullrdc_driver
 
 //enable the disabled ADC channels (ADC1 and ADC3 are enabled by default)
 //(refer to board layout for pin configuration)
@@ -57,4 +68,10 @@
 #define MQ131_CONF_RO_CLEAN_AIR         500
 #define MQ135_CONF_RO_CLEAN_AIR         500
 
+//radio and CPU time for the energy per delivered reading, reported by
+//multi-hop nodes after every round
+#if APC_RIME_CONF_MULTIHOP
+#define ENERGEST_CONF_ON                1
+#endif
+
 #endif
@@ -1,7 +1,13 @@
+#include <stddef.h>
+#include <stdlib.h>
 #include "apc-sink-node.h"
 
-//debugging purposes
+//debugging purposes, the text shares the UART with the reading records
+#ifdef SINK_CONF_DEBUG
+#define DEBUG SINK_CONF_DEBUG
+#else
 #define DEBUG 1
+#endif
 #if DEBUG
 #define PRINTF(...) printf(__VA_ARGS__)
 #else
@@ -10,6 +16,28 @@
 
 #define WEEK_SCALETO_SECOND 604800
 
+//epoch of this boot, sent in every DATA_REQUEST so that the sensor nodes
+//notice a restart and advertise themselves again
+static uint8_t epoch;
+
+//current collection round, its start and the replies received so far
+static uint8_t currentRound;
+static clock_time_t roundStart;
+static clock_time_t lastReply;
+static int firstReplies;
+static int repolls;
+static int roundRetransmitted;
+static int roundDuplicates;
+static unsigned long roundLatency;
+
+//multi-hop collection: DATA_AGGREGATE frames and deepest reading of the round
+static int roundFrames;
+static uint8_t roundDepth;
+
+//DATA_ACK and DATA_NACK sent since boot
+static unsigned long acksSent;
+static unsigned long nacksSent;
+
 //function definitions start
 static void
 summarize_readings_callback(void* arg)
@@ -26,7 +54,7 @@ summarize_readings_callback(void* arg)
 	elapsedSeconds % 60 //seconds
 	);
 	//iterate through each sensor node
-	for(n = list_head(sensor_nodes_list); n != NULL; n = list_item_next(n)) {
+	for(n = sensor_node_table_next(NULL); n != NULL; n = sensor_node_table_next(n)) {
 		//display readings for each node
 		PRINTF("--Sensor Node--\n");
 		PRINTF("Address: %d.%d\n",n->addr.u8[0],n->addr.u8[1]);
@@ -39,7 +67,11 @@ summarize_readings_callback(void* arg)
 		PRINTF("O3: %s Rs/Ro\n", n->O3);
 		PRINTF("Wind Speed: %s\n", n->windSpeed);
 		PRINTF("Wind Direction: %s\n", n->windDir);
+		PRINTF("----Delivery----\n");
+		PRINTF("Rounds: %u/%u replied, %u retransmitted, %u duplicates dropped\n",
+		n->delivered, n->rounds, n->retransmitted, n->duplicates);
 	}
+	PRINTF("DELIVERY: %lu DATA_ACK and %lu DATA_NACK sent\n", acksSent, nacksSent);
 	PRINTF("------------------\n");
 	PRINTF("\n\n");
 }
@@ -47,34 +79,14 @@ static void
 add_sensor_node(const linkaddr_t *node_address)
 {
 	struct sensor_node *n;
-	/* Check if we already know this neighbor. */
-	for(n = list_head(sensor_nodes_list); n != NULL; n = list_item_next(n)) {
-		/* We break out of the loop if the address of the neighbor matches
-	the address of the neighbor from which we received this
-	broadcast message. */
-		if(linkaddr_cmp(&n->addr, node_address)) {
-			break;
-		}
-	}
-	/* If n is NULL, this neighbor was not found in our list, and we
-	allocate a new struct neighbor from the neighbors_memb memory
-	pool. */
-	if(n == NULL) {
-		n = memb_alloc(&sensor_nodes_memb);
-		/* If we could not allocate a new neighbor entry, we give up. We
-	could have reused an old neighbor entry, but we do not do this
-	for now. */
-		if(n == NULL) {
-			PRINTF("Failed to allocate sensor node entry.\n");
-			return;
-		}
-		/* Initialize the fields. */
-		linkaddr_copy(&n->addr, node_address);
-		/* Place the neighbor on the neighbor list. */
-		list_add(sensor_nodes_list, n);
+	int known = sensor_node_table_find(node_address) != NULL;
+	/* Look the node up, adding it (or replacing the node that has been
+	silent the longest when the table is full) if it is new. */
+	n = sensor_node_table_add(node_address);
+	if(!known) {
 		/* Print out a message. */
-		PRINTF("New sensor node added with address %d.%d\n",
-		node_address->u8[0], node_address->u8[1]
+		PRINTF("New sensor node added with address %d.%d (%d known)\n",
+		node_address->u8[0], node_address->u8[1], sensor_node_table_count()
 		);
 	}
 	/* We can now fill in the fields in our neighbor entry. */
@@ -86,75 +98,242 @@ add_sensor_node(const linkaddr_t *node_address)
 	packetbuf_attr(PACKETBUF_ATTR_RSSI),
 	packetbuf_attr(PACKETBUF_ATTR_LINK_QUALITY)
 	);
+#if !APC_RIME_MULTIHOP
+	assign_slot(n);
+#endif
+}
+static void
+send_delivery_reply(const linkaddr_t *addr, uint8_t type, uint8_t seq)
+{
+	struct req_message msg;
+	msg.type = type;
+	msg.data[0] = (char)seq;
+	packetbuf_copyfrom(&msg, sizeof(struct req_message));
+	unicast_send(&uc, addr);
+	if(type == DATA_ACK) {
+		acksSent++;
+	}
+	else {
+		nacksSent++;
+	}
+}
+static void
+assign_slot(const struct sensor_node *n)
+{
+	struct req_message msg;
+	msg.type = SLOT_ASSIGN;
+	msg.data[0] = (char)sensor_node_table_slot(n);
+	packetbuf_copyfrom(&msg, sizeof(struct req_message));
+	unicast_send(&uc, &n->addr);
+	PRINTF("SLOT_ASSIGN - slot %d sent to sensor node %d.%d\n",
+	sensor_node_table_slot(n), n->addr.u8[0], n->addr.u8[1]
+	);
+}
+#if !APC_RIME_MULTIHOP
+static clock_time_t
+send_data_request(const linkaddr_t *nodes, uint8_t count)
+{
+	static struct data_request req;
+	struct sensor_node *n;
+	int slots = 0;
+	//assigned slots run up to the last node in the table
+	for(n = sensor_node_table_next(NULL); n != NULL; n = sensor_node_table_next(n)) {
+		slots = sensor_node_table_slot(n) + 1;
+	}
+	req.type = DATA_REQUEST;
+	req.round = currentRound;
+	req.slotLength = SLOT_LENGTH;
+	req.slots = slots;
+	req.count = count;
+	req.epoch = epoch;
+	memcpy(req.nodes, nodes, count * sizeof(linkaddr_t));
+	packetbuf_copyfrom(&req, DATA_REQUEST_SIZE(count));
+	leds_toggle(LEDS_GREEN);
+	broadcast_send(&bc);
+	leds_toggle(LEDS_GREEN);
+	PRINTF("BC - DATA_REQUEST sent for round %d (%d nodes re-polled).\n", currentRound, count);
+	//a re-poll only has the slots of the listed nodes
+	if(count > 0) {
+		slots = count;
+	}
+	else {
+		slots += DATA_REQUEST_SPARE_SLOTS;
+	}
+	return (clock_time_t)((uint32_t)(slots * SLOT_LENGTH + ROUND_GUARD) * CLOCK_SECOND / 1000);
 }
+#else
+static clock_time_t
+send_tree_request(void)
+{
+	static struct tree_request req;
+	req.type = TREE_REQUEST;
+	req.round = currentRound;
+	req.depth = 0;
+	req.maxDepth = TREE_MAX_DEPTH;
+	req.phaseLength = TREE_PHASE_LENGTH;
+	req.floodGuard = TREE_FLOOD_GUARD;
+	req.elapsed = 0;
+	packetbuf_copyfrom(&req, sizeof(struct tree_request));
+	leds_toggle(LEDS_GREEN);
+	broadcast_send(&bc);
+	leds_toggle(LEDS_GREEN);
+	PRINTF("BC - TREE_REQUEST sent for round %d.\n", currentRound);
+	return (clock_time_t)((uint32_t)(TREE_FLOOD_GUARD + TREE_MAX_DEPTH * TREE_PHASE_LENGTH + ROUND_GUARD) *
+		CLOCK_SECOND / 1000);
+}
+#endif
 static void
 update_sensor_node_reading(const linkaddr_t *nodeAddress, struct sensor_reading *reading)
 {
 	struct sensor_node *n;
 	//get the associated sensor node of this address
-	if(list_length(sensor_nodes_list) > 0) {
-		int i;
-		n = list_head(sensor_nodes_list);
-		for(i = 0; i < list_length(sensor_nodes_list); i++) {
-			//break when matching address is found
-			if (linkaddr_cmp(&n->addr, nodeAddress))
-			break;
-			n = list_item_next(n);
-		}
-		
-		if (n == NULL){
-			//no match is found, discontinue
-			PRINTF("Failed to update sensor node reading (%d.%d) - no matching address found in sensor_nodes_list.\n",
-			nodeAddress->u8[0], nodeAddress->u8[1]
+	n = sensor_node_table_find(nodeAddress);
+	if (n == NULL){
+		//no match is found, discontinue
+		PRINTF("Failed to update sensor node reading (%d.%d) - no matching address found in sensor node table.\n",
+		nodeAddress->u8[0], nodeAddress->u8[1]
+		);
+		return;
+	}
+	//update the sensor values with the given type
+	switch (reading->type){
+	case TEMPERATURE_T:
+		strcpy(n->temperature, reading->data);
+		PRINTF("TEMPERATURE_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->temperature);
+		break;
+	case HUMIDITY_T:
+		strcpy(n->humidity, reading->data);
+		PRINTF("HUMIDITY_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->humidity);
+		break;
+	case PM25_T:
+		strcpy(n->PM25, reading->data);
+		PRINTF("PM25_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->PM25);
+		break;
+	case CO_T:
+		strcpy(n->CO, reading->data);
+		PRINTF("CO_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->CO);
+		break;
+	case CO2_T:
+		strcpy(n->CO2, reading->data);
+		PRINTF("CO2_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->CO2);
+		break;
+	case O3_T:
+		strcpy(n->O3, reading->data);
+		PRINTF("O3_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->O3);
+		break;
+	case WIND_SPEED_T:
+		strcpy(n->windSpeed, reading->data);
+		PRINTF("WIND_SPEED_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->windSpeed);
+		break;
+	case WIND_DRCTN_T:
+		strcpy(n->windDir, reading->data);
+		PRINTF("WIND_DRCTN_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->windDir);
+		break;
+	default:
+		PRINTF("Failed to update sensor node reading (%d.%d) - unexpected type of sensor reading.\n",
+		nodeAddress->u8[0], nodeAddress->u8[1]
+		);
+		//unexpected, do nothing
+	}
+}
+static void
+update_sensor_node_readings(const linkaddr_t *nodeAddress, const struct readings_message *readings)
+{
+	struct sensor_reading reading;
+	uint8_t type;
+	for(type = TEMPERATURE_T; type <= WIND_DRCTN_T; type++) {
+		if(!(readings->valid & READING_VALID(type))) {
+			PRINTF("Sensor node with address %d.%d reports failure in reading sensor type %d.\n",
+			nodeAddress->u8[0], nodeAddress->u8[1], type
 			);
-			return;
+			continue;
 		}
-		else{
-			//update the sensor values with the given type
-			switch (reading->type){
-			case TEMPERATURE_T:
-				strcpy(n->temperature, reading->data);
-				PRINTF("TEMPERATURE_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->temperature);
-				break;
-			case HUMIDITY_T:
-				strcpy(n->humidity, reading->data);
-				PRINTF("HUMIDITY_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->humidity);
-				break;
-			case PM25_T:
-				strcpy(n->PM25, reading->data);
-				PRINTF("PM25_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->PM25);
-				break;
-			case CO_T:
-				strcpy(n->CO, reading->data);
-				PRINTF("CO_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->CO);
-				break;
-			case CO2_T:
-				strcpy(n->CO2, reading->data);
-				PRINTF("CO2_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->CO2);
-				break;
-			case O3_T:
-				strcpy(n->O3, reading->data);
-				PRINTF("O3_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->O3);
-				break;
-			case WIND_SPEED_T:
-				strcpy(n->windSpeed, reading->data);
-				PRINTF("WIND_SPEED_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->windSpeed);
-				break;
-			case WIND_DRCTN_T:
-				strcpy(n->windDir, reading->data);
-				PRINTF("WIND_DRCTN_T of sensor node %d.%d UPDATED with value: %s\n", nodeAddress->u8[0], nodeAddress->u8[1], n->windDir);
-				break;
-			default:
-				PRINTF("Failed to update sensor node reading (%d.%d) - unexpected type of sensor reading.\n",
-				nodeAddress->u8[0], nodeAddress->u8[1]
-				);
-				//unexpected, do nothing
-			}
+		//format the value the same way the sensor node used to send it
+		reading.type = type;
+		switch(type){
+		case TEMPERATURE_T:
+			snprintf(reading.data, sizeof(reading.data), "%s%02d.%d",
+			readings->temperature < 0 ? "-" : "",
+			abs(readings->temperature) / 10, abs(readings->temperature) % 10);
+			break;
+		case HUMIDITY_T:
+			snprintf(reading.data, sizeof(reading.data), "%02u.%u",
+			readings->humidity / 10, readings->humidity % 10);
+			break;
+		case PM25_T:
+			snprintf(reading.data, sizeof(reading.data), "%02u", readings->PM25);
+			break;
+		case CO_T:
+			snprintf(reading.data, sizeof(reading.data), "%02lu.%03lu",
+			(unsigned long)readings->CO / 1000, (unsigned long)readings->CO % 1000);
+			break;
+		case CO2_T:
+			snprintf(reading.data, sizeof(reading.data), "%02lu.%03lu",
+			(unsigned long)readings->CO2 / 1000, (unsigned long)readings->CO2 % 1000);
+			break;
+		case O3_T:
+			snprintf(reading.data, sizeof(reading.data), "%02lu.%03lu",
+			(unsigned long)readings->O3 / 1000, (unsigned long)readings->O3 % 1000);
+			break;
+		case WIND_SPEED_T:
+			snprintf(reading.data, sizeof(reading.data), "%02u.%02u",
+			readings->windSpeed / 100, readings->windSpeed % 100);
+			break;
+		case WIND_DRCTN_T:
+			snprintf(reading.data, sizeof(reading.data), "%s%s%s%s",
+			readings->windDir & WIND_DRCTN_N ? "N" : "",
+			readings->windDir & WIND_DRCTN_S ? "S" : "",
+			readings->windDir & WIND_DRCTN_E ? "E" : "",
+			readings->windDir & WIND_DRCTN_W ? "W" : "");
+			break;
 		}
+		update_sensor_node_reading(nodeAddress, &reading);
+	}
+}
+static int
+receive_readings(const linkaddr_t *origin, int16_t rssi, uint8_t lqi,
+	const struct readings_message *readings)
+{
+	struct sensor_node *node;
+	//a node the sink does not know yet (or evicted) gets a slot now
+	if(sensor_node_table_find(origin) == NULL) {
+		add_sensor_node(origin);
+	}
+	node = sensor_node_table_find(origin);
+	//a retransmission of readings the sink already has, its DATA_ACK was lost
+	if(node != NULL && readings->seq == node->last_seq) {
+		PRINTF("Duplicate readings (seq %d) from %d.%d dropped.\n",
+		readings->seq, origin->u8[0], origin->u8[1]
+		);
+		node->duplicates++;
+		roundDuplicates++;
+		return 0;
 	}
-	else{
-		PRINTF("Failed to update sensor node reading - sensor_nodes_list is empty.\n");
+	update_sensor_node_readings(origin, readings);
+	sink_records_send(origin, rssi, lqi, readings);
+	if(node == NULL) {
+		return 1;
 	}
+	node->last_seq = readings->seq;
+	if(readings->attempt > 0) {
+		node->retransmitted++;
+		roundRetransmitted++;
+	}
+	//count the first reply of the node in the current round
+	if(readings->round == currentRound && node->last_round != currentRound) {
+		node->last_round = currentRound;
+		node->delivered++;
+		lastReply = clock_time();
+		roundLatency += (unsigned long)(lastReply - roundStart) * 1000 / CLOCK_SECOND;
+		if(repolls == 0) {
+			firstReplies++;
+		}
+		else {
+			//it missed its slot, it may not know it
+			assign_slot(node);
+		}
+	}
+	return 1;
 }
 //this sink sends broadcasts, but does not reply to broadcasts
 static void
@@ -166,9 +345,15 @@ recv_uc
 (struct unicast_conn *c, const linkaddr_t *from) {
 	struct req_message *msg;
 	struct sensor_reading reading;
+	struct readings_message readings;
+	static struct aggregate_message aggregate;
+	linkaddr_t origin;
+	int16_t rssi;
+	uint8_t lqi;
+	int i;
 	msg = packetbuf_dataptr();
-	PRINTF("unicast message received from %d.%d with header type: %d and data: %s\n",
-	from->u8[0], from->u8[1], msg->type, msg->data
+	PRINTF("unicast message received from %d.%d with header type: %d and length: %d\n",
+	from->u8[0], from->u8[1], msg->type, packetbuf_datalen()
 	);
 	//check message type
 	switch(msg->type){
@@ -177,6 +362,51 @@ recv_uc
 		PRINTF("--NBR_ADV identified\n");
 		add_sensor_node(from);
 		break;
+	case DATA_READINGS:
+		PRINTF("--DATA_READINGS identified\n");
+		//link quality of this frame, replies below reuse the packet buffer
+		rssi = (int16_t)packetbuf_attr(PACKETBUF_ATTR_RSSI);
+		lqi = packetbuf_attr(PACKETBUF_ATTR_LINK_QUALITY);
+		if(packetbuf_datalen() < sizeof(struct readings_message)) {
+			PRINTF("Readings frame from %d.%d is too short (%d bytes).\n",
+			from->u8[0], from->u8[1], packetbuf_datalen()
+			);
+			//ask for the readings again if their sequence number made it
+			if(packetbuf_datalen() > offsetof(struct readings_message, seq)) {
+				send_delivery_reply(from, DATA_NACK,
+				((const uint8_t *)msg)[offsetof(struct readings_message, seq)]);
+			}
+			break;
+		}
+		//copy out of the packet buffer, the frame is packed and may be unaligned
+		memcpy(&readings, msg, sizeof(struct readings_message));
+		receive_readings(from, rssi, lqi, &readings);
+		//acknowledge duplicates too, their DATA_ACK was lost
+		send_delivery_reply(from, DATA_ACK, readings.seq);
+		break;
+	case DATA_AGGREGATE:
+		PRINTF("--DATA_AGGREGATE identified\n");
+		rssi = (int16_t)packetbuf_attr(PACKETBUF_ATTR_RSSI);
+		lqi = packetbuf_attr(PACKETBUF_ATTR_LINK_QUALITY);
+		memset(&aggregate, 0, sizeof(aggregate));
+		memcpy(&aggregate, msg, MIN(packetbuf_datalen(), sizeof(struct aggregate_message)));
+		if(aggregate.count > AGGREGATE_MAX_ENTRIES || packetbuf_datalen() < AGGREGATE_SIZE(aggregate.count)) {
+			PRINTF("Aggregate frame from %d.%d is too short (%d bytes).\n",
+			from->u8[0], from->u8[1], packetbuf_datalen()
+			);
+			break;
+		}
+		roundFrames += aggregate.round == currentRound;
+		//the RSSI and LQI are those of the last hop
+		for(i = 0; i < aggregate.count; i++) {
+			memcpy(&origin, &aggregate.entries[i].origin, sizeof(linkaddr_t));
+			memcpy(&readings, &aggregate.entries[i].readings, sizeof(struct readings_message));
+			if(aggregate.round == currentRound) {
+				roundDepth = MAX(roundDepth, aggregate.entries[i].hops);
+			}
+			receive_readings(&origin, rssi, lqi, &readings);
+		}
+		break;
 	case SENSOR_FAILED:
 		PRINTF("--SENSOR_FAILED identified\n");
 		PRINTF("Sensor node with address %d.%d reports failure in reading sensors.\n",
@@ -260,6 +490,7 @@ PROCESS_THREAD(apc_server_node_unicast_process, ev, data)
 	PROCESS_EXITHANDLER(unicast_close(&uc));
 	//preparations are complete
 	PROCESS_BEGIN();
+	sensor_node_table_init();
 	//open this device for unicast networking
 	unicast_open(&uc, SENSORNETWORKCHANNEL_UC, &unicast_callback);
 	PRINTF("APC Sink Node (Unicast) begins...\n");
@@ -272,7 +503,14 @@ PROCESS_THREAD(apc_server_node_broadcast_process, ev, data)
 {
 	//initialization
 	static struct etimer et;
-	struct req_message msg;
+	static struct etimer rt;
+#if !APC_RIME_MULTIHOP
+	static linkaddr_t missing[DATA_REQUEST_MAX_NODES];
+	static int missingCount;
+#endif
+	static int nodes;
+	static int replied;
+	struct sensor_node *n;
 	//pass the event handler for process exit
 	PROCESS_EXITHANDLER(broadcast_close(&bc));
 	//preparations are complete
@@ -280,20 +518,68 @@ PROCESS_THREAD(apc_server_node_broadcast_process, ev, data)
 	//open this device for unicast networking
 	broadcast_open(&bc, SENSORNETWORKCHANNEL_BC, &broadcast_callback);
 	PRINTF("APC Sink Node (Broadcast) begins...\n");
-	//send DATA_REQUEST broadcast at regular intervals
+	//random, so a restart changes it in all but 1 of 255 boots
+	epoch = (uint8_t)(random_rand() % 0xFF) + 1;
+	PRINTF("Epoch %d\n", epoch);
+	//start a collection round at regular intervals
 	while(1){
 		
 		etimer_set(&et, CLOCK_SECOND * SENSOR_REQUEST_INTERVAL);
 		//wait until the timer expiration to broadcast event
 		PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
 		
-		//broadcast sensor reading request
-		msg.type = DATA_REQUEST;
-		packetbuf_copyfrom(&msg, sizeof(struct req_message));
-		leds_toggle(LEDS_GREEN);
-		broadcast_send(&bc);
-		leds_toggle(LEDS_GREEN);
-		PRINTF("BC - DATA_REQUEST sent.\n");
+		//broadcast sensor reading request, every node replies in its own slot
+		currentRound = currentRound == 0xFF ? 1 : currentRound + 1;
+		roundStart = clock_time();
+		lastReply = roundStart;
+		firstReplies = 0;
+		repolls = 0;
+		roundRetransmitted = 0;
+		roundDuplicates = 0;
+		roundLatency = 0;
+		roundFrames = 0;
+		roundDepth = 0;
+#if APC_RIME_MULTIHOP
+		//the readings of the whole tree arrive in one pass, the deepest first
+		etimer_set(&rt, send_tree_request());
+		PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&rt));
+#else
+		etimer_set(&rt, send_data_request(NULL, 0));
+		while(1){
+			PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&rt));
+			//re-poll only the nodes that have not replied yet
+			missingCount = 0;
+			for(n = sensor_node_table_next(NULL); n != NULL; n = sensor_node_table_next(n)) {
+				if(n->last_round != currentRound && missingCount < DATA_REQUEST_MAX_NODES) {
+					linkaddr_copy(&missing[missingCount++], &n->addr);
+				}
+			}
+			if(missingCount == 0 || repolls == MAX_REPOLLS) {
+				break;
+			}
+			repolls++;
+			etimer_set(&rt, send_data_request(missing, missingCount));
+		}
+#endif
+		//round summary
+		nodes = 0;
+		replied = 0;
+		for(n = sensor_node_table_next(NULL); n != NULL; n = sensor_node_table_next(n)) {
+			nodes++;
+			n->rounds++;
+			replied += n->last_round == currentRound;
+		}
+#if APC_RIME_MULTIHOP
+		PRINTF("TREE %d: %d DATA_AGGREGATE frames, deepest reading from %d hops\n",
+		currentRound, roundFrames, roundDepth);
+#endif
+		PRINTF("ROUND %d: %d/%d nodes replied (%d in the first poll), %d re-polls, last reply after %lu ms, "
+		"%d retransmitted, %d duplicates, mean reply after %lu ms\n",
+		currentRound, replied, nodes, firstReplies, repolls,
+		(unsigned long)(lastReply - roundStart) * 1000 / CLOCK_SECOND,
+		roundRetransmitted, roundDuplicates,
+		replied > 0 ? roundLatency / replied : 0UL
+		);
 	}
 	PROCESS_END();
 }
@@ -3,13 +3,14 @@
 #include <string.h>
 #include "dev/leds.h"
 #include "net/rime/rime.h"
+#include "lib/random.h"
 #include "etimer.h"
 #include "ctimer.h"
 #include "stimer.h"
-#include "lib/list.h"
-#include "lib/memb.h"
 
 #include "../apc-request.h"
+#include "sensor-node-table.h"
+#include "sink-records.h"
 
 //summarizes the readings of the sensor nodes in the identified sensor node list
 static void
@@ -23,6 +24,37 @@ add_sensor_node(const linkaddr_t *node_address);
 static void
 update_sensor_node_reading(const linkaddr_t *nodeAddress, struct sensor_reading *reading);
 
+//decodes a packed readings frame and records each of its valid readings for the given node
+static void
+update_sensor_node_readings(const linkaddr_t *nodeAddress, const struct readings_message *readings);
+
+//acknowledges (DATA_ACK) or asks again for (DATA_NACK) the readings with the
+//given sequence number
+static void
+send_delivery_reply(const linkaddr_t *addr, uint8_t type, uint8_t seq);
+
+//records readings received from the given node, directly or through the
+//tree; returns zero if the sink already had them
+static int
+receive_readings(const linkaddr_t *origin, int16_t rssi, uint8_t lqi,
+	const struct readings_message *readings);
+
+//sends the node its reply slot for collection rounds
+static void
+assign_slot(const struct sensor_node *n);
+
+#if !APC_RIME_MULTIHOP
+//broadcasts a DATA_REQUEST for the current round to every node, or to the
+//given nodes only; returns the time to wait for their replies
+static clock_time_t
+send_data_request(const linkaddr_t *nodes, uint8_t count);
+#else
+//floods a TREE_REQUEST for the current round (multi-hop collection); returns
+//the time to wait for the readings of the deepest nodes
+static clock_time_t
+send_tree_request(void);
+#endif
+
 //function called when a broadcast message is received (UNUSED)
 static void
 broadcast_recv(struct broadcast_conn *c, const linkaddr_t *from);
@@ -53,46 +85,23 @@ bc;
 static struct unicast_conn 
 uc;
 
-//REF: example-neighbors.c in contiki examples
-/* This structure holds information about sensor nodes. */
-struct sensor_node {
-  /* The ->next pointer is needed since we are placing these on a
-     Contiki list. */
-  struct sensor_node *next;
-
-  /* The ->addr field holds the Rime address of the sensor node. */
-  linkaddr_t addr;
+//amount of time for sink node to wait before requesting data from sensor nodes (seconds)
+#define SENSOR_REQUEST_INTERVAL 30
 
-  /* The ->last_rssi and ->last_lqi fields hold the Received Signal
-     Strength Indicator (RSSI) and CC2420 Link Quality Indicator (LQI)
-     values that are received for the incoming broadcast packets. */
-  uint16_t last_rssi, last_lqi;
+//length of the reply slot of each sensor node in a collection round (ms)
+#define SLOT_LENGTH 50
 
-  /* Sensor readings data for this node */
+//times the sink re-polls the nodes missing from a round
+#define MAX_REPOLLS 2
 
-  char temperature[8]; //unit in Deg. Celsius
-  char humidity[8];    //unit in %RH (0%-100%)
-  char PM25[8];        //unit in ppm, compute to microgram per m3 at processing server
-  char CO[8];          //unitless (ratio in milli scale), compute to ppm at processing server
-  char CO2[8];         //unitless (ratio in milli scale), compute to ppm at processing server
-  char O3[8];          //unitless (ratio in milli scale), compute to ppm at processing server
-  char windSpeed[8];   //unit in m/s
-  char windDir[8];     //may be N, S, E, W and their combinations (NW, NE, SW, SE)
-};
+//multi-hop collection: deepest node in hops, and the time each depth has to
+//send its readings upstream (ms)
+#define TREE_MAX_DEPTH 4
+#define TREE_PHASE_LENGTH 100
 
-/* This #define defines the maximum amount of sensor nodes we can remember. */
-#define MAX_SENSOR_NODES 3
-
-//amount of time for sink node to wait before requesting data from sensor nodes (seconds)
-#define SENSOR_REQUEST_INTERVAL 30
+//time for the TREE_REQUEST to reach the deepest nodes, each hop reads its
+//sensors before forwarding it (ms)
+#define TREE_FLOOD_GUARD (TREE_MAX_DEPTH * (ROUND_GUARD + TREE_FORWARD_JITTER))
 
 //amount of time for sink node to wait before summarizing the output of the sensor nodes (seconds)
 #define SENSOR_SUMMARY_INTERVAL SENSOR_REQUEST_INTERVAL * 10
-
-/* This MEMB() definition defines a memory pool from which we allocate
-   sensor node entries entries. */
-MEMB(sensor_nodes_memb, struct sensor_node, MAX_SENSOR_NODES);
-
-/* The sensor_nodes_list is a Contiki list that holds the neighbors we
-   have seen thus far. */
-LIST(sensor_nodes_list);
@@ -3,4 +3,17 @@
 
 #define SENSORNETWORKCHANNEL_UC  146
 #define SENSORNETWORKCHANNEL_BC  147
+
+//keep the radio on: the reply slots (SLOT_LENGTH) and the DATA_ACK wait, a
+//third of a slot, are far shorter than a ContikiMAC channel check (125 ms at
+//the default 8 Hz), whose strobes would outlast every retransmission
+#define NETSTACK_CONF_RDC nullrdc_driver
+
+//maximum amount of sensor nodes the sink keeps readings for
+#define SENSOR_NODE_TABLE_CONF_SIZE 64
+
+//binary '!R' records of the readings on the UART, for rime_collector.py
+#define SINK_RECORDS_CONF_ENABLED 1
+//set to 0 to leave only the records on the UART
+#define SINK_CONF_DEBUG 1
 #endif
@@ -0,0 +1,190 @@
+/**
+ * \file
+ *         Sensor node table of the sink, see sensor-node-table.h
+ */
+#include <string.h>
+
+#include "sensor-node-table.h"
+/*---------------------------------------------------------------------------*/
+/* Index slots, a power of two at least twice the table size so that probe
+ * sequences stay short */
+#if SENSOR_NODE_TABLE_SIZE <= 2
+#define SLOTS                        4
+#elif SENSOR_NODE_TABLE_SIZE <= 4
+#define SLOTS                        8
+#elif SENSOR_NODE_TABLE_SIZE <= 8
+#define SLOTS                        16
+#elif SENSOR_NODE_TABLE_SIZE <= 16
+#define SLOTS                        32
+#elif SENSOR_NODE_TABLE_SIZE <= 32
+#define SLOTS                        64
+#elif SENSOR_NODE_TABLE_SIZE <= 64
+#define SLOTS                        128
+#elif SENSOR_NODE_TABLE_SIZE <= 127
+#define SLOTS                        256
+#else
+#error "SENSOR_NODE_TABLE_CONF_SIZE must be at most 127"
+#endif
+#define SLOT_MASK                    (SLOTS - 1)
+/* slot value of an unused index slot, others hold the entry number + 1 */
+#define SLOT_EMPTY                   0
+/*---------------------------------------------------------------------------*/
+static struct sensor_node entries[SENSOR_NODE_TABLE_SIZE];
+static uint8_t in_use[SENSOR_NODE_TABLE_SIZE];
+static uint8_t slots[SLOTS];
+static int count;
+/*---------------------------------------------------------------------------*/
+static unsigned
+home_slot(const linkaddr_t *addr)
+{
+	uint32_t h = 0;
+	int i;
+
+	for(i = 0; i < LINKADDR_SIZE; i++) {
+		h = h * 31 + addr->u8[i];
+	}
+	//spread neighbouring addresses over the whole index
+	h *= 2654435761UL;
+	return (unsigned)(h >> 16) & SLOT_MASK;
+}
+/*---------------------------------------------------------------------------*/
+/* Slot of the given address, or of the empty slot that ends its probe */
+static unsigned
+probe(const linkaddr_t *addr)
+{
+	unsigned i = home_slot(addr);
+
+	while(slots[i] != SLOT_EMPTY &&
+		!linkaddr_cmp(&entries[slots[i] - 1].addr, addr)) {
+		i = (i + 1) & SLOT_MASK;
+	}
+	return i;
+}
+/*---------------------------------------------------------------------------*/
+/* Empties slot i, moving later entries of the probe run back so that no
+ * lookup stops early at the hole */
+static void
+clear_slot(unsigned i)
+{
+	unsigned j = i;
+	unsigned k;
+
+	slots[i] = SLOT_EMPTY;
+	for(;;) {
+		j = (j + 1) & SLOT_MASK;
+		if(slots[j] == SLOT_EMPTY) {
+			return;
+		}
+		k = home_slot(&entries[slots[j] - 1].addr);
+		//leave the entry where it is if its home slot lies in (i, j]
+		if(i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+			continue;
+		}
+		slots[i] = slots[j];
+		slots[j] = SLOT_EMPTY;
+		i = j;
+	}
+}
+/*---------------------------------------------------------------------------*/
+/* Entry number of the node silent the longest */
+static int
+least_recently_seen(void)
+{
+	int oldest = -1;
+	int e;
+
+	for(e = 0; e < SENSOR_NODE_TABLE_SIZE; e++) {
+		if(in_use[e] &&
+			(oldest < 0 || entries[e].last_seen < entries[oldest].last_seen)) {
+			oldest = e;
+		}
+	}
+	return oldest;
+}
+/*---------------------------------------------------------------------------*/
+void
+sensor_node_table_init(void)
+{
+	memset(in_use, 0, sizeof(in_use));
+	memset(slots, SLOT_EMPTY, sizeof(slots));
+	count = 0;
+}
+/*---------------------------------------------------------------------------*/
+struct sensor_node *
+sensor_node_table_find(const linkaddr_t *addr)
+{
+	unsigned i = probe(addr);
+	struct sensor_node *n;
+
+	if(slots[i] == SLOT_EMPTY) {
+		return NULL;
+	}
+	n = &entries[slots[i] - 1];
+	n->last_seen = clock_seconds();
+	return n;
+}
+/*---------------------------------------------------------------------------*/
+struct sensor_node *
+sensor_node_table_add(const linkaddr_t *addr)
+{
+	struct sensor_node *n = sensor_node_table_find(addr);
+	int e;
+
+	if(n != NULL) {
+		return n;
+	}
+	if(count == SENSOR_NODE_TABLE_SIZE) {
+		sensor_node_table_remove(&entries[least_recently_seen()].addr);
+	}
+	for(e = 0; in_use[e]; e++);
+
+	n = &entries[e];
+	memset(n, 0, sizeof(*n));
+	linkaddr_copy(&n->addr, addr);
+	n->last_seen = clock_seconds();
+	in_use[e] = 1;
+	//the probe may have moved if an entry was evicted
+	slots[probe(addr)] = e + 1;
+	count++;
+	return n;
+}
+/*---------------------------------------------------------------------------*/
+int
+sensor_node_table_remove(const linkaddr_t *addr)
+{
+	unsigned i = probe(addr);
+
+	if(slots[i] == SLOT_EMPTY) {
+		return 0;
+	}
+	in_use[slots[i] - 1] = 0;
+	clear_slot(i);
+	count--;
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+sensor_node_table_count(void)
+{
+	return count;
+}
+/*---------------------------------------------------------------------------*/
+int
+sensor_node_table_slot(const struct sensor_node *n)
+{
+	return (int)(n - entries);
+}
+/*---------------------------------------------------------------------------*/
+struct sensor_node *
+sensor_node_table_next(struct sensor_node *n)
+{
+	int e = n == NULL ? 0 : (int)(n - entries) + 1;
+
+	for(; e < SENSOR_NODE_TABLE_SIZE; e++) {
+		if(in_use[e]) {
+			return &entries[e];
+		}
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
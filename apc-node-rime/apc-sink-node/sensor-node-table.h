@@ -0,0 +1,91 @@
+#ifndef SENSOR_NODE_TABLE_H_
+#define SENSOR_NODE_TABLE_H_
+/*---------------------------------------------------------------------------*/
+/* Sensor nodes known to the sink, keyed by Rime address.
+ *
+ * Entries live in a fixed array. An open-addressed index (linear probing, at
+ * most half full) maps an address to its entry, so a lookup is O(1) whatever
+ * the node count. When the table is full, the node that has been silent the
+ * longest is evicted to make room for a new one.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/linkaddr.h"
+/*---------------------------------------------------------------------------*/
+/* Maximum amount of sensor nodes the sink remembers (at most 127) */
+#ifdef SENSOR_NODE_TABLE_CONF_SIZE
+#define SENSOR_NODE_TABLE_SIZE       SENSOR_NODE_TABLE_CONF_SIZE
+#else
+#define SENSOR_NODE_TABLE_SIZE       64
+#endif
+/*---------------------------------------------------------------------------*/
+//REF: example-neighbors.c in contiki examples
+/* This structure holds information about sensor nodes. */
+struct sensor_node {
+  /* The ->addr field holds the Rime address of the sensor node. */
+  linkaddr_t addr;
+
+  /* clock_seconds() when the sink last heard from the node, for eviction */
+  unsigned long last_seen;
+
+  /* The last collection round the node replied to */
+  uint8_t last_round;
+
+  /* Sequence number of the last readings taken, retransmissions of them
+     are dropped */
+  uint8_t last_seq;
+
+  /* Delivery statistics: rounds the node was polled in and replied to,
+     readings that needed a retransmission and duplicates dropped */
+  uint16_t rounds, delivered, retransmitted, duplicates;
+
+  /* The ->last_rssi and ->last_lqi fields hold the Received Signal
+     Strength Indicator (RSSI) and CC2420 Link Quality Indicator (LQI)
+     values that are received for the incoming broadcast packets. */
+  uint16_t last_rssi, last_lqi;
+
+  /* Sensor readings data for this node */
+
+  char temperature[8]; //unit in Deg. Celsius
+  char humidity[8];    //unit in %RH (0%-100%)
+  char PM25[8];        //unit in ppm, compute to microgram per m3 at processing server
+  char CO[8];          //unitless (ratio in milli scale), compute to ppm at processing server
+  char CO2[8];         //unitless (ratio in milli scale), compute to ppm at processing server
+  char O3[8];          //unitless (ratio in milli scale), compute to ppm at processing server
+  char windSpeed[8];   //unit in m/s
+  char windDir[8];     //may be N, S, E, W and their combinations (NW, NE, SW, SE)
+};
+/*---------------------------------------------------------------------------*/
+//empties the table
+void
+sensor_node_table_init(void);
+
+//returns the entry of the node with the given address, NULL if unknown;
+//marks the node as heard from
+struct sensor_node *
+sensor_node_table_find(const linkaddr_t *addr);
+
+//returns the entry of the node with the given address, adding it (with
+//cleared readings) if unknown; marks the node as heard from
+struct sensor_node *
+sensor_node_table_add(const linkaddr_t *addr);
+
+//forgets the node with the given address, returns nonzero if it was known
+int
+sensor_node_table_remove(const linkaddr_t *addr);
+
+//amount of nodes in the table
+int
+sensor_node_table_count(void);
+
+//position of the node in the table, stable while it is known; the sink
+//uses it as the node's reply slot
+int
+sensor_node_table_slot(const struct sensor_node *n);
+
+//iterates the table: pass NULL for the first node, then the previous node;
+//returns NULL after the last one
+struct sensor_node *
+sensor_node_table_next(struct sensor_node *n);
+/*---------------------------------------------------------------------------*/
+#endif /* SENSOR_NODE_TABLE_H_ */
@@ -0,0 +1,100 @@
+/**
+ * \file
+ *         Binary reading records of the sink, see sink-records.h
+ */
+#include <stdio.h>
+
+#include "lib/crc16.h"
+#include "sink-records.h"
+/*---------------------------------------------------------------------------*/
+/* SLIP special characters (RFC 1055) */
+#define SLIP_END                     0300
+#define SLIP_ESC                     0333
+#define SLIP_ESC_END                 0334
+#define SLIP_ESC_ESC                 0335
+/*---------------------------------------------------------------------------*/
+static void
+write_escaped(uint8_t b)
+{
+	if(b == SLIP_END) {
+		putchar(SLIP_ESC);
+		b = SLIP_ESC_END;
+	}
+	else if(b == SLIP_ESC) {
+		putchar(SLIP_ESC);
+		b = SLIP_ESC_ESC;
+	}
+	putchar(b);
+}
+/*---------------------------------------------------------------------------*/
+/* Value of the given type in the readings, in their own unit */
+static int32_t
+reading_value(const struct readings_message *readings, uint8_t type)
+{
+	switch(type) {
+	case TEMPERATURE_T:
+		return readings->temperature;
+	case HUMIDITY_T:
+		return readings->humidity;
+	case PM25_T:
+		return readings->PM25;
+	case CO_T:
+		return (int32_t)readings->CO;
+	case CO2_T:
+		return (int32_t)readings->CO2;
+	case O3_T:
+		return (int32_t)readings->O3;
+	case WIND_SPEED_T:
+		return readings->windSpeed;
+	default:
+		return readings->windDir;
+	}
+}
+/*---------------------------------------------------------------------------*/
+void
+sink_records_send(const linkaddr_t *from, int16_t rssi, uint8_t lqi,
+	const struct readings_message *readings)
+{
+	uint8_t frame[SINK_RECORD_MAX_SIZE];
+	uint16_t crc;
+	int32_t value;
+	uint8_t type;
+	int len = SINK_RECORD_HEADER_SIZE;
+	int i;
+
+	if(!SINK_RECORDS_ENABLED) {
+		return;
+	}
+	frame[0] = '!';
+	frame[1] = 'R';
+	frame[2] = SINK_RECORD_VERSION;
+	frame[3] = from->u8[0];
+	frame[4] = from->u8[1];
+	frame[5] = (uint16_t)rssi & 0xFF;
+	frame[6] = (uint16_t)rssi >> 8;
+	frame[7] = lqi;
+	frame[8] = readings->round;
+	frame[9] = 0;
+	for(type = TEMPERATURE_T; type <= WIND_DRCTN_T; type++) {
+		if(!(readings->valid & READING_VALID(type))) {
+			continue;
+		}
+		value = reading_value(readings, type);
+		frame[len++] = type;
+		for(i = 0; i < 4; i++) {
+			frame[len++] = ((uint32_t)value >> (8 * i)) & 0xFF;
+		}
+		frame[9]++;
+	}
+	crc = crc16_data(frame, len, 0);
+	frame[len++] = crc & 0xFF;
+	frame[len++] = crc >> 8;
+
+	//the leading END ends any line noise the host has buffered
+	putchar(SLIP_END);
+	for(i = 0; i < len; i++) {
+		write_escaped(frame[i]);
+	}
+	putchar(SLIP_END);
+}
+/*---------------------------------------------------------------------------*/
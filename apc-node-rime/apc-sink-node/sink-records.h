@@ -0,0 +1,44 @@
+#ifndef SINK_RECORDS_H_
+#define SINK_RECORDS_H_
+/*---------------------------------------------------------------------------*/
+/* Binary records of the readings the sink receives, written to its UART as
+ * they arrive for a host collector (MQTT-Server/rime_collector.py).
+ *
+ * Every record is one SLIP-framed '!R' frame: END, the escaped record, END.
+ * The debug text of the sink never contains END, so the host skips it as
+ * frames that do not start with '!R'.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+#include "net/linkaddr.h"
+
+#include "../apc-request.h"
+/*---------------------------------------------------------------------------*/
+/* Nonzero to write a record for every DATA_READINGS received */
+#ifdef SINK_RECORDS_CONF_ENABLED
+#define SINK_RECORDS_ENABLED         SINK_RECORDS_CONF_ENABLED
+#else
+#define SINK_RECORDS_ENABLED         1
+#endif
+/*---------------------------------------------------------------------------*/
+/* '!R' record, little endian:
+ * '!' 'R' version(1) addr(2) rssi(2, signed) lqi(1) round(1) count(1)
+ * count x { type(1) value(4, signed) } crc(2)
+ * addr is u8[0] then u8[1]. Each value is a valid reading of the node, type
+ * is its sensor type (TEMPERATURE_T to WIND_DRCTN_T) and the value is in
+ * the unit of struct readings_message. crc is crc16_data() (lib/crc16.h,
+ * initial value 0) over everything before it.
+ */
+#define SINK_RECORD_VERSION          1
+#define SINK_RECORD_HEADER_SIZE      10
+#define SINK_RECORD_VALUE_SIZE       5
+#define SINK_RECORD_MAX_SIZE \
+  (SINK_RECORD_HEADER_SIZE + (WIND_DRCTN_T - TEMPERATURE_T + 1) * SINK_RECORD_VALUE_SIZE + 2)
+/*---------------------------------------------------------------------------*/
+//writes the record of the readings received from the given node, with the
+//RSSI and LQI of their frame
+void
+sink_records_send(const linkaddr_t *from, int16_t rssi, uint8_t lqi,
+	const struct readings_message *readings);
+/*---------------------------------------------------------------------------*/
+#endif /* SINK_RECORDS_H_ */
@@ -0,0 +1,10 @@
+#ifndef CONTIKI_H_
+#define CONTIKI_H_
+/* Host stand-in for contiki.h, only what sensor-node-table.c needs */
+#include <stdint.h>
+#ifdef PROJECT_CONF_H
+#include PROJECT_CONF_H
+#endif
+/* seconds of the bench's virtual clock, see sink-table-bench.c */
+unsigned long clock_seconds(void);
+#endif /* CONTIKI_H_ */
@@ -0,0 +1,24 @@
+#ifndef LINKADDR_H_
+#define LINKADDR_H_
+/* Host stand-in for core/net/linkaddr.h with Rime's 2-byte addresses */
+#include <string.h>
+
+#define LINKADDR_SIZE 2
+
+typedef union {
+  unsigned char u8[LINKADDR_SIZE];
+  uint16_t u16;
+} linkaddr_t;
+
+static inline int
+linkaddr_cmp(const linkaddr_t *addr1, const linkaddr_t *addr2)
+{
+  return memcmp(addr1, addr2, LINKADDR_SIZE) == 0;
+}
+
+static inline void
+linkaddr_copy(linkaddr_t *dest, const linkaddr_t *src)
+{
+  memcpy(dest, src, LINKADDR_SIZE);
+}
+#endif /* LINKADDR_H_ */
@@ -0,0 +1,289 @@
+/*
+* Host benchmark for the sink's sensor node table (sensor-node-table.c).
+*
+* The table source is built unchanged, with the size from the sink's
+* project-conf.h. The bench first checks it against a plain array under
+* random adds, removals and evictions, then reports the host time of one
+* reading update (lookup by address and copy of the value) as the node count
+* grows. The list walk the sink used before, calling list_length() on every
+* step, runs the same workload for comparison.
+*
+* Usage: sink-table-bench [-n updates] [-s seed]
+*/
+/* C std libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+/* Table under test */
+#include "sensor-node-table.h"
+/*---------------------------------------------------------------------------*/
+#define DEFAULT_UPDATES              1000000
+#define DEFAULT_SEED                 1
+#define CHECK_STEPS                  200000
+#define MAX_NODES                    (2 * SENSOR_NODE_TABLE_SIZE)
+/*---------------------------------------------------------------------------*/
+/* The former Contiki LIST of the sink, with its lookup loop */
+struct list_node {
+	struct list_node *next;
+	struct sensor_node node;
+};
+/*---------------------------------------------------------------------------*/
+static unsigned long seconds;
+static linkaddr_t addrs[MAX_NODES];
+static struct list_node list_nodes[MAX_NODES];
+static struct list_node *list_head;
+/*---------------------------------------------------------------------------*/
+unsigned long
+clock_seconds(void)
+{
+	return seconds;
+}
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+/* Distinct random Rime addresses */
+static void
+make_addrs(void)
+{
+	int i, j;
+
+	for(i = 0; i < MAX_NODES; i++) {
+		do {
+			addrs[i].u8[0] = rand() & 0xff;
+			addrs[i].u8[1] = rand() & 0xff;
+			for(j = 0; j < i && !linkaddr_cmp(&addrs[i], &addrs[j]); j++);
+		} while(j < i);
+	}
+}
+/*---------------------------------------------------------------------------*/
+static int
+list_length(void)
+{
+	struct list_node *l;
+	int length = 0;
+
+	for(l = list_head; l != NULL; l = l->next) {
+		length++;
+	}
+	return length;
+}
+/*---------------------------------------------------------------------------*/
+static struct sensor_node *
+list_find(const linkaddr_t *addr)
+{
+	struct list_node *l = list_head;
+	int i;
+
+	for(i = 0; i < list_length(); i++) {
+		if(linkaddr_cmp(&l->node.addr, addr)) {
+			return &l->node;
+		}
+		l = l->next;
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+list_fill(int nodes)
+{
+	int i;
+
+	list_head = NULL;
+	for(i = 0; i < nodes; i++) {
+		linkaddr_copy(&list_nodes[i].node.addr, &addrs[i]);
+		list_nodes[i].next = list_head;
+		list_head = &list_nodes[i];
+	}
+}
+/*---------------------------------------------------------------------------*/
+/* Random adds, removals and lookups, compared with a plain array of the
+ * nodes the table should hold */
+static int
+check_table(void)
+{
+	static unsigned long heard[MAX_NODES];
+	static uint8_t held[MAX_NODES];
+	struct sensor_node *n;
+	int held_count = 0;
+	int step, i, j, oldest;
+
+	sensor_node_table_init();
+	memset(held, 0, sizeof(held));
+	for(step = 0; step < CHECK_STEPS; step++) {
+		i = rand() % MAX_NODES;
+		seconds++;
+		switch(rand() % 4) {
+		case 0:
+			if(sensor_node_table_remove(&addrs[i]) != held[i]) {
+				printf("check: remove %d.%d disagrees\n", addrs[i].u8[0], addrs[i].u8[1]);
+				return 0;
+			}
+			held_count -= held[i];
+			held[i] = 0;
+			break;
+		case 1:
+			//a full table drops the node silent the longest
+			if(!held[i] && held_count == SENSOR_NODE_TABLE_SIZE) {
+				oldest = -1;
+				for(j = 0; j < MAX_NODES; j++) {
+					if(held[j] && (oldest < 0 || heard[j] < heard[oldest])) {
+						oldest = j;
+					}
+				}
+				held[oldest] = 0;
+				held_count--;
+			}
+			n = sensor_node_table_add(&addrs[i]);
+			if(n == NULL || !linkaddr_cmp(&n->addr, &addrs[i])) {
+				printf("check: add %d.%d failed\n", addrs[i].u8[0], addrs[i].u8[1]);
+				return 0;
+			}
+			held_count += !held[i];
+			held[i] = 1;
+			heard[i] = seconds;
+			break;
+		default:
+			n = sensor_node_table_find(&addrs[i]);
+			if((n != NULL) != held[i] || (n != NULL && !linkaddr_cmp(&n->addr, &addrs[i]))) {
+				printf("check: find %d.%d disagrees\n", addrs[i].u8[0], addrs[i].u8[1]);
+				return 0;
+			}
+			if(n != NULL) {
+				heard[i] = seconds;
+			}
+			break;
+		}
+		if(sensor_node_table_count() != held_count) {
+			printf("check: %d nodes in the table, expected %d\n",
+				sensor_node_table_count(), held_count);
+			return 0;
+		}
+	}
+	//a full table must evict the node silent the longest
+	sensor_node_table_init();
+	for(i = 0; i < SENSOR_NODE_TABLE_SIZE; i++) {
+		seconds++;
+		sensor_node_table_add(&addrs[i]);
+	}
+	seconds++;
+	sensor_node_table_find(&addrs[0]);
+	sensor_node_table_add(&addrs[SENSOR_NODE_TABLE_SIZE]);
+	if(SENSOR_NODE_TABLE_SIZE > 1 && (sensor_node_table_find(&addrs[0]) == NULL ||
+		sensor_node_table_find(&addrs[1]) != NULL)) {
+		printf("check: eviction did not pick the least recently seen node\n");
+		return 0;
+	}
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Host ns per reading update over the given nodes */
+static double
+bench_updates(struct sensor_node *(*find)(const linkaddr_t *),
+	const uint16_t *order, long updates)
+{
+	struct sensor_node *n;
+	uint64_t start = now_ns();
+	long u;
+
+	for(u = 0; u < updates; u++) {
+		n = find(&addrs[order[u]]);
+		if(n == NULL) {
+			printf("bench: node %u missing\n", order[u]);
+			exit(EXIT_FAILURE);
+		}
+		strcpy(n->temperature, "24.5");
+	}
+	return (double)(now_ns() - start) / updates;
+}
+/*---------------------------------------------------------------------------*/
+/* Host ns per add when every add evicts, nodes come back round robin */
+static double
+bench_evictions(long updates)
+{
+	uint64_t start;
+	long u;
+
+	sensor_node_table_init();
+	start = now_ns();
+	for(u = 0; u < updates; u++) {
+		seconds++;
+		strcpy(sensor_node_table_add(&addrs[u % MAX_NODES])->temperature, "24.5");
+	}
+	return (double)(now_ns() - start) / updates;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+	static const int node_counts[] = { 3, 8, 16, 32, 64, 127 };
+	uint16_t *order;
+	long updates = DEFAULT_UPDATES;
+	unsigned seed = DEFAULT_SEED;
+	long u;
+	int opt, c, i, nodes;
+
+	while((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch(opt) {
+		case 'n':
+			updates = atol(optarg);
+			break;
+		case 's':
+			seed = (unsigned)atol(optarg);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n updates] [-s seed]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if(updates <= 0) {
+		fprintf(stderr, "updates must be positive\n");
+		return EXIT_FAILURE;
+	}
+	srand(seed);
+	make_addrs();
+
+	if(!check_table()) {
+		return EXIT_FAILURE;
+	}
+	printf("table of %d nodes: add/find/remove/evict checks passed\n\n",
+		SENSOR_NODE_TABLE_SIZE);
+
+	order = malloc(updates * sizeof(*order));
+	if(order == NULL) {
+		perror("malloc");
+		return EXIT_FAILURE;
+	}
+	printf("%6s %14s %14s %9s\n", "nodes", "table ns/upd", "list ns/upd", "speedup");
+	for(c = 0; c < (int)(sizeof(node_counts) / sizeof(node_counts[0])); c++) {
+		double table_ns, list_ns;
+
+		nodes = node_counts[c];
+		if(nodes > SENSOR_NODE_TABLE_SIZE) {
+			break;
+		}
+		sensor_node_table_init();
+		for(i = 0; i < nodes; i++) {
+			sensor_node_table_add(&addrs[i]);
+		}
+		list_fill(nodes);
+		for(u = 0; u < updates; u++) {
+			order[u] = rand() % nodes;
+		}
+		table_ns = bench_updates(sensor_node_table_find, order, updates);
+		list_ns = bench_updates(list_find, order, updates);
+		printf("%6d %14.1f %14.1f %8.1fx\n", nodes, table_ns, list_ns, list_ns / table_ns);
+	}
+	printf("\n%d nodes cycling through a table of %d (every add evicts): %.1f ns/add\n",
+		MAX_NODES, SENSOR_NODE_TABLE_SIZE, bench_evictions(updates));
+	free(order);
+	return EXIT_SUCCESS;
+}
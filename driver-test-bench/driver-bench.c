@@ -0,0 +1,442 @@
+/*
+* Host test bench for the drivers in place-in-zoul-dev-folder.
+*
+* The unchanged driver sources are built against the register mocks in mock/
+* and fed by the device models in sensor-models.c. Every case checks what the
+* driver decodes and reports what one call costs: time the mote spends inside
+* the call (virtual), register accesses, and host time per call.
+*
+* Usage: driver-bench [-n reps] [-o delay overhead ns] [-w edges file [-e temp,hum]]
+*/
+/* C std libraries */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+/* Drivers under test */
+#include "contiki.h"
+#include "dht22.h"
+#include "dev/adc128s022.h"
+#include "dev/pm25-sensor.h"
+/* Project Sourcefiles */
+#include "sensor-models.h"
+/*---------------------------------------------------------------------------*/
+#define DEFAULT_REPS                 100
+/* Assumed cost of one clock_delay_usec() call on the cc2538 beyond the delay
+ * itself, it sets how many polls fit in a DHT22 pulse. Check the sweep below
+ * for the range the decoding tolerates. */
+#define DEFAULT_DELAY_OVERHEAD_NS    4000
+#define SWEEP_STEP_NS                250
+#define SWEEP_MAX_NS                 12000
+/* the driver truncates its mV to ug/m3 factor (172 instead of 172.4) */
+#define PM25_TOLERANCE               2      /* ug/m3 */
+#define EXPECT_ERROR                 (-1)
+#define SWEEP_DELAY_OVERHEAD         ((size_t)-1)
+/*---------------------------------------------------------------------------*/
+typedef struct {
+	const char *name;
+	int temperature;          //tenths of degC, as sent by the sensor
+	int humidity;             //tenths of %RH
+	int8_t checksum_error;
+	uint8_t silent;
+	dht22_timing_t timing;
+	int expect_temperature;   //EXPECT_ERROR: the read must fail
+	int expect_humidity;
+} dht22_case_t;
+/*---------------------------------------------------------------------------*/
+typedef struct {
+	const char *name;
+	uint32_t output_mv;
+	int expect;               //ug/m3
+} pm25_case_t;
+/*---------------------------------------------------------------------------*/
+typedef struct {
+	uint64_t target_ns;
+	uint64_t host_ns;
+	mock_hw_counters_t counters;
+} call_cost_t;
+/*---------------------------------------------------------------------------*/
+static int reps = DEFAULT_REPS;
+static int failures;
+/*---------------------------------------------------------------------------*/
+static dht22_model_t dht22_model;
+static mock_pin_model_t dht22_pin;
+static adc128s022_model_t adc_model;
+static mock_spi_model_t adc_spi;
+static pm25_model_t pm25_model;
+static mock_pin_model_t pm25_led_pin;
+/*---------------------------------------------------------------------------*/
+static uint64_t
+host_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+/* Wire the models to the pins and bus the drivers are configured for */
+static void
+attach_models(void)
+{
+	mock_hw_reset();
+
+	dht22_pin = dht22_pin_model;
+	dht22_pin.ctx = &dht22_model;
+	mock_gpio_attach(DHT22_PORT, DHT22_PIN, &dht22_pin);
+
+	adc128s022_model_init(&adc_model);
+	adc_spi = adc128s022_spi_model;
+	adc_spi.ctx = &adc_model;
+	mock_spi_attach(ADC128S022_SPI_INSTANCE, ADC128S022_CSN_PORT, ADC128S022_CSN_PIN, &adc_spi);
+
+	pm25_led_pin = pm25_led_pin_model;
+	pm25_led_pin.ctx = &pm25_model;
+	mock_gpio_attach(PM25_SENSOR_LED_CTRL_PORT, PM25_SENSOR_LED_CTRL_PIN, &pm25_led_pin);
+	adc_model.input[PM25_SENSOR_OUT_EXT_ADC_CHANNEL] = pm25_model_adc_input;
+	adc_model.input_ctx[PM25_SENSOR_OUT_EXT_ADC_CHANNEL] = &pm25_model;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_header(const char *driver)
+{
+	printf("\n%-8s %-26s %-6s %-22s %10s %7s %6s %6s %10s\n", driver, "case", "result",
+			"decoded", "target us", "gpio rd", "rtimer", "spi B", "host ns");
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_row(const char *driver, const char *name, int pass, const char *decoded,
+		const call_cost_t *cost)
+{
+	printf("%-8s %-26s %-6s %-22s %10.1f %7u %6u %6u %10llu\n", driver, name,
+			pass ? "PASS" : "FAIL", decoded, cost->target_ns / 1000.0,
+			cost->counters.gpio_reads, cost->counters.rtimer_reads, cost->counters.spi_bytes,
+			(unsigned long long)cost->host_ns);
+	if (!pass)
+		failures++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+dht22_bytes(const dht22_case_t *c, uint8_t *bytes)
+{
+	uint16_t temperature = c->temperature < 0 ? (0x8000 | -c->temperature) : c->temperature;
+
+	bytes[0] = c->humidity >> 8;
+	bytes[1] = c->humidity & 0xFF;
+	bytes[2] = temperature >> 8;
+	bytes[3] = temperature & 0xFF;
+	bytes[4] = (bytes[0] + bytes[1] + bytes[2] + bytes[3] + c->checksum_error) & 0xFF;
+}
+/*---------------------------------------------------------------------------*/
+/* One dht22_read_all(), the first call also fills cost */
+static int
+dht22_read_once(int *temperature, int *humidity, call_cost_t *cost)
+{
+	uint64_t t0 = mock_hw_now_ns();
+	int res;
+
+	mock_hw_reset_counters();
+	res = dht22_read_all(temperature, humidity);
+	if (cost != NULL) {
+		cost->target_ns = mock_hw_now_ns() - t0;
+		cost->counters = mock_hw_counters;
+	}
+	return res;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dht22_check(int res, int temperature, int humidity, int expect_temperature, int expect_humidity)
+{
+	if (expect_temperature == EXPECT_ERROR)
+		return res == DHT22_ERROR;
+	return res == DHT22_SUCCESS && temperature == expect_temperature && humidity == expect_humidity;
+}
+/*---------------------------------------------------------------------------*/
+static void
+dht22_run(const char *name, int expect_temperature, int expect_humidity)
+{
+	int temperature = 0, humidity = 0, res = DHT22_ERROR, pass = 1;
+	char decoded[32];
+	call_cost_t cost;
+	uint64_t t0;
+
+	dht22_model.start_pulses = 0;
+	res = dht22_read_once(&temperature, &humidity, &cost);
+	pass = dht22_check(res, temperature, humidity, expect_temperature, expect_humidity);
+	t0 = host_now_ns();
+	for (int i = 0; i < reps; i++) {
+		int t = 0, h = 0;
+		int r = dht22_read_once(&t, &h, NULL);
+		pass &= dht22_check(r, t, h, expect_temperature, expect_humidity);
+	}
+	cost.host_ns = (host_now_ns() - t0) / reps;
+
+	if (res == DHT22_SUCCESS)
+		snprintf(decoded, sizeof(decoded), "T %d H %d", temperature, humidity);
+	else
+		snprintf(decoded, sizeof(decoded), "error");
+	if (dht22_model.start_pulses == 0)
+		snprintf(decoded, sizeof(decoded), "no start signal");
+	print_row("dht22", name, pass, decoded, &cost);
+}
+/*---------------------------------------------------------------------------*/
+static void
+dht22_run_case(const dht22_case_t *c)
+{
+	uint8_t bytes[DHT22_BUFFER];
+
+	if (c->silent) {
+		dht22_model_silent(&dht22_model);
+	} else {
+		dht22_bytes(c, bytes);
+		dht22_model_from_bytes(&dht22_model, bytes, &c->timing);
+	}
+	dht22_run(c->name, c->expect_temperature, c->expect_humidity);
+}
+/*---------------------------------------------------------------------------*/
+/* Range of a timing parameter over which a reading still decodes,
+ * field is a dht22_timing_t member offset or SWEEP_DELAY_OVERHEAD */
+static void
+dht22_sweep(const char *label, const dht22_case_t *c, size_t field, uint32_t step,
+		uint32_t max, const char *unit)
+{
+	uint8_t bytes[DHT22_BUFFER];
+	dht22_timing_t timing = c->timing;
+	uint32_t saved_overhead = mock_delay_overhead_ns, lo = 0, hi = 0;
+	uint32_t *param = field == SWEEP_DELAY_OVERHEAD ?
+			&mock_delay_overhead_ns : (uint32_t *)((uint8_t *)&timing + field);
+	uint8_t found = 0;
+
+	dht22_bytes(c, bytes);
+	for (uint32_t v = 0; v <= max; v += step) {
+		int t = 0, h = 0, r;
+		*param = v;
+		dht22_model_from_bytes(&dht22_model, bytes, &timing);
+		r = dht22_read_once(&t, &h, NULL);
+		if (dht22_check(r, t, h, c->expect_temperature, c->expect_humidity)) {
+			if (!found)
+				lo = v;
+			hi = v;
+			found = 1;
+		}
+	}
+	mock_delay_overhead_ns = saved_overhead;
+	if (found)
+		printf("dht22    %-26s decodes from %u to %u %s\n", label, lo, hi, unit);
+	else
+		printf("dht22    %-26s never decodes\n", label);
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_dht22(const char *edges_file, int expect_temperature, int expect_humidity)
+{
+	static dht22_case_t cases[] = {
+		{ "23.4C 56.7%RH", 234, 567, 0, 0, {0}, 234, 567 },
+		{ "0.0C 0.0%RH (all zeros)", 0, 0, 0, 0, {0}, 0, 0 },
+		{ "80.0C 99.9%RH", 800, 999, 0, 0, {0}, 800, 999 },
+		{ "-10.1C 45.0%RH", -101, 450, 0, 0, {0}, -101, 450 },
+		{ "10% timing jitter", 251, 603, 0, 0, {0}, 251, 603 },
+		{ "bad checksum", 234, 567, 1, 0, {0}, EXPECT_ERROR, 0 },
+		{ "no response", 0, 0, 0, 1, {0}, EXPECT_ERROR, 0 },
+	};
+	const dht22_case_t *reference = &cases[0];
+
+	print_header("dht22");
+	for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		cases[i].timing = dht22_timing_datasheet;
+		if (strstr(cases[i].name, "jitter") != NULL)
+			cases[i].timing.jitter_pct = 10;
+		srand(1);
+		dht22_run_case(&cases[i]);
+	}
+	if (edges_file != NULL) {
+		if (dht22_model_load(&dht22_model, edges_file) != 0) {
+			printf("dht22    %s: cannot read edges\n", edges_file);
+			failures++;
+		} else if (expect_temperature == EXPECT_ERROR) {
+			//no expectation given: just show what the driver makes of it
+			int t = 0, h = 0;
+			call_cost_t cost;
+			int res = dht22_read_once(&t, &h, &cost);
+			printf("dht22    %-26s %s T %d H %d\n", "recorded", res == DHT22_SUCCESS ? "ok" : "error", t, h);
+		} else {
+			dht22_run("recorded", expect_temperature, expect_humidity);
+		}
+	}
+
+	printf("\n");
+	dht22_sweep("delay overhead", reference, SWEEP_DELAY_OVERHEAD, SWEEP_STEP_NS,
+			SWEEP_MAX_NS, "ns");
+	dht22_sweep("response delay", reference, offsetof(dht22_timing_t, response_delay),
+			1, 200, "us");
+	dht22_sweep("'1' high time", reference, offsetof(dht22_timing_t, one_high), 1, 120, "us");
+	dht22_sweep("'0' high time", reference, offsetof(dht22_timing_t, zero_high), 1, 120, "us");
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_adc128s022(void)
+{
+	static const uint16_t codes[ADC128S022_MODEL_CHANNELS] = {
+		0x000, 0xFFF, 0x800, 0x555, 0xAAA, 0x000, 0x001, 0x7FE
+	};
+	//interleaved so that every read follows a different channel
+	static const uint8_t order[] = { 7, 0, 3, 1, 6, 2, 4, 0, 0, 7 };
+	char decoded[32];
+	call_cost_t cost;
+	uint64_t t0;
+	int pass;
+
+	print_header("adc");
+	for (int ch = 0; ch < ADC128S022_MODEL_CHANNELS; ch++) {
+		if (ch == PM25_SENSOR_OUT_EXT_ADC_CHANNEL)
+			continue;
+		adc_model.codes[ch] = codes[ch];
+		adc128s022.configure(ADC128S022_INIT, ch);
+	}
+
+	for (int i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+		int ch = order[i], value;
+		char name[32];
+
+		t0 = mock_hw_now_ns();
+		mock_hw_reset_counters();
+		value = adc128s022.value(ch);
+		cost.target_ns = mock_hw_now_ns() - t0;
+		cost.counters = mock_hw_counters;
+		pass = value == codes[ch];
+
+		t0 = host_now_ns();
+		for (int r = 0; r < reps; r++) {
+			pass &= adc128s022.value(ch) == codes[ch];
+		}
+		cost.host_ns = (host_now_ns() - t0) / reps;
+
+		snprintf(name, sizeof(name), "channel %d", ch);
+		snprintf(decoded, sizeof(decoded), "0x%03x (0x%03x)", value, codes[ch]);
+		print_row("adc", name, pass, decoded, &cost);
+	}
+
+	//the same reads in one transaction
+	{
+		uint16_t values[sizeof(order)];
+		int mismatch = -1;
+		char name[32];
+
+		t0 = mock_hw_now_ns();
+		mock_hw_reset_counters();
+		pass = adc128s022_read_burst(order, sizeof(order), values) == ADC128S022_SUCCESS;
+		cost.target_ns = mock_hw_now_ns() - t0;
+		cost.counters = mock_hw_counters;
+		for (int i = 0; i < sizeof(order); i++) {
+			if (values[i] != codes[order[i]] && mismatch < 0)
+				mismatch = i;
+		}
+		pass &= mismatch < 0;
+
+		t0 = host_now_ns();
+		for (int r = 0; r < reps; r++) {
+			pass &= adc128s022_read_burst(order, sizeof(order), values) == ADC128S022_SUCCESS &&
+					values[sizeof(order) - 1] == codes[order[sizeof(order) - 1]];
+		}
+		cost.host_ns = (host_now_ns() - t0) / reps;
+
+		snprintf(name, sizeof(name), "burst of %d", (int)sizeof(order));
+		if (mismatch < 0)
+			snprintf(decoded, sizeof(decoded), "all match");
+		else
+			snprintf(decoded, sizeof(decoded), "#%d 0x%03x (0x%03x)", mismatch, values[mismatch],
+					codes[order[mismatch]]);
+		print_row("adc", name, pass, decoded, &cost);
+	}
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_pm25(void)
+{
+	static const pm25_case_t cases[] = {
+		{ "0 ug/m3", 600, 0 },
+		{ "50 ug/m3", 890, 50 },
+		{ "100 ug/m3", 1180, 100 },
+		{ "250 ug/m3", 2050, 250 },
+		{ "400 ug/m3", 2920, 400 },
+		{ "500 ug/m3", 3500, 500 },
+		{ "below range (300 mV)", 300, 0 },
+		{ "above range (4000 mV)", 4000, 500 },
+	};
+	char decoded[32];
+	call_cost_t cost;
+	uint64_t t0;
+
+	print_header("pm25");
+	pm25.configure(SENSORS_ACTIVE, PM25_ENABLE);
+	for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		int value, pass;
+
+		pm25_model_init(&pm25_model, cases[i].output_mv);
+		t0 = mock_hw_now_ns();
+		mock_hw_reset_counters();
+		value = pm25.value(0);
+		cost.target_ns = mock_hw_now_ns() - t0;
+		cost.counters = mock_hw_counters;
+		pass = abs(value - cases[i].expect) <= PM25_TOLERANCE;
+
+		t0 = host_now_ns();
+		for (int r = 0; r < reps; r++) {
+			pass &= abs(pm25.value(0) - cases[i].expect) <= PM25_TOLERANCE;
+		}
+		cost.host_ns = (host_now_ns() - t0) / reps;
+
+		snprintf(decoded, sizeof(decoded), "%d (%d)", value, cases[i].expect);
+		print_row("pm25", cases[i].name, pass, decoded, &cost);
+	}
+	//GP2Y1014AU0F: sample 280 us into a 320 us LED pulse
+	printf("\npm25     LED on to ADC sample %.1f us, LED pulse %.1f us\n",
+			pm25_model.sample_delay_ns / 1000.0, pm25_model.pulse_ns / 1000.0);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+	const char *edges_file = NULL;
+	int expect_temperature = EXPECT_ERROR, expect_humidity = 0;
+	int opt;
+
+	mock_delay_overhead_ns = DEFAULT_DELAY_OVERHEAD_NS;
+	while ((opt = getopt(argc, argv, "n:o:w:e:")) != -1) {
+		switch (opt) {
+		case 'n':
+			reps = atoi(optarg) > 0 ? atoi(optarg) : 1;
+			break;
+		case 'o':
+			mock_delay_overhead_ns = atoi(optarg);
+			break;
+		case 'w':
+			edges_file = optarg;
+			break;
+		case 'e':
+			if (sscanf(optarg, "%d,%d", &expect_temperature, &expect_humidity) != 2) {
+				fprintf(stderr, "-e expects <temp>,<hum> in tenths\n");
+				return 2;
+			}
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n reps] [-o delay overhead ns] [-w edges file [-e temp,hum]]\n",
+					argv[0]);
+			return 2;
+		}
+	}
+
+	attach_models();
+	SENSORS_ACTIVATE(dht22);
+	printf("clock_delay_usec overhead %u ns, %d reps per case\n", mock_delay_overhead_ns, reps);
+
+	bench_dht22(edges_file, expect_temperature, expect_humidity);
+	bench_adc128s022();
+	bench_pm25();
+
+	printf("\n%d failure(s)\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,223 @@
+/* C std libraries */
+#include <stdio.h>
+#include <string.h>
+/* Project Sourcefiles */
+#include "mock-hw.h"
+/*---------------------------------------------------------------------------*/
+#define NS_PER_RTIMER_TICK           (1000000000ULL / RTIMER_SECOND)
+#define MOCK_SPI_DEVICE_COUNT        4
+/*---------------------------------------------------------------------------*/
+typedef struct {
+	uint8_t dir;    //1: output
+	uint8_t out;    //output data register
+	const mock_pin_model_t *model[MOCK_GPIO_PIN_COUNT];
+} mock_gpio_port_t;
+/*---------------------------------------------------------------------------*/
+typedef struct {
+	int instance;
+	int cs_port;
+	int cs_pin;
+	const mock_spi_model_t *model;
+} mock_spi_device_t;
+/*---------------------------------------------------------------------------*/
+mock_hw_counters_t mock_hw_counters;
+uint32_t mock_delay_overhead_ns;
+uint32_t mock_spi_dr[SSI_INSTANCE_COUNT];
+/*---------------------------------------------------------------------------*/
+static uint64_t now_ns;
+static mock_gpio_port_t ports[MOCK_GPIO_PORT_COUNT];
+static mock_spi_device_t spi_devices[MOCK_SPI_DEVICE_COUNT];
+static int spi_device_count;
+static const mock_spi_device_t *spi_selected[SSI_INSTANCE_COUNT];
+static uint32_t spi_freq[SSI_INSTANCE_COUNT];
+/*---------------------------------------------------------------------------*/
+void
+mock_hw_reset(void)
+{
+	now_ns = 0;
+	memset(ports, 0, sizeof(ports));
+	memset(spi_devices, 0, sizeof(spi_devices));
+	memset(spi_selected, 0, sizeof(spi_selected));
+	memset(spi_freq, 0, sizeof(spi_freq));
+	memset(mock_spi_dr, 0, sizeof(mock_spi_dr));
+	spi_device_count = 0;
+	mock_hw_reset_counters();
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_hw_reset_counters(void)
+{
+	memset(&mock_hw_counters, 0, sizeof(mock_hw_counters));
+}
+/*---------------------------------------------------------------------------*/
+uint64_t
+mock_hw_now_ns(void)
+{
+	return now_ns;
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_hw_advance_ns(uint64_t ns)
+{
+	now_ns += ns;
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_gpio_attach(int port, int pin, const mock_pin_model_t *model)
+{
+	ports[port].model[pin] = model;
+}
+/*---------------------------------------------------------------------------*/
+static int
+line_level(int port, int pin)
+{
+	const mock_pin_model_t *model = ports[port].model[pin];
+
+	if (ports[port].dir & (1 << pin))
+		return (ports[port].out >> pin) & 1;
+	//nothing drives the line: pulled up
+	if (model == NULL || model->read == NULL)
+		return 1;
+	return model->read(model->ctx, now_ns);
+}
+/*---------------------------------------------------------------------------*/
+static void
+notify_drive(int port, uint8_t mask)
+{
+	for (int pin = 0; pin < MOCK_GPIO_PIN_COUNT; pin++) {
+		const mock_pin_model_t *model = ports[port].model[pin];
+		if ((mask & (1 << pin)) && (ports[port].dir & (1 << pin)) &&
+				model != NULL && model->drive != NULL) {
+			model->drive(model->ctx, (ports[port].out >> pin) & 1, now_ns);
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_gpio_set_dir(int port, uint8_t mask, int output)
+{
+	if (output)
+		ports[port].dir |= mask;
+	else
+		ports[port].dir &= ~mask;
+	mock_hw_counters.gpio_writes++;
+	notify_drive(port, mask);
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_gpio_write(int port, uint8_t mask, int level)
+{
+	if (level)
+		ports[port].out |= mask;
+	else
+		ports[port].out &= ~mask;
+	mock_hw_counters.gpio_writes++;
+	notify_drive(port, mask);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+mock_gpio_read(int port, uint8_t mask)
+{
+	uint8_t value = 0;
+
+	mock_hw_counters.gpio_reads++;
+	for (int pin = 0; pin < MOCK_GPIO_PIN_COUNT; pin++) {
+		if ((mask & (1 << pin)) && line_level(port, pin))
+			value |= 1 << pin;
+	}
+	return value;
+}
+/*---------------------------------------------------------------------------*/
+void
+ioc_set_over(uint8_t port, uint8_t pin, uint8_t over)
+{
+}
+/*---------------------------------------------------------------------------*/
+rtimer_clock_t
+mock_rtimer_now(void)
+{
+	//busy-waits poll the timer: let every poll take one tick so they end
+	mock_hw_counters.rtimer_reads++;
+	now_ns += NS_PER_RTIMER_TICK;
+	return (rtimer_clock_t)(now_ns / NS_PER_RTIMER_TICK);
+}
+/*---------------------------------------------------------------------------*/
+void
+clock_delay_usec(uint16_t dt)
+{
+	mock_hw_counters.delay_calls++;
+	now_ns += (uint64_t)dt * 1000 + mock_delay_overhead_ns;
+}
+/*---------------------------------------------------------------------------*/
+void
+watchdog_periodic(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_spi_attach(int instance, int cs_port, int cs_pin, const mock_spi_model_t *model)
+{
+	if (spi_device_count == MOCK_SPI_DEVICE_COUNT) {
+		printf("mock_hw: too many SPI devices\n");
+		return;
+	}
+	spi_devices[spi_device_count].instance = instance;
+	spi_devices[spi_device_count].cs_port = cs_port;
+	spi_devices[spi_device_count].cs_pin = cs_pin;
+	spi_devices[spi_device_count].model = model;
+	spi_device_count++;
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_spi_select(int port, int pin, int selected)
+{
+	for (int i = 0; i < spi_device_count; i++) {
+		const mock_spi_device_t *dev = &spi_devices[i];
+		if (dev->cs_port != port || dev->cs_pin != pin)
+			continue;
+		spi_selected[dev->instance] = selected ? dev : NULL;
+		if (dev->model->select != NULL)
+			dev->model->select(dev->model->ctx, selected, now_ns);
+	}
+	mock_hw_counters.gpio_writes++;
+}
+/*---------------------------------------------------------------------------*/
+void
+mock_spi_exchange(uint8_t spi)
+{
+	const mock_spi_device_t *dev = spi_selected[spi];
+	uint8_t tx = (uint8_t)mock_spi_dr[spi];
+
+	mock_hw_counters.spi_bytes++;
+	//the device sees the byte as it starts shifting
+	mock_spi_dr[spi] = dev != NULL ? dev->model->transfer(dev->model->ctx, tx, now_ns) : 0xFF;
+	if (spi_freq[spi] != 0)
+		now_ns += 8ULL * 1000000000ULL / spi_freq[spi];
+}
+/*---------------------------------------------------------------------------*/
+void
+spix_init(uint8_t spi)
+{
+}
+/*---------------------------------------------------------------------------*/
+void
+spix_enable(uint8_t spi)
+{
+}
+/*---------------------------------------------------------------------------*/
+void
+spix_disable(uint8_t spi)
+{
+}
+/*---------------------------------------------------------------------------*/
+void
+spix_set_clock_freq(uint8_t spi, uint32_t freq)
+{
+	spi_freq[spi] = freq;
+}
+/*---------------------------------------------------------------------------*/
+void
+spix_cs_init(uint8_t port, uint8_t pin)
+{
+}
+/*---------------------------------------------------------------------------*/
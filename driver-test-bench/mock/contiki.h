@@ -0,0 +1,8 @@
+#ifndef CONTIKI_H_
+#define CONTIKI_H_
+/* Host stand-in for contiki.h, see mock-hw.h */
+#include "mock-hw.h"
+#ifdef PROJECT_CONF_H
+#include PROJECT_CONF_H
+#endif
+#endif /* CONTIKI_H_ */
@@ -0,0 +1,2 @@
+/* The driver header under test, as installed in platform/zoul/dev */
+#include "../../../place-in-zoul-dev-folder/adc128s022.h"
@@ -0,0 +1,2 @@
+/* The driver header under test, as installed in platform/zoul/dev */
+#include "../../../place-in-zoul-dev-folder/pm25-sensor.h"
@@ -0,0 +1,43 @@
+#ifndef DHT22_H_
+#define DHT22_H_
+/*---------------------------------------------------------------------------*/
+/* Copy of the definitions in Contiki's platform/zoul/dev/dht22.h, which is not
+ * part of this repository but is included by the dht22.c under test.
+ */
+/*---------------------------------------------------------------------------*/
+#include "contiki.h"
+/*---------------------------------------------------------------------------*/
+#ifdef DHT22_CONF_PIN
+#define DHT22_PIN                   DHT22_CONF_PIN
+#else
+#define DHT22_PIN                   5
+#endif
+#ifdef DHT22_CONF_PORT
+#define DHT22_PORT                  DHT22_CONF_PORT
+#else
+#define DHT22_PORT                  GPIO_A_NUM
+#endif
+/*---------------------------------------------------------------------------*/
+#define DHT22_READ_HUM              0x01
+#define DHT22_READ_TEMP             0x02
+#define DHT22_READ_ALL              0x03
+/*---------------------------------------------------------------------------*/
+#define DHT22_ERROR                 (-1)
+#define DHT22_SUCCESS               0x00
+#define DHT22_BUSY                  0xFF
+/*---------------------------------------------------------------------------*/
+#define DHT22_BUFFER                5
+#define DHT22_COUNT                 8
+#define DHT22_MAX_TIMMING           85
+/*---------------------------------------------------------------------------*/
+#define DHT22_READING_DELAY         1
+#define DHT22_READY_TIME            20
+#define DHT22_START_TIME            (RTIMER_SECOND / 50)
+#define DHT22_AWAKE_TIME            (RTIMER_SECOND / 4)
+/*---------------------------------------------------------------------------*/
+#define DHT22_SENSOR                "DHT22 sensor"
+/*---------------------------------------------------------------------------*/
+extern const struct sensors_sensor dht22;
+int dht22_read_all(int *temperature, int *humidity);
+/*---------------------------------------------------------------------------*/
+#endif /* DHT22_H_ */
@@ -0,0 +1,130 @@
+#ifndef MOCK_HW_H_
+#define MOCK_HW_H_
+/*---------------------------------------------------------------------------*/
+/* Host stand-in for the cc2538 GPIO, sleep timer (rtimer) and SSI registers
+ * used by the drivers in place-in-zoul-dev-folder.
+ *
+ * Time is virtual (ns) and only moves when the driver waits: clock_delay_usec(),
+ * RTIMER_NOW() polling and SPI transfers. Sensor models attached to pins and to
+ * the SPI bus see that same clock, so recorded or synthetic waveforms replay
+ * deterministically regardless of host speed.
+ */
+/*---------------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#define MOCK_GPIO_PORT_COUNT         4
+#define MOCK_GPIO_PIN_COUNT          8
+/*---------------------------------------------------------------------------*/
+/* External device connected to a GPIO pin */
+typedef struct mock_pin_model {
+	//level the device puts on the line while the pin is an input
+	int (*read)(void *ctx, uint64_t now_ns);
+	//the mote drove the line (pin is an output)
+	void (*drive)(void *ctx, int level, uint64_t now_ns);
+	void *ctx;
+} mock_pin_model_t;
+/*---------------------------------------------------------------------------*/
+/* External device on the SSI bus */
+typedef struct mock_spi_model {
+	void (*select)(void *ctx, int selected, uint64_t now_ns);
+	//one full-duplex byte, returns the byte shifted in
+	uint8_t (*transfer)(void *ctx, uint8_t tx, uint64_t now_ns);
+	void *ctx;
+} mock_spi_model_t;
+/*---------------------------------------------------------------------------*/
+/* Register accesses and waits since the last mock_hw_reset_counters() */
+typedef struct mock_hw_counters {
+	uint32_t gpio_reads;
+	uint32_t gpio_writes;
+	uint32_t rtimer_reads;
+	uint32_t delay_calls;
+	uint32_t spi_bytes;
+} mock_hw_counters_t;
+/*---------------------------------------------------------------------------*/
+extern mock_hw_counters_t mock_hw_counters;
+/* Cost of one clock_delay_usec() call on top of the requested delay */
+extern uint32_t mock_delay_overhead_ns;
+/*---------------------------------------------------------------------------*/
+void mock_hw_reset(void);
+void mock_hw_reset_counters(void);
+uint64_t mock_hw_now_ns(void);
+void mock_hw_advance_ns(uint64_t ns);
+void mock_gpio_attach(int port, int pin, const mock_pin_model_t *model);
+void mock_spi_attach(int instance, int cs_port, int cs_pin, const mock_spi_model_t *model);
+/*---------------------------------------------------------------------------*/
+/* GPIO (dev/gpio.h), a port base is the port number here */
+#define GPIO_A_NUM                   0
+#define GPIO_B_NUM                   1
+#define GPIO_C_NUM                   2
+#define GPIO_D_NUM                   3
+#define GPIO_PORT_TO_BASE(PORT)      (PORT)
+#define GPIO_PIN_MASK(PIN)           (1 << (PIN))
+#define GPIO_SOFTWARE_CONTROL(PORT_BASE, PIN_MASK) do { } while(0)
+#define GPIO_SET_OUTPUT(PORT_BASE, PIN_MASK) mock_gpio_set_dir(PORT_BASE, PIN_MASK, 1)
+#define GPIO_SET_INPUT(PORT_BASE, PIN_MASK)  mock_gpio_set_dir(PORT_BASE, PIN_MASK, 0)
+#define GPIO_SET_PIN(PORT_BASE, PIN_MASK)    mock_gpio_write(PORT_BASE, PIN_MASK, 1)
+#define GPIO_CLR_PIN(PORT_BASE, PIN_MASK)    mock_gpio_write(PORT_BASE, PIN_MASK, 0)
+#define GPIO_READ_PIN(PORT_BASE, PIN_MASK)   mock_gpio_read(PORT_BASE, PIN_MASK)
+void mock_gpio_set_dir(int port, uint8_t mask, int output);
+void mock_gpio_write(int port, uint8_t mask, int level);
+uint8_t mock_gpio_read(int port, uint8_t mask);
+/*---------------------------------------------------------------------------*/
+/* IOC (dev/ioc.h) */
+#define IOC_OVERRIDE_OE              0x00000008
+#define IOC_OVERRIDE_PUE             0x00000004
+#define IOC_OVERRIDE_PDE             0x00000002
+#define IOC_OVERRIDE_ANA             0x00000001
+#define IOC_OVERRIDE_DIS             0x00000000
+void ioc_set_over(uint8_t port, uint8_t pin, uint8_t over);
+/*---------------------------------------------------------------------------*/
+/* Timers, the sleep timer runs at 32768 Hz on the cc2538 */
+typedef uint32_t rtimer_clock_t;
+#define RTIMER_SECOND                32768
+#define RTIMER_ARCH_SECOND           RTIMER_SECOND
+#define RTIMER_NOW()                 mock_rtimer_now()
+#define RTIMER_CLOCK_LT(a, b)        ((int32_t)((a) - (b)) < 0)
+#define CLOCK_SECOND                 128
+typedef uint32_t clock_time_t;
+rtimer_clock_t mock_rtimer_now(void);
+void clock_delay_usec(uint16_t dt);
+void watchdog_periodic(void);
+/*---------------------------------------------------------------------------*/
+/* SSI (spi-arch.h, dev/spi.h) */
+#define SSI_INSTANCE_COUNT           2
+#define SPIX_WAITFORTxREADY(spi)     do { } while(0)
+#define SPIX_BUF(spi)                (mock_spi_dr[spi])
+//the byte written to SPIX_BUF is shifted out once the driver waits for it
+#define SPIX_WAITFOREOTx(spi)        mock_spi_exchange(spi)
+#define SPIX_WAITFOREORx(spi)        do { } while(0)
+#define SPIX_CS_CLR(port, pin)       mock_spi_select(port, pin, 1)
+#define SPIX_CS_SET(port, pin)       mock_spi_select(port, pin, 0)
+extern uint32_t mock_spi_dr[SSI_INSTANCE_COUNT];
+void mock_spi_exchange(uint8_t spi);
+void mock_spi_select(int port, int pin, int selected);
+void spix_init(uint8_t spi);
+void spix_enable(uint8_t spi);
+void spix_disable(uint8_t spi);
+void spix_set_clock_freq(uint8_t spi, uint32_t freq);
+void spix_cs_init(uint8_t port, uint8_t pin);
+/*---------------------------------------------------------------------------*/
+/* Sensors API (lib/sensors.h) */
+#define SENSORS_HW_INIT              128
+#define SENSORS_ACTIVE               129
+#define SENSORS_READY                130
+struct sensors_sensor {
+	char *type;
+	int (*value)(int type);
+	int (*configure)(int type, int value);
+	int (*status)(int type);
+};
+#define SENSORS_SENSOR(name, type, value, configure, status) \
+	const struct sensors_sensor name = { type, value, configure, status }
+#define SENSORS_ACTIVATE(sensor)     (sensor).configure(SENSORS_ACTIVE, 1)
+#define SENSORS_DEACTIVATE(sensor)   (sensor).configure(SENSORS_ACTIVE, 0)
+/*---------------------------------------------------------------------------*/
+/* Zoul sensors (dev/zoul-sensors.h) */
+#define ZOUL_SENSORS_ERROR           0x7FFFFFFF
+/*---------------------------------------------------------------------------*/
+#endif /* MOCK_HW_H_ */
@@ -0,0 +1,2 @@
+/* Host stand-in, see mock-hw.h */
+#include "contiki.h"
@@ -0,0 +1,231 @@
+/* C std libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/* Project Sourcefiles */
+#include "sensor-models.h"
+/*---------------------------------------------------------------------------*/
+/* AM2302/DHT22 datasheet, typical values */
+const dht22_timing_t dht22_timing_datasheet = {
+	.response_delay = 20,
+	.response_low = 80,
+	.response_high = 80,
+	.bit_low = 50,
+	.zero_high = 26,
+	.one_high = 70,
+	.min_start_low = 1000,
+	.jitter_pct = 0,
+};
+/*---------------------------------------------------------------------------*/
+static uint32_t
+jitter_ns(uint32_t us, uint8_t pct)
+{
+	int32_t ns = us * 1000;
+
+	if (pct != 0)
+		ns += (int32_t)((int64_t)ns * ((rand() % (2 * pct + 1)) - pct) / 100);
+	return ns > 0 ? ns : 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_edge(dht22_model_t *model, uint32_t *t_ns, uint32_t after_ns, uint8_t level)
+{
+	*t_ns += after_ns;
+	if (model->edge_count == DHT22_MODEL_MAX_EDGES)
+		return;
+	model->edges[model->edge_count].t_ns = *t_ns;
+	model->edges[model->edge_count].level = level;
+	model->edge_count++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+reset_line(dht22_model_t *model)
+{
+	model->last_level = 1;
+	model->armed = 0;
+	model->start_pulses = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+dht22_model_from_bytes(dht22_model_t *model, const uint8_t *bytes,
+		const dht22_timing_t *timing)
+{
+	uint32_t t = 0;
+	uint8_t pct = timing->jitter_pct;
+
+	memset(model, 0, sizeof(dht22_model_t));
+	model->min_start_low_ns = timing->min_start_low * 1000;
+	reset_line(model);
+
+	add_edge(model, &t, jitter_ns(timing->response_delay, pct), 0);
+	add_edge(model, &t, jitter_ns(timing->response_low, pct), 1);
+	add_edge(model, &t, jitter_ns(timing->response_high, pct), 0);
+	for (int i = 0; i < 40; i++) {
+		uint8_t bit = (bytes[i / 8] >> (7 - (i % 8))) & 1;
+		add_edge(model, &t, jitter_ns(timing->bit_low, pct), 1);
+		add_edge(model, &t, jitter_ns(bit ? timing->one_high : timing->zero_high, pct), 0);
+	}
+	//end of frame, the sensor lets the line go
+	add_edge(model, &t, jitter_ns(timing->bit_low, pct), 1);
+}
+/*---------------------------------------------------------------------------*/
+void
+dht22_model_silent(dht22_model_t *model)
+{
+	memset(model, 0, sizeof(dht22_model_t));
+	model->min_start_low_ns = dht22_timing_datasheet.min_start_low * 1000;
+	reset_line(model);
+}
+/*---------------------------------------------------------------------------*/
+int
+dht22_model_load(dht22_model_t *model, const char *path)
+{
+	char line[128];
+	double t_us;
+	int level;
+	FILE *fp = fopen(path, "r");
+
+	if (fp == NULL)
+		return -1;
+	dht22_model_silent(model);
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		char *ptr = line + strspn(line, " \t");
+		if (*ptr == '#' || *ptr == '\n' || *ptr == '\0')
+			continue;
+		if (sscanf(ptr, "%lf %d", &t_us, &level) != 2 || t_us < 0 ||
+				model->edge_count == DHT22_MODEL_MAX_EDGES) {
+			fclose(fp);
+			return -1;
+		}
+		model->edges[model->edge_count].t_ns = (uint32_t)(t_us * 1000);
+		model->edges[model->edge_count].level = level != 0;
+		model->edge_count++;
+	}
+	fclose(fp);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+dht22_read(void *ctx, uint64_t now_ns)
+{
+	dht22_model_t *model = ctx;
+	uint64_t elapsed;
+	int level = 1;
+
+	if (!model->armed)
+		return 1;
+	elapsed = now_ns - model->release_ns;
+	for (int i = 0; i < model->edge_count && model->edges[i].t_ns <= elapsed; i++) {
+		level = model->edges[i].level;
+	}
+	return level;
+}
+/*---------------------------------------------------------------------------*/
+static void
+dht22_drive(void *ctx, int level, uint64_t now_ns)
+{
+	dht22_model_t *model = ctx;
+
+	if (!level && model->last_level) {
+		//any low from the host aborts a transfer in progress
+		model->armed = 0;
+		model->start_low_ns = now_ns;
+	} else if (level && !model->last_level &&
+			now_ns - model->start_low_ns >= model->min_start_low_ns) {
+		model->armed = 1;
+		model->release_ns = now_ns;
+		model->start_pulses++;
+	}
+	model->last_level = level;
+}
+/*---------------------------------------------------------------------------*/
+const mock_pin_model_t dht22_pin_model = { dht22_read, dht22_drive, NULL };
+/*---------------------------------------------------------------------------*/
+void
+adc128s022_model_init(adc128s022_model_t *model)
+{
+	memset(model, 0, sizeof(adc128s022_model_t));
+}
+/*---------------------------------------------------------------------------*/
+static void
+adc128s022_select(void *ctx, int selected, uint64_t now_ns)
+{
+	adc128s022_model_t *model = ctx;
+
+	model->byte_index = 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+* 16 clock frame: DIN carries the address of the channel for the NEXT frame in
+* the first byte, DOUT carries 4 zeros and the 12 bit result of the channel
+* addressed in the previous frame, tracked at the start of this frame. Frames
+* follow each other while the chip stays selected.
+*/
+static uint8_t
+adc128s022_transfer(void *ctx, uint8_t tx, uint64_t now_ns)
+{
+	adc128s022_model_t *model = ctx;
+	uint8_t ch;
+
+	switch (model->byte_index++ % 2) {
+	case 0:
+		model->frames++;
+		ch = model->next_channel;
+		model->result = model->input[ch] != NULL ?
+				model->input[ch](model->input_ctx[ch], now_ns) : model->codes[ch];
+		model->result &= 0x0FFF;
+		model->next_channel = (tx >> 3) & 0x07;
+		return (model->result >> 8) & 0x0F;
+	case 1:
+		return model->result & 0xFF;
+	default:
+		return 0;
+	}
+}
+/*---------------------------------------------------------------------------*/
+const mock_spi_model_t adc128s022_spi_model = { adc128s022_select, adc128s022_transfer, NULL };
+/*---------------------------------------------------------------------------*/
+void
+pm25_model_init(pm25_model_t *model, uint32_t output_mv)
+{
+	memset(model, 0, sizeof(pm25_model_t));
+	model->output_mv = output_mv;
+	model->rise_us = 280;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+pm25_model_adc_input(void *ctx, uint64_t sample_ns)
+{
+	pm25_model_t *model = ctx;
+	uint64_t elapsed_ns, mv_x1000;
+
+	if (!model->led_on)
+		return 0;
+	elapsed_ns = sample_ns - model->led_on_ns;
+	model->sample_delay_ns = (uint32_t)elapsed_ns;
+	//output ramps up while the LED pulse settles
+	if (elapsed_ns >= model->rise_us * 1000ULL)
+		mv_x1000 = model->output_mv * 1000ULL;
+	else
+		mv_x1000 = model->output_mv * elapsed_ns / model->rise_us;
+	//5 V reference, 12 bits, rounded
+	return (uint16_t)((mv_x1000 * 4095 / 5000 + 500) / 1000);
+}
+/*---------------------------------------------------------------------------*/
+static void
+pm25_drive(void *ctx, int level, uint64_t now_ns)
+{
+	pm25_model_t *model = ctx;
+
+	//active low IR LED
+	if (!level && !model->led_on) {
+		model->led_on = 1;
+		model->led_on_ns = now_ns;
+	} else if (level && model->led_on) {
+		model->led_on = 0;
+		model->pulse_ns = (uint32_t)(now_ns - model->led_on_ns);
+	}
+}
+/*---------------------------------------------------------------------------*/
+const mock_pin_model_t pm25_led_pin_model = { NULL, pm25_drive, NULL };
+/*---------------------------------------------------------------------------*/
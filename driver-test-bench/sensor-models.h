@@ -0,0 +1,82 @@
+#ifndef SENSOR_MODELS_H_
+#define SENSOR_MODELS_H_
+/*---------------------------------------------------------------------------*/
+/* Device models driven by the mock registers, see mock/mock-hw.h */
+/*---------------------------------------------------------------------------*/
+#include "mock-hw.h"
+/*---------------------------------------------------------------------------*/
+#define DHT22_MODEL_MAX_EDGES        128
+#define ADC128S022_MODEL_CHANNELS    8
+/*---------------------------------------------------------------------------*/
+/* DHT22 single-wire timing, in us (datasheet typical values by default) */
+typedef struct dht22_timing {
+	uint32_t response_delay;  //host release to sensor pulling the line low
+	uint32_t response_low;
+	uint32_t response_high;
+	uint32_t bit_low;
+	uint32_t zero_high;
+	uint32_t one_high;
+	uint32_t min_start_low;   //shorter start signals are ignored
+	uint8_t jitter_pct;       //random +/- on every duration
+} dht22_timing_t;
+/*---------------------------------------------------------------------------*/
+typedef struct dht22_edge {
+	uint32_t t_ns;            //since the host released the line
+	uint8_t level;
+} dht22_edge_t;
+/*---------------------------------------------------------------------------*/
+typedef struct dht22_model {
+	dht22_edge_t edges[DHT22_MODEL_MAX_EDGES];
+	int edge_count;
+	uint32_t min_start_low_ns;
+	//line state as seen by the sensor
+	uint8_t last_level;
+	uint8_t armed;
+	uint64_t start_low_ns;
+	uint64_t release_ns;
+	uint32_t start_pulses;    //start signals accepted
+} dht22_model_t;
+/*---------------------------------------------------------------------------*/
+typedef struct adc128s022_model {
+	uint16_t codes[ADC128S022_MODEL_CHANNELS];
+	//analog input that depends on when it is sampled, overrides codes[]
+	uint16_t (*input[ADC128S022_MODEL_CHANNELS])(void *ctx, uint64_t sample_ns);
+	void *input_ctx[ADC128S022_MODEL_CHANNELS];
+	//channel addressed in the previous frame, sampled in the current one
+	uint8_t next_channel;
+	uint8_t byte_index;
+	uint16_t result;
+	uint32_t frames;
+} adc128s022_model_t;
+/*---------------------------------------------------------------------------*/
+typedef struct pm25_model {
+	uint32_t output_mv;       //output once the IR LED pulse has settled
+	uint32_t rise_us;         //LED on to settled output
+	uint8_t led_on;
+	uint64_t led_on_ns;
+	uint32_t pulse_ns;        //last LED pulse width
+	uint32_t sample_delay_ns; //last LED on to ADC sample
+} pm25_model_t;
+/*---------------------------------------------------------------------------*/
+extern const dht22_timing_t dht22_timing_datasheet;
+extern const mock_pin_model_t dht22_pin_model;
+extern const mock_spi_model_t adc128s022_spi_model;
+extern const mock_pin_model_t pm25_led_pin_model;
+/*---------------------------------------------------------------------------*/
+/* Waveform for the 5 data bytes (humidity hi/lo, temperature hi/lo, checksum) */
+void dht22_model_from_bytes(dht22_model_t *model, const uint8_t *bytes,
+		const dht22_timing_t *timing);
+/* A sensor that never answers the start signal */
+void dht22_model_silent(dht22_model_t *model);
+/* Recorded edges, one "<us since release> <level>" per line, '#' comments.
+ * @returns: 0 on success, -1 if the file cannot be read or is malformed
+ */
+int dht22_model_load(dht22_model_t *model, const char *path);
+/*---------------------------------------------------------------------------*/
+void adc128s022_model_init(adc128s022_model_t *model);
+/*---------------------------------------------------------------------------*/
+void pm25_model_init(pm25_model_t *model, uint32_t output_mv);
+/* ADC input hook, connect with adc128s022_model_t.input */
+uint16_t pm25_model_adc_input(void *ctx, uint64_t sample_ns);
+/*---------------------------------------------------------------------------*/
+#endif /* SENSOR_MODELS_H_ */
@@ -28,10 +28,12 @@
 static int8_t enabled = 0;
 static uint8_t used_channels = 0;
 /*------------------------------------------------------------------*/
-static uint16_t sample(uint8_t channel){
+/* One 16 clock frame while the chip is selected: addresses the channel
+ * converted in the NEXT frame and returns the conversion of the channel
+ * addressed in the previous frame
+ * */
+static uint16_t frame(uint8_t channel){
 	uint8_t hi_byte, low_byte;
-	// initiate a transaction
-	SPIX_CS_CLR(ADC128S022_CSN_PORT, ADC128S022_CSN_PIN);
 
 	/* transmit the data (channel to sample)
 	 * refer to data sheet, only 3 of the 8 data bits are important, the rest are don't cares
@@ -62,31 +64,45 @@ static uint16_t sample(uint8_t channel){
 	SPIX_WAITFOREORx(ADC128S022_SPI_INSTANCE);
 	low_byte = SPIX_BUF(ADC128S022_SPI_INSTANCE);
 
-	//end transaction
-	SPIX_CS_SET(ADC128S022_CSN_PORT, ADC128S022_CSN_PIN);
-
 	//return 12 ENOB adc value
 	return (hi_byte << 8) | low_byte;
 }
 /*------------------------------------------------------------------*/
-static int value(int type){
-	uint8_t sample_count = 2;
-	uint16_t sample_value = 0;
+static uint16_t sample(uint8_t channel){
+	uint16_t sample_value;
+	// initiate a transaction
+	SPIX_CS_CLR(ADC128S022_CSN_PORT, ADC128S022_CSN_PIN);
+	sample_value = frame(channel);
+	//end transaction
+	SPIX_CS_SET(ADC128S022_CSN_PORT, ADC128S022_CSN_PIN);
+	return sample_value;
+}
+/*------------------------------------------------------------------*/
+static int check_channel(int channel, const char *caller){
 	if (!enabled) {
-		PRINTF("ADC128S022: value - sensor is not enabled.\n");
+		PRINTF("ADC128S022: %s - sensor is not enabled.\n", caller);
 		return ADC128S022_ERROR;
 	}
-	if (type > 7 || type < 0) {
-		PRINTF("ADC128S022: value - type (channel) must be between 0 and 7.\n");
+	if (channel > 7 || channel < 0) {
+		PRINTF("ADC128S022: %s - type (channel) must be between 0 and 7.\n", caller);
 		return ADC128S022_ERROR;
 	}
-	if (!(used_channels & (1 << type))) {
-		PRINTF("ADC128S022: value - type (channel) is not initialized.\n");
+	if (!(used_channels & (1 << channel))) {
+		PRINTF("ADC128S022: %s - type (channel) is not initialized.\n", caller);
 		return ADC128S022_ERROR;
 	}
-	/* TODO: try to find a way to sample only once
-	 * For some reason, the adc read value is only reliable on second sample, thus requiring a re-sampling
-	 * for each sample taken.
+	return ADC128S022_SUCCESS;
+}
+/*------------------------------------------------------------------*/
+static int value(int type){
+	uint8_t sample_count = 2;
+	uint16_t sample_value = 0;
+	if (check_channel(type, "value") == ADC128S022_ERROR) {
+		return ADC128S022_ERROR;
+	}
+	/* The first frame returns the conversion of the channel addressed before,
+	 * the second one the requested channel. Use adc128s022_read_burst to
+	 * read several channels without the extra frame for each.
 	 * */
 
 	while (sample_count != 0) {
@@ -97,6 +113,27 @@ static int value(int type){
 	return sample_value;
 }
 /*------------------------------------------------------------------*/
+int adc128s022_read_burst(const uint8_t *channels, uint8_t count, uint16_t *values){
+	uint8_t i;
+	for (i = 0; i < count; i++) {
+		if (check_channel(channels[i], "read_burst") == ADC128S022_ERROR) {
+			return ADC128S022_ERROR;
+		}
+	}
+	if (count == 0) {
+		return ADC128S022_SUCCESS;
+	}
+	SPIX_CS_CLR(ADC128S022_CSN_PORT, ADC128S022_CSN_PIN);
+	//each frame addresses the next channel and returns the previous one,
+	//the last frame only clocks out the conversion of the last channel
+	frame(channels[0]);
+	for (i = 1; i <= count; i++) {
+		values[i - 1] = frame(i < count ? channels[i] : channels[0]);
+	}
+	SPIX_CS_SET(ADC128S022_CSN_PORT, ADC128S022_CSN_PIN);
+	return ADC128S022_SUCCESS;
+}
+/*------------------------------------------------------------------*/
 static int configure(int type, int value){
 	switch(type){
 	case ADC128S022_INIT:
@@ -48,4 +48,10 @@
 #define ADC128S022_NAME "ADC128S022 12-bit ADC"
 extern const struct sensors_sensor adc128s022;
 /*------------------------------------------------------------------*/
+/* Reads count channels in one transaction into values, in the order given.
+ * Takes count + 1 frames, where count adc128s022.value() calls take 2 x count.
+ * Returns ADC128S022_ERROR if the chip or a channel is not enabled.
+ */
+int adc128s022_read_burst(const uint8_t *channels, uint8_t count, uint16_t *values);
+/*------------------------------------------------------------------*/
 #endif /* PLATFORM_ZOUL_DEV_ADC128S022_H_ */
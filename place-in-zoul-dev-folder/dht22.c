@@ -167,13 +167,17 @@ dht22_humidity(void)
   return res;
 }
 /*---------------------------------------------------------------------------*/
-static uint16_t
+static int16_t
 dht22_temperature(void)
 {
-  uint16_t res;
+  int16_t res;
   res = dht22_data[2] & 0x7F;
   res *= 256;
   res += dht22_data[3];
+  /* Bit 7 of the high byte is the sign, the rest is the magnitude */
+  if(dht22_data[2] & 0x80) {
+    res = -res;
+  }
   busy = 0;
   return res;
 }
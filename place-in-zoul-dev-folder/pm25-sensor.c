@@ -111,7 +111,8 @@ value(int type)
 #endif
 	PRINTF("PM25-Sensor: mv adc value: %lu.%lu\n", val / 10, val % 10);
 	//watch out for out of spec values, also consider precision of val
-	if      ( (val % 10 > 4 ? val / 10 + 1 : val / 10) < PM25_MIN_OUTPUT_MILLIVOLT){
+	//no rounding on the low side, (val - min) below must not wrap around
+	if      ( val < PM25_MIN_OUTPUT_MILLIVOLT * 10 ){
 		PRINTF("WARNING @PM25_SENSOR: output value is not within specifications of sensor. ");
 		PRINTF("Minimum value set.\n");
 		val = PM25_MIN_OUTPUT_MICRODUST;